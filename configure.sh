@@ -124,6 +124,15 @@ else
 fi
 
 AC_CHECK_HEADERS errno.h
+
+# the file selector can avoid stat()ing every directory entry
+AC_CHECK_FIELD dirent d_type sys/types.h dirent.h
+AC_CHECK_FUNCS fstatat
+AC_CHECK_FUNCS dirfd
+# ... and notice when the directories it remembers change
+AC_CHECK_HEADERS sys/inotify.h
+# ... and sort big directories on more than one cpu
+AC_CHECK_HEADERS pthread.h && AC_LIBRARY pthread_create -lpthread
 MF_PATH_INCLUDE RANLIB ranlib true || AC_CONFIG RANLIB ':'
 
 AC_OUTPUT Makefile src/Makefile src/curse.h dialog/Makefile
@@ -12,9 +12,11 @@
 #include <sys/stat.h>
 #include <sys/mman.h>
 #include <errno.h>
+#include <poll.h>
 
 
-enum boxtypes { YESNO=1, MSG, INPUT, INFO, TEXT, LIST, CHECK, RADIO };
+enum boxtypes { YESNO=1, MSG, INPUT, INFO, TEXT, TAIL, LIST, CHECK, RADIO,
+		GAUGE };
 
 struct x_option opts[] = {
     { 'c',   0, "clear",   0,       0 },
@@ -26,9 +28,11 @@ struct x_option opts[] = {
     { INFO,  0, "infobox", 0,       "text height width" },
     { INPUT, 0, "inputbox",0,       "text height width [initial-string]" },
     { TEXT,  0, "textbox", 0,       "file height width" },
+    { TAIL,  0, "tailbox", 0,       "file height width" },
     { LIST,  0, "menu",    0,       "text height width menu-height [tag item] ..." },
     { CHECK, 0, "checklist",0,      "text height width list-height [tag item status] ..." },
     { RADIO, 0, "radiolist",0,      "text height width list-height [tag item status] ..." },
+    { GAUGE, 0, "gauge",   0,       "text height width [percent]" },
     
 };
 
@@ -44,6 +48,8 @@ struct box {
 
 struct box *boxes = 0;
 int nrboxes = 0;
+
+int input = -1;		/* what --textbox - reads (stdin is the tty) */
     
 char *title = 0;
 
@@ -124,7 +130,8 @@ add_box(enum boxtypes boxtype, int argc, char **argv)
     case YESNO:
     case MSG:
     case INFO:
-    case TEXT:	/* all need 3 more arguments */
+    case TEXT:
+    case TAIL:	/* all need 3 more arguments */
 		if ( count != 3 ) {
 		    fprintf(stderr, "usage; dialog --%s arg height width\n",
 					whatis(boxtype));
@@ -153,6 +160,25 @@ add_box(enum boxtypes boxtype, int argc, char **argv)
 		    boxes[nrboxes].data[0] = argv[x_optind++];
 		}
 		break;
+    case GAUGE:
+		if ( count < 3 || count > 4 ) {
+		    fprintf(stderr, "usage: dialog --gauge text height width [percent]\n");
+		    exit(1);
+		}
+		boxes[nrboxes].text = argv[x_optind++];
+		boxes[nrboxes].height = box_atoi(argv[x_optind++], 4);
+		boxes[nrboxes].width = box_atoi(argv[x_optind++], 8);
+		if ( count == 4 ) {
+		    boxes[nrboxes].nrdata = 1;
+		    boxes[nrboxes].data = malloc(sizeof (char**) );
+		    if ( boxes[nrboxes].data == 0 ) {
+			fprintf(stderr, "dialog: %s allocating percentage\n",
+					strerror(errno));
+			exit(1);
+		    }
+		    boxes[nrboxes].data[0] = argv[x_optind++];
+		}
+		break;
     case LIST:
 		if ( (count < 5) || (count % 2 == 0) ) {
 		    /* need at least 5 arguments, and #args must be odd
@@ -224,31 +250,241 @@ scrollable_box(struct box *box, char *data, off_t size)
 }
 
 
+/*
+ * stream_box() shows what comes in on fd (what was stdin, or a pipe) as
+ * it arrives
+ */
+int
+stream_box(struct box *box, int fd)
+{
+    void *chain, *text;
+    char *name = strcmp(box->text, "-") ? box->text : "(stdin)";
+    int rc;
+
+    text = newStreamText(0,0,box->width,box->height,fd,0,0,0,0,0);
+    if ( text == 0 ) {
+	if ( fd != -1 )
+	    close(fd);
+	return -1;
+    }
+    /* (the text box closes fd) */
+
+    chain = ObjChain(newOKButton(1,"OK",0, 0), text);
+    chain = ObjChain(chain,
+		     newCancelButton(2,"CANCEL", 0, 0));
+
+    rc = MENU(chain, -1, -1, title ? title : name, 0, 0);
+    deleteObjChain(chain);
+    return rc;
+}
+
+
 int
 text_box(struct box *box)
 {
-    int fd = open(box->text, O_RDONLY);
+    int fd;
     struct stat finfo;
     char  *fdata;
-    int rc = -1;
+    int rc;
 
-    if ( fd == -1 )
+    if ( strcmp(box->text, "-") == 0 ) {
+	/* only the first --textbox - gets stdin */
+	fd = input;
+	input = -1;
+	return stream_box(box, fd);
+    }
+
+    if ( (fd = open(box->text, O_RDONLY)) == -1 )
 	return -1;
 
-    /* can't do a text box if we can't stat it or it's not a regular
-     * file, because we mmap() the file into our address space
+    /* a regular file is mmap()ed into our address space;  anything else
+     * (a named pipe, a device), or a file that can't be mapped (it's
+     * empty, or it's too big for our address space) is read as it comes
      */
-    if ( fstat(fd, &finfo) == 0 && S_ISREG(finfo.st_mode) ) {
-	if ( (fdata = mmap(0, finfo.st_size, PROT_READ, MAP_SHARED, fd, 0)) ) {
-	    rc = scrollable_box(box, fdata, finfo.st_size);
-	    munmap(fdata, finfo.st_size);
-	}
+    if ( fstat(fd, &finfo) != 0 ) {
+	close(fd);
+	return -1;
     }
+    if ( !S_ISREG(finfo.st_mode) || finfo.st_size < 1 )
+	return stream_box(box, fd);
+
+    fdata = mmap(0, finfo.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    if ( fdata == MAP_FAILED )
+	return stream_box(box, fd);
+
+    rc = scrollable_box(box, fdata, finfo.st_size);
+    munmap(fdata, finfo.st_size);
     close(fd);
     return rc;
 }
 
 
+/*
+ * tail_box() shows the end of a file, and keeps showing the end of it
+ * as it grows
+ */
+int
+tail_box(struct box *box)
+{
+    void *chain, *text;
+    int rc;
+
+    text = newTailText(0,0,box->width,box->height,box->text,0,0,0,0,0);
+    if ( text == 0 )
+	return -1;
+
+    chain = ObjChain(newOKButton(1,"OK",0, 0), text);
+    chain = ObjChain(chain,
+		     newCancelButton(2,"CANCEL", 0, 0));
+
+    rc = MENU(chain, -1, -1, title ? title : box->text, 0, 0);
+    deleteObjChain(chain);
+    return rc;
+}
+
+
+/* how long (in milliseconds) to wait for more input before painting
+ * a gauge update that updateGauge() held back
+ */
+#define GAUGE_POLL	50
+
+static char inbuf[4096];
+static int inlen = 0;
+static int used = 0;
+
+/*
+ * nextline() reads a line from stdin for a gauge.   If wait isn't -1,
+ * it only waits that many milliseconds for the line to show up.  It
+ * returns 1 if it got a line, 0 if it timed out, and -1 at end of file.
+ */
+int
+nextline(char **line, int wait)
+{
+    struct pollfd pfd;
+    char *nl;
+    int size;
+
+    if ( used ) {
+	memmove(inbuf, inbuf+used, inlen-used);
+	inlen -= used;
+	used = 0;
+    }
+
+    while (1) {
+	if ( (nl = memchr(inbuf, '\n', inlen)) ) {
+	    *nl = 0;
+	    used = 1 + (nl - inbuf);
+	    *line = inbuf;
+	    return 1;
+	}
+	if ( inlen == sizeof inbuf - 1 ) {
+	    /* line is too long; take what we've got */
+	    inbuf[inlen] = 0;
+	    used = inlen;
+	    *line = inbuf;
+	    return 1;
+	}
+	if ( wait >= 0 ) {
+	    pfd.fd = 0;
+	    pfd.events = POLLIN;
+	    if ( poll(&pfd, 1, wait) <= 0 )
+		return 0;
+	}
+	size = read(0, inbuf+inlen, sizeof inbuf - 1 - inlen);
+	if ( size <= 0 ) {
+	    if ( inlen == 0 )
+		return -1;
+	    inbuf[inlen] = 0;
+	    used = inlen;
+	    *line = inbuf;
+	    return 1;
+	}
+	inlen += size;
+    }
+}
+
+
+/*
+ * gauge_box() puts up a gauge and feeds it from stdin.  Each line is
+ * either a new percentage, or the start of a
+ *
+ *	XXX
+ *	percentage
+ *	message
+ *	...
+ *	XXX
+ *
+ * block, which sets both the percentage and the text above the gauge.
+ */
+int
+gauge_box(struct box *box)
+{
+    ndGauge gauge;
+    char *line;
+    char *msg = 0;
+    int msglen = 0, msgsize = 0;
+    int percent = box->nrdata ? atoi(box->data[0]) : 0;
+    int width = box->width - 4;
+    int inmsg = 0;
+    int pending = 0;
+    int size, rc;
+
+    if ( width > COLS-8 )
+	width = COLS-8;
+
+    gauge = openGauge(title, box->text, box->height - 3, width);
+    if ( gauge == 0 )
+	return -1;
+    updateGauge(gauge, percent, 0);
+    flushGauge(gauge);
+
+    while ( (rc = nextline(&line, pending ? GAUGE_POLL : -1)) >= 0 ) {
+	if ( rc == 0 ) {
+	    flushGauge(gauge);
+	    pending = 0;
+	}
+	else if ( strcmp(line, "XXX") == 0 ) {
+	    if ( inmsg ) {
+		if ( msglen > 0 )
+		    msg[--msglen] = 0;	/* trailing newline */
+		pending = updateGauge(gauge, percent, msg ? msg : "");
+		inmsg = 0;
+	    }
+	    else {
+		inmsg = 1;
+		msglen = 0;
+	    }
+	}
+	else if ( inmsg == 1 ) {
+	    /* the first line of a message block is the percentage */
+	    percent = atoi(line);
+	    inmsg = 2;
+	}
+	else if ( inmsg ) {
+	    size = strlen(line);
+	    if ( msglen + size + 2 > msgsize ) {
+		msgsize = msglen + size + 80;
+		if ( (msg = realloc(msg, msgsize)) == 0 ) {
+		    closeGauge(gauge);
+		    return -1;
+		}
+	    }
+	    strcpy(msg+msglen, line);
+	    msglen += size;
+	    msg[msglen++] = '\n';
+	    msg[msglen] = 0;
+	}
+	else
+	    pending = updateGauge(gauge, atoi(line), 0);
+    }
+    flushGauge(gauge);
+    closeGauge(gauge);
+    if ( msg )
+	free(msg);
+    return 0;
+}
+
+
 int
 handle_box(struct box *box)
 {
@@ -267,6 +503,10 @@ handle_box(struct box *box)
 		return dialog_msgbox(title, box->text, box->height, box->width, 0);
     case TEXT:
 		return text_box(box);
+    case TAIL:
+		return tail_box(box);
+    case GAUGE:
+		return gauge_box(box);
 
     case INPUT:
 		size = 80;
@@ -339,7 +579,7 @@ char **argv;
     char *bottomtitle = 0;
     char *helpfile = 0;
     char *cl = 0, *term, *bfr = alloca(5120);
-    int i, rc, opt;
+    int i, rc, opt, tty;
 
     x_opterr = 1;
     
@@ -358,8 +598,10 @@ char **argv;
 	case INPUT:
 	case INFO:
 	case TEXT:
+	case TAIL:
 	case LIST:
 	case RADIO:
+	case GAUGE:
 	case CHECK: add_box(opt, argc, argv);
 		    break;
 	
@@ -373,6 +615,21 @@ char **argv;
     if ( toclear && (tgetent(bfr, getenv("TERM")) == 1) )
 	cl = tgetstr("cl", &bfr);
 
+    /* --textbox - reads from stdin, so the keyboard has to come from
+     * somewhere else
+     */
+    for ( i = 0; i < nrboxes; i++ )
+	if ( boxes[i].boxtype == TEXT && strcmp(boxes[i].text, "-") == 0 ) {
+	    if ( (input = dup(0)) == -1 || (tty = open("/dev/tty", O_RDWR)) == -1
+				       || dup2(tty, 0) == -1 ) {
+		fprintf(stderr, "dialog: can't read the keyboard: %s\n",
+				strerror(errno));
+		exit(1);
+	    }
+	    close(tty);
+	    break;
+	}
+
     if ( nrboxes > 0 ) {
 	init_dialog();
 
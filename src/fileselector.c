@@ -4,123 +4,1582 @@
  * be distributed with this source code.
  */
 /*
- * need to abstract this into a general-purpose selector box.
+ * fileselector.c: file selector widget (W_FILESEL)
  *
- * I need to pass (a) directory open/read/close routines [for
- * file selection via nfs] (b) flags to tell it whether to
- * 1) allow the user to CD up past the topdir, 2) allow the
- * user to select files (not just directories), 3) allow the
- * user to edit the pattern, 4) return without checking that
- * everything is okay.
+ * A file selector is a selection string with a directory list and a
+ * file list side-by-side below it.  The directories come from a
+ * directory provider (the filesystem, unless it's given something
+ * else), and everything it knows lives in the widget, so there can be
+ * more than one of them at a time.
  *
- * It also needs to be made reentrant, via hackery to the
- * internals of ndialog.
+ * It still needs flags to tell it whether to 1) allow the user to CD
+ * up past the topdir, 2) allow the user to select files (not just
+ * directories), 3) allow the user to edit the pattern, 4) return
+ * without checking that everything is okay.
  */
 #include <config.h>
 
-#include <dialog.h>
-#include <ndialog.h>
+#include "nd_objects.h"
+#include "curse.h"
+#include "dialog.h"
+#include "ndwin.h"
+#include "fileselector.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <fcntl.h>
 #include <unistd.h>
 #include <dirent.h>
+#include <ctype.h>
 #include <errno.h>
 #include <regex.h>
 #include <string.h>
+#include <sys/time.h>
+#include <time.h>
+#if HAVE_SYS_INOTIFY_H
+#include <sys/inotify.h>
+#endif
+#if HAVE_PTHREAD_H && HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
 
-/*
- * the selector is a pseudo-widget that fileselector() uses to keep
- * all the internal context it cares about
+
+#if DYNAMIC_BINDING
+
+#define DYN_STATIC	static
+
+DYN_STATIC void drawFileSelector(void *o, void *w);
+DYN_STATIC void deleteFileSelector(ndObject o);
+DYN_STATIC editCode editFileSelector(void* o, void* w, MEVENT *mev, editCode cc);
+DYN_STATIC editCode startFileSelector(void* o, void* w, MEVENT *mev, editCode cc);
+DYN_STATIC editCode keyFileSelector(void* o, void* w, int c);
+
+static int fileselType = O_ERROR;
+#define W_FILESEL	fileselType
+
+#else
+
+#Error "This widget won't work unless DYNAMIC_BINDING is set"
+
+#endif
+
+/* Directories are read a slice at a time from a form timer, so a huge
+ * (or slow) directory doesn't stop the selector from drawing or taking
+ * keys while it's being read.
+ */
+#define FS_SLICE	20	/* msec to spend reading before looking up */
+#define FS_CHECK	64	/* entries to read between looks at the clock */
+
+/* The last few directories that were shown are kept around, so going
+ * back up or into a directory we've just been in doesn't mean reading
+ * it all over again.  A remembered directory is thrown away when the
+ * provider says it's changed.
+ */
+#define FS_CACHE	8	/* directories to remember */
+#define FS_RECHECK	1000	/* msec between looks for changes */
+
+#define FS_PATHMAX	1024	/* how long a selection can be */
+
+/* Listings are sorted by comparing keys made once for each entry (by
+ * strxfrm() for names, or an encoding that makes runs of digits compare
+ * as numbers) instead of calling strcoll() for every comparison.  Each
+ * slice of a directory is merge sorted by itself and then merged into
+ * what's already been sorted, so the lists are always in order while a
+ * directory is being read, and changing the order doesn't mean reading
+ * the directory again.  When there are spare cpus, runs bigger than
+ * FS_PARALLEL are split between threads (the entries and the keys
+ * are only read while they're being sorted, and every thread gets its
+ * own part of the merge buffer) and the halves are merged at the end.
+ */
+#define FS_PARALLEL	65536	/* smallest run worth a thread */
+
+typedef struct {
+    ListItem item;		/* the entry, as it's shown */
+    int key;			/* where its sort key is in keys[] */
+    int stated;			/* we've asked the provider for ... */
+    off_t size;			/* ... its size */
+    time_t mtime;		/* ... and mtime */
+} Entry;
+
+typedef struct {
+    LIA names;			/* the names as they're read */
+    Entry *ent;			/* the sorted entries */
+    int count;			/* ... how many have been sorted */
+    int alloc;
+    char *keys;			/* their sort keys, end to end */
+    int nrkeys;
+    int szkeys;
+    int natural;		/* the keys are natural keys */
+    int order;			/* the order they're sorted in */
+} Column;
+
+typedef struct {
+    char *path;			/* the directory */
+    Column directories;		/* its subdirectories (incl ..) */
+    Column files;		/* the files in it that match the pattern */
+    int complete;		/* it's all been read */
+    void *watch;		/* the provider's watch on it */
+    int used;			/* when it was last shown */
+} Listing;
+
+/* In find mode the selection string is a query, and the file list shows
+ * the files anywhere under the current directory that fuzzy match it,
+ * best first.  The tree is walked breadth first, a slice at a time from
+ * a form timer like a directory is read, so shallow files show up first
+ * and the matches come in while the user is still typing.  Every file
+ * the pattern lets through is kept as a candidate, and the matcher only
+ * looks at the candidates found since the last time it looked (or, if
+ * the query just got longer, at the ones that matched last time.)
+ *
+ * The names of the candidates (and of the directories still waiting to
+ * be read) are kept in blocks that never move, and the walk stops when
+ * it runs out of blocks, so a huge tree can't eat all the memory there
+ * is.
  */
-static struct {
+#define FS_BLOCK	65536	/* bytes of names in a block */
+#define FS_BLOCKS	256	/* the most blocks a walk can use */
+#define FS_DEPTH	32	/* how deep a walk goes */
+#define FS_SHOW		2000	/* how many matches go into the file list */
+
+typedef struct _fblock {
+    struct _fblock *next;
+    int used;
+    char text[FS_BLOCK];
+} Fblock;
+
+typedef struct {
+    int cand;			/* which candidate matched */
+    int score;			/* ... and how well */
+} Match;
+
+typedef struct {
+    char *root;			/* where the walk started */
+    char **queue;		/* directories waiting to be read */
+    int head, tail;
+    int szqueue;
+    void *dir;			/* the directory being read */
+    char *dirpath;		/* ... and where it is under root */
+    Fblock *blocks;		/* names of candidates and queued directories */
+    int nrblocks;
+    int full;			/* we ran out of blocks */
+    char **cand;		/* the files found so far */
+    int nrcand;
+    int szcand;
+    int scored;			/* ... how many the matcher has looked at */
+    Match *match;		/* the candidates that match the query */
+    int nrmatch;
+    int szmatch;
+    int sorted;			/* ... how many of them are in order */
+    char query[FS_PATHMAX];	/* what they were matched against */
+    ListItem *items;		/* the best matches, for the file list */
+    int timer;			/* the timer walking the tree, or -1 */
+    char *path;			/* scratch space for building paths */
+    int szpath;
+} Finder;
+
+/* our generic object class */
+typedef struct {
+    Obj *self;			/* the widget */
+    Obj *selection;		/* the selection string */
+    Obj *dirlist;		/* ... the directory list */
+    Obj *filelist;		/* ... and the file list */
+    int which;			/* 0=selection, 1=dirlist, 2=filelist */
+    pfo callback;		/* user-supplied callback */
+    ndDirProvider *provider;	/* where directories come from */
+    void *ctx;			/* ... and what to pass it */
+    int ownctx;			/* ctx is our own filesystem context */
     char *curdir;		/* current directory */
     int szcurdir;
-    char *pattern;		/* pattern to match files against */
-    LIA directories;		/* directories in current dir (incl ..) */
-    LIA files;			/* files in current dir */
-    ndObject selection;		/* point at the selection object */
-    ndObject dirlist;		/* ... the directory list */
-    ndObject filelist;		/* ... and the file list */
-    char result[1024];
-} selector;
+    regex_t re;			/* pattern to match files against */
+    int compiled;		/* ... if it would compile */
+    int sort;			/* how the lists are sorted */
+    char result[FS_PATHMAX];
+    void *dir;			/* the directory we're reading, if any */
+    ndForm form;		/* the form the selector is on */
+    int timer;			/* the timer reading it, or -1 */
+    int watcher;		/* the timer looking for changes, or -1 */
+    Listing cache[FS_CACHE];	/* the directories we remember */
+    Listing *shown;		/* ... the one that's showing */
+    int clock;			/* ... and when it was shown */
+    Finder *find;		/* what we've found, in find mode */
+} Selector;
+
+#define FS(o)	((Selector*)(OBJ(o)->item.generic))
 
 
 /*
- * populateSelector() fills the dirlist and filelist with
- *                    directory entries.
+ * The filesystem provider reads directories with opendir() and
+ * readdir(), and watches them with inotify if it can, or by looking
+ * at their mtimes if it can't.
  */
-static void
-populateSelector(ndDisplay display)
+typedef struct _pwatch {
+    struct _pwatch *next;
+    char *path;			/* the directory */
+    int wd;			/* its inotify watch, or -1 */
+    int stale;			/* inotify says it's changed */
+    time_t mtime;		/* its mtime when we started watching it */
+    time_t scanned;		/* when we started watching it */
+} Pwatch;
+
+typedef struct {
+    int ifd;			/* inotify descriptor, or -1 */
+    Pwatch *watches;		/* the directories being watched */
+    char *path;			/* scratch space for stat()ing entries */
+    int szpath;
+} Posix;
+
+typedef struct {
+    DIR *dir;
+    char *path;
+} Pdir;
+
+#if HAVE_SYS_INOTIFY_H
+#define FS_EVENTS	(IN_CREATE|IN_DELETE|IN_MOVED_FROM|IN_MOVED_TO \
+			|IN_DELETE_SELF|IN_MOVE_SELF|IN_ONLYDIR)
+#endif
+
+
+/*
+ * pathTo() builds dir/name in the scratch path, or returns 0 if it can't
+ */
+static char *
+pathTo(Posix *px, char *dir, char *name)
+{
+    int size = strlen(dir) + strlen(name) + 2;
+
+    if (size > px->szpath) {
+	char *tmp = realloc(px->path, size);
+
+	if (tmp == 0)
+	    return 0;
+	px->path = tmp;
+	px->szpath = size;
+    }
+    sprintf(px->path, "%s/%s", dir, name);
+    return px->path;
+} /* pathTo */
+
+
+static void *
+posixOpen(void *ctx, char *path)
+{
+    Pdir *d;
+
+    if ((d = malloc(sizeof *d)) == 0)
+	return 0;
+    if ((d->dir = opendir(path)) == 0) {
+	free(d);
+	return 0;
+    }
+    d->path = strdup(path);
+    return d;
+} /* posixOpen */
+
+
+/*
+ * statEntry() stat()s (or, if follow isn't set, lstat()s) a directory
+ * entry
+ */
+static int
+statEntry(void *ctx, Pdir *d, char *name, struct stat *st, int follow)
 {
-    DIR* dir;
+#if HAVE_FSTATAT && HAVE_DIRFD
+    return fstatat(dirfd(d->dir), name, st, follow ? 0 : AT_SYMLINK_NOFOLLOW);
+#else
+    if (d->path == 0 || pathTo(ctx, d->path, name) == 0)
+	return -1;
+    return follow ? stat(((Posix*)ctx)->path, st)
+		  : lstat(((Posix*)ctx)->path, st);
+#endif
+} /* statEntry */
+
+
+/*
+ * posixRead() returns the next directory entry.  Most filesystems tell
+ * readdir() what each entry is, so we only need to stat() symlinks (to
+ * see where they go) and entries on the filesystems that don't.
+ */
+static char *
+posixRead(void *ctx, void *handle, int *isdir)
+{
+    Pdir *d = (Pdir*)handle;
     struct dirent *de;
     struct stat st;
-    regex_t re;
-    char *tmp;
-    int rc;
+    int link = 0;
 
-    deleteLIA(selector.directories);
-    deleteLIA(selector.files);
-    selector.directories = newLIA(0,0);
-    selector.files = newLIA(0,0);
+    if ((de = readdir(d->dir)) == 0)
+	return 0;
 
-    if (selector.pattern)
-	regcomp(&re, selector.pattern, REG_NOSUB);
+#if HAVE_STRUCT_DIRENT_D_TYPE
+    switch (de->d_type) {
+    case DT_DIR:	*isdir = 1;	return de->d_name;
+    case DT_LNK:	link = 1;	break;
+    case DT_UNKNOWN:	break;
+    default:		*isdir = 0;	return de->d_name;
+    }
+#endif
 
-    if ((dir = opendir(selector.curdir[0] ? selector.curdir : "/")) != 0) {
-	for (de = readdir(dir); de; de = readdir(dir)) {
-	    if (de->d_name[0] == '.' && !de->d_name[1])
-		continue;
-	    if (( tmp = malloc(strlen(selector.curdir)+strlen(de->d_name)+9) )) {
-		sprintf(tmp, "%s/%s", selector.curdir, de->d_name);
-		rc = stat(tmp, &st);
-		free(tmp);
+    if (!link) {
+	if (statEntry(ctx, d, de->d_name, &st, 0) != 0) {
+	    *isdir = -1;
+	    return de->d_name;
+	}
+	if (!S_ISLNK(st.st_mode)) {
+	    *isdir = S_ISDIR(st.st_mode);
+	    return de->d_name;
+	}
+    }
 
-		if ( rc != 0 )
-		    continue;
-		
-		if (S_ISDIR(st.st_mode))
-		    addToLIA(selector.directories, 0, de->d_name, 0);
-		else if (selector.pattern == 0 || regexec(&re, de->d_name, 0, 0, 0) == 0)
-		    addToLIA(selector.files, 0, de->d_name, 0);
+    /* a link to a directory is a directory, but not one to walk into */
+    if (statEntry(ctx, d, de->d_name, &st, 1) != 0)
+	*isdir = -1;
+    else
+	*isdir = S_ISDIR(st.st_mode) ? 2 : 0;
+    return de->d_name;
+} /* posixRead */
+
+
+static void
+posixClose(void *ctx, void *handle)
+{
+    Pdir *d = (Pdir*)handle;
+
+    closedir(d->dir);
+    if (d->path)
+	free(d->path);
+    free(d);
+} /* posixClose */
+
+
+static int
+posixStat(void *ctx, char *dir, char *name, off_t *size, time_t *mtime)
+{
+    Posix *px = (Posix*)ctx;
+    struct stat st;
+
+    if (pathTo(px, dir, name) == 0 || stat(px->path, &st) != 0)
+	return -1;
+    *size = st.st_size;
+    *mtime = st.st_mtime;
+    return 0;
+} /* posixStat */
+
+
+/*
+ * drainEvents() marks every directory inotify says has changed as stale
+ */
+static void
+drainEvents(Posix *px)
+{
+#if HAVE_SYS_INOTIFY_H
+    union {
+	struct inotify_event ev;	/* (to line the buffer up) */
+	char bfr[4096];
+    } u;
+    struct inotify_event *ev;
+    ssize_t size;
+    Pwatch *w;
+    char *p;
+
+    if (px->ifd < 0)
+	return;
+
+    while ((size = read(px->ifd, u.bfr, sizeof u.bfr)) > 0)
+	for (p = u.bfr; p < u.bfr + size; p += sizeof *ev + ev->len) {
+	    ev = (struct inotify_event*)p;
+	    for (w = px->watches; w; w = w->next)
+		if (w->wd == ev->wd) {
+		    w->stale = 1;
+		    if (ev->mask & IN_IGNORED)
+			w->wd = -1;
+		}
+	}
+#endif
+} /* drainEvents */
+
+
+static void *
+posixWatch(void *ctx, char *path)
+{
+    Posix *px = (Posix*)ctx;
+    Pwatch *w;
+    struct stat st;
+
+    if ((w = calloc(1, sizeof *w)) == 0)
+	return 0;
+    w->path = strdup(path);
+    w->wd = -1;
+#if HAVE_SYS_INOTIFY_H
+    if (px->ifd >= 0)
+	w->wd = inotify_add_watch(px->ifd, path, FS_EVENTS);
+#endif
+    if (stat(path, &st) == 0)
+	w->mtime = st.st_mtime;
+    time(&w->scanned);
+
+    w->next = px->watches;
+    px->watches = w;
+    return w;
+} /* posixWatch */
+
+
+static int
+posixChanged(void *ctx, void *watch)
+{
+    Pwatch *w = (Pwatch*)watch;
+    struct stat st;
+
+    drainEvents((Posix*)ctx);
+
+    if (w->stale)
+	return 1;
+    if (w->wd >= 0)
+	return 0;
+
+    /* no watch, so fall back on the mtime;  if the directory changed
+     * in the same second we started reading it we can't tell whether
+     * we saw the change, so call it changed to be sure.
+     */
+    return w->path == 0 || stat(w->path, &st) != 0
+			|| st.st_mtime != w->mtime
+			|| st.st_mtime >= w->scanned;
+} /* posixChanged */
+
+
+static void
+posixUnwatch(void *ctx, void *watch)
+{
+    Posix *px = (Posix*)ctx;
+    Pwatch *w = (Pwatch*)watch, **p;
+
+    for (p = &px->watches; *p; p = &(*p)->next)
+	if (*p == w) {
+	    *p = w->next;
+	    break;
+	}
+
+#if HAVE_SYS_INOTIFY_H
+    /* two paths to the same directory share a watch */
+    if (w->wd >= 0) {
+	Pwatch *o;
+
+	for (o = px->watches; o; o = o->next)
+	    if (o->wd == w->wd)
+		break;
+	if (o == 0)
+	    inotify_rm_watch(px->ifd, w->wd);
+    }
+#endif
+    if (w->path)
+	free(w->path);
+    free(w);
+} /* posixUnwatch */
+
+
+static int
+posixExists(void *ctx, char *path)
+{
+    return access(path, F_OK) == 0;
+} /* posixExists */
+
+
+static ndDirProvider posix = {
+    posixOpen, posixRead, posixClose, posixStat,
+    posixWatch, posixChanged, posixUnwatch, posixExists
+};
+
+
+static Posix *
+newPosix()
+{
+    Posix *px;
+
+    if ((px = calloc(1, sizeof *px)) == 0)
+	return 0;
+#if HAVE_SYS_INOTIFY_H
+    px->ifd = inotify_init1(IN_NONBLOCK|IN_CLOEXEC);
+#else
+    px->ifd = -1;
+#endif
+    return px;
+} /* newPosix */
+
+
+static void
+freePosix(Posix *px)
+{
+    while (px->watches)
+	posixUnwatch(px, px->watches);
+    if (px->ifd >= 0)
+	close(px->ifd);
+    if (px->path)
+	free(px->path);
+    free(px);
+} /* freePosix */
+
+
+/*
+ * makeKey() appends the sort key for name to a column's keys[] and
+ * returns where it starts, or -1 if there's no room for it
+ */
+static int
+makeKey(Column *c, char *name)
+{
+    int len = strlen(name);
+    int size = c->natural ? 3*len+1 : strxfrm(0, name, 0)+1;
+    char *p, *q, *start;
+
+    if (c->nrkeys + size > c->szkeys) {
+	int want = c->szkeys ? c->szkeys : 4096;
+
+	while (c->nrkeys + size > want)
+	    want *= 2;
+	if ((p = realloc(c->keys, want)) == 0)
+	    return -1;
+	c->keys = p;
+	c->szkeys = want;
+    }
+    start = c->keys + c->nrkeys;
+
+    if (!c->natural)
+	strxfrm(start, name, size);
+    else {
+	/* a run of digits becomes '0', the length of the number, and
+	 * the number without its leading zeros, so shorter numbers
+	 * sort first and numbers the same length sort by their digits;
+	 * everything else is lowercased.
+	 */
+	for (p = start; *name; )
+	    if (isdigit((unsigned char)*name)) {
+		while (*name == '0' && isdigit((unsigned char)name[1]))
+		    name++;
+		for (q = name; isdigit((unsigned char)*q); q++)
+		    ;
+		*p++ = '0';
+		*p++ = (q-name) < 254 ? (q-name)+1 : 255;
+		while (name < q)
+		    *p++ = *name++;
+	    }
+	    else
+		*p++ = tolower((unsigned char)*name++);
+	*p++ = 0;
+	size = p - start;
+    }
+    c->nrkeys += size;
+    return start - c->keys;
+} /* makeKey */
+
+
+/*
+ * before() tells whether entry a sorts ahead of entry b
+ */
+static int
+before(Column *c, Entry *a, Entry *b)
+{
+    /* .. is always first */
+    if (strcmp(b->item.item, "..") == 0)
+	return 0;
+    if (strcmp(a->item.item, "..") == 0)
+	return 1;
+
+    /* newest and biggest first, then by name */
+    if (c->order == FS_BYTIME && a->mtime != b->mtime)
+	return a->mtime > b->mtime;
+    if (c->order == FS_BYSIZE && a->size != b->size)
+	return a->size > b->size;
+    return strcmp(c->keys + a->key, c->keys + b->key) < 0;
+} /* before */
+
+
+/*
+ * merge() merges the sorted runs ent[0..mid) and ent[mid..n) through tmp
+ */
+static void
+merge(Column *c, Entry *ent, int mid, int n, Entry *tmp)
+{
+    int i = 0, j = mid, k = 0;
+
+    /* a stable merge; if b isn't before a, a goes first */
+    while (i < mid && j < n)
+	tmp[k++] = before(c, &ent[j], &ent[i]) ? ent[j++] : ent[i++];
+    while (i < mid)
+	tmp[k++] = ent[i++];
+    while (j < n)
+	tmp[k++] = ent[j++];
+    memcpy(ent, tmp, n * sizeof ent[0]);
+} /* merge */
+
+
+/*
+ * sortEntries() sorts ent[0..n)
+ */
+static void
+sortEntries(Column *c, Entry *ent, int n, Entry *tmp)
+{
+    if (n > 1) {
+	sortEntries(c, ent, n/2, tmp);
+	sortEntries(c, ent+n/2, n-n/2, tmp);
+	merge(c, ent, n/2, n, tmp);
+    }
+} /* sortEntries */
+
+
+#if HAVE_PTHREAD_H && HAVE_LIBPTHREAD
+typedef struct {
+    Column *c;
+    Entry *ent;
+    int n;
+    Entry *tmp;
+    int ways;			/* how many threads this run can use */
+} Run;
+
+static void sortRun(Run *);
+
+/*
+ * sortThread() is the start routine for a thread that sorts a run
+ */
+static void *
+sortThread(void *arg)
+{
+    sortRun((Run*)arg);
+    return 0;
+} /* sortThread */
+
+
+/*
+ * sortRun() sorts a run, handing the back half to another thread if
+ * it's big enough and there are cpus to spare.  If we can't get a
+ * thread it's all sorted here.
+ */
+static void
+sortRun(Run *r)
+{
+    pthread_t tid;
+    Run front, back;
+    int mid = r->n/2;
+
+    if (r->ways < 2 || r->n < FS_PARALLEL) {
+	sortEntries(r->c, r->ent, r->n, r->tmp);
+	return;
+    }
+
+    front.c = back.c = r->c;
+    front.ent = r->ent;
+    front.n = mid;
+    front.tmp = r->tmp;
+    front.ways = r->ways/2;
+    back.ent = r->ent + mid;
+    back.n = r->n - mid;
+    back.tmp = r->tmp + mid;
+    back.ways = r->ways - front.ways;
+
+    if (pthread_create(&tid, 0, sortThread, &back) != 0) {
+	sortEntries(r->c, r->ent, r->n, r->tmp);
+	return;
+    }
+    sortRun(&front);
+    pthread_join(tid, 0);
+    merge(r->c, r->ent, mid, r->n, r->tmp);
+} /* sortRun */
+#endif
+
+
+/*
+ * sortMany() sorts ent[0..n), on as many cpus as are online if it's
+ * big enough to be worth it
+ */
+static void
+sortMany(Column *c, Entry *ent, int n, Entry *tmp)
+{
+#if HAVE_PTHREAD_H && HAVE_LIBPTHREAD && defined(_SC_NPROCESSORS_ONLN)
+    static long cpus = 0;
+    Run r;
+
+    if (n >= FS_PARALLEL) {
+	if (cpus == 0 && (cpus = sysconf(_SC_NPROCESSORS_ONLN)) < 1)
+	    cpus = 1;
+	r.c = c;
+	r.ent = ent;
+	r.n = n;
+	r.tmp = tmp;
+	r.ways = (cpus > 64) ? 64 : cpus;
+	sortRun(&r);
+	return;
+    }
+#endif
+    sortEntries(c, ent, n, tmp);
+} /* sortMany */
+
+
+/*
+ * sortColumn() sorts the entries that have been read since the last
+ * time into the ones that are already sorted, and puts the sorted
+ * entries back into the LIA (so they can go straight into a list.)
+ * If the keys are the wrong kind for the order we want now, it makes
+ * new keys and sorts everything.
+ */
+static void
+sortColumn(Selector *s, char *dir, Column *c)
+{
+    ListItem *list = LIAlist(c->names);
+    int n = LIAcount(c->names);
+    int natural = (s->sort == FS_NATURAL);
+    int resort = 0;
+    Entry *tmp;
+    int ix;
+
+    if (n > c->alloc) {
+	int want = c->alloc ? c->alloc : 256;
+
+	while (want < n)
+	    want *= 2;
+	if ((tmp = realloc(c->ent, want * sizeof c->ent[0])) == 0)
+	    return;
+	c->ent = tmp;
+	c->alloc = want;
+    }
+
+    if (c->natural != natural || c->nrkeys == 0) {
+	/* new kind of keys for everything */
+	c->natural = natural;
+	c->nrkeys = 0;
+	for (ix = 0; ix < c->count; ix++)
+	    if ((c->ent[ix].key = makeKey(c, c->ent[ix].item.item)) < 0)
+		return;
+	resort = 1;
+    }
+    if (c->order != s->sort) {
+	c->order = s->sort;
+	resort = 1;
+    }
+
+    for (ix = c->count; ix < n; ix++) {
+	c->ent[ix].item = list[ix];
+	c->ent[ix].stated = 0;
+	if ((c->ent[ix].key = makeKey(c, list[ix].item)) < 0)
+	    return;
+    }
+
+    if (s->sort == FS_BYTIME || s->sort == FS_BYSIZE)
+	for (ix = 0; ix < n; ix++)
+	    if (!c->ent[ix].stated) {
+		if (s->provider->stat == 0
+		    || (*s->provider->stat)(s->ctx, dir, c->ent[ix].item.item,
+				&c->ent[ix].size, &c->ent[ix].mtime) != 0) {
+		    c->ent[ix].size = 0;
+		    c->ent[ix].mtime = 0;
+		}
+		c->ent[ix].stated = 1;
 	    }
+
+    if (n > 1 && (resort || n > c->count)) {
+	if ((tmp = malloc(n * sizeof tmp[0])) == 0)
+	    return;
+	if (resort)
+	    sortMany(c, c->ent, n, tmp);
+	else {
+	    sortMany(c, c->ent + c->count, n - c->count, tmp);
+	    merge(c, c->ent, c->count, n, tmp);
+	}
+	free(tmp);
+    }
+    for (ix = 0; ix < n; ix++)
+	list[ix] = c->ent[ix].item;
+    c->count = n;
+} /* sortColumn */
+
+
+/*
+ * freeColumn() throws a column away
+ */
+static void
+freeColumn(Column *c)
+{
+    deleteLIA(c->names);
+    if (c->ent)
+	free(c->ent);
+    if (c->keys)
+	free(c->keys);
+} /* freeColumn */
+
+
+/*
+ * rebind() points a list at the entries read so far, leaving the cursor
+ * where it was if keep is set
+ */
+static void
+rebind(Obj *list, LIA items, int keep)
+{
+    int cursor = keep ? getObjCursor(list) : 0;
+
+    setObjData(list, 0L, LIAlist(items), LIAcount(items));
+    if (LIAcount(items) == 0)
+	setReadonly(list);
+    else {
+	setWritable(list);
+	if (cursor > 0 && cursor < LIAcount(items))
+	    setObjCursor(list, cursor);
+    }
+} /* rebind */
+
+
+/*
+ * showEntries() sorts what's been read into the lists, and says how
+ * much that is in the title of the file list until it's all been read
+ */
+static void
+showEntries(Selector *s, int keep)
+{
+    Listing *l = s->shown;
+    char title[40];
+
+    sortColumn(s, l->path, &l->directories);
+    sortColumn(s, l->path, &l->files);
+
+    rebind(s->dirlist, l->directories.names, keep);
+    if (s->find == 0) {
+	rebind(s->filelist, l->files.names, keep);
+
+	/* pad the title so a shorter one covers up a longer one */
+	if (s->dir)
+	    sprintf(title, "Files (%d...)", LIAcount(l->files.names));
+	else
+	    strcpy(title, "Files");
+	sprintf(title+strlen(title), "%*s", (int)(16 - strlen(title)), "");
+	setObjTitle(s->filelist, title);
+    }
+    touchObj(s->self);
+} /* showEntries */
+
+
+/*
+ * scanSlice() reads directory entries for FS_SLICE msec, or until
+ * there aren't any more, and returns 1 if the directory is finished.
+ */
+static int
+scanSlice(Selector *s)
+{
+    struct timeval start, now;
+    char *name;
+    int isdir;
+    int count = 0;
+
+    if (s->dir == 0)
+	return 1;
+
+    gettimeofday(&start, 0);
+    while ((name = (*s->provider->read)(s->ctx, s->dir, &isdir)) != 0) {
+	/* we put in our own .. */
+	if (name[0] == '.' && (!name[1] || (name[1] == '.' && !name[2])))
+	    continue;
+
+	switch (isdir) {
+	case 1:
+	case 2:
+	    addToLIA(s->shown->directories.names, 0, name, 0);
+	    break;
+	case 0:
+	    if (!s->compiled || regexec(&s->re, name, 0, 0, 0) == 0)
+		addToLIA(s->shown->files.names, 0, name, 0);
+	    break;
+	default:
+	    break;
+	}
+
+	if (++count % FS_CHECK == 0) {
+	    gettimeofday(&now, 0);
+	    if ((now.tv_sec - start.tv_sec) * 1000
+		    + (now.tv_usec - start.tv_usec) / 1000 >= FS_SLICE)
+		break;
+	}
+    }
+    if (name == 0) {
+	(*s->provider->close)(s->ctx, s->dir);
+	s->dir = 0;
+	s->shown->complete = 1;
+    }
+    showEntries(s, 1);
+    return s->dir == 0;
+} /* scanSlice */
+
+
+/*
+ * fs_scan() is the form timer that reads the directory
+ */
+static int
+fs_scan(ndForm form, void *arg)
+{
+    Selector *s = FS(arg);
+
+    if (scanSlice(s)) {
+	s->timer = -1;
+	return 1;
+    }
+    return 0;
+} /* fs_scan */
+
+
+/*
+ * stopScan() abandons the directory that's being read
+ */
+static void
+stopScan(Selector *s)
+{
+    if (s->dir) {
+	(*s->provider->close)(s->ctx, s->dir);
+	s->dir = 0;
+    }
+} /* stopScan */
+
+
+/*
+ * release() forgets a remembered directory
+ */
+static void
+release(Selector *s, Listing *l)
+{
+    if (l->watch && s->provider->unwatch)
+	(*s->provider->unwatch)(s->ctx, l->watch);
+    freeColumn(&l->directories);
+    freeColumn(&l->files);
+    if (l->path)
+	free(l->path);
+    memset(l, 0, sizeof *l);
+} /* release */
+
+
+/*
+ * isFresh() tells whether a remembered directory can be shown as is
+ */
+static int
+isFresh(Selector *s, Listing *l)
+{
+    if (!l->complete)
+	return 0;
+    if (s->provider->watch == 0)
+	return 1;
+    return l->watch && !(*s->provider->changed)(s->ctx, l->watch);
+} /* isFresh */
+
+
+/*
+ * showDirectory() shows the current directory, from the cache if it's
+ *                 there and hasn't changed, otherwise by starting to
+ *                 read it.  Any directory that's still being read is
+ *                 abandoned.
+ */
+static void
+showDirectory(Selector *s, int keep)
+{
+    char *path = s->curdir[0] ? s->curdir : "/";
+    Listing *old = s->shown, *drop = 0, *l = 0;
+    int ix;
+
+    stopScan(s);
+
+    for (ix = 0; ix < FS_CACHE; ix++)
+	if (s->cache[ix].path && strcmp(s->cache[ix].path, path) == 0) {
+	    l = &s->cache[ix];
+	    break;
 	}
-	closedir(dir);
-    }
-    else 
-	addToLIA(selector.directories, 0, "..", 0);/* always allow escape */
-    regfree(&re);
-    setObjData(selector.dirlist,0L,LIAlist(selector.directories),
-				   LIAcount(selector.directories));
-    if (LIAcount(selector.directories) == 0)
-	setReadonly(selector.dirlist);
+
+    if (l && !isFresh(s, l)) {
+	/* it can't be reused until it's not showing */
+	drop = l;
+	l = 0;
+    }
+
+    if (l == 0) {
+	/* reuse the stale copy, an empty slot, or the one that was
+	 * shown longest ago, but never the one that's showing now
+	 */
+	if (drop && drop != old)
+	    l = drop;
+	else
+	    for (ix = 0; ix < FS_CACHE; ix++) {
+		if (&s->cache[ix] == old)
+		    continue;
+		if (s->cache[ix].path == 0) {
+		    l = &s->cache[ix];
+		    break;
+		}
+		if (l == 0 || s->cache[ix].used < l->used)
+		    l = &s->cache[ix];
+	    }
+	release(s, l);
+
+	/* the LIAs keep the names they're given in their own arenas, so
+	 * building a new pair for each directory doesn't mean a malloc()
+	 * for every entry
+	 */
+	l->path = strdup(path);
+	l->directories.names = newLIA(0,0);
+	l->files.names = newLIA(0,0);
+
+	/* watch it before reading it, so changes made while we're
+	 * reading it aren't lost
+	 */
+	if (s->provider->watch)
+	    l->watch = (*s->provider->watch)(s->ctx, path);
+
+	if (s->curdir[0])
+	    addToLIA(l->directories.names, 0, "..", 0);
+	s->dir = (*s->provider->open)(s->ctx, path);
+    }
+
+    l->used = ++s->clock;
+    s->shown = l;
+
+    if (keep && s->dir)
+	scanSlice(s);	/* read some of it first, so the cursors can stay put */
+    else
+	showEntries(s, keep);
+
+    /* now that the lists don't point at them, get rid of the stale
+     * copy and anything we didn't finish reading
+     */
+    if (drop && drop != l)
+	release(s, drop);
+    if (old && old != l && old != drop && !old->complete)
+	release(s, old);
+
+    if (s->dir && s->timer < 0 && s->form)
+	s->timer = addFormTimer(s->form, 1, 1, fs_scan, s->self);
+    if (s->dir && s->timer < 0) {
+	/* no form to read it from, so read it all now */
+	while (!scanSlice(s))
+	    ;
+    }
+} /* showDirectory */
+
+
+/*
+ * fs_watch() is the form timer that rereads the directory that's
+ *            showing if it changes
+ */
+static int
+fs_watch(ndForm form, void *arg)
+{
+    Selector *s = FS(arg);
+
+    if (s->dir == 0 && s->shown && s->shown->complete && !isFresh(s, s->shown))
+	showDirectory(s, 1);
+    return 0;
+} /* fs_watch */
+
+
+/*
+ * stash() copies a name (or two, joined with a /) into the finder's
+ * blocks, or returns 0 if it's out of room
+ */
+static char *
+stash(Finder *f, char *dir, char *name)
+{
+    int size = strlen(name) + 1 + (dir[0] ? strlen(dir)+1 : 0);
+    Fblock *b = f->blocks;
+    char *p;
+
+    if (size > FS_BLOCK)
+	return 0;
+    if (b == 0 || b->used + size > FS_BLOCK) {
+	if (f->nrblocks >= FS_BLOCKS || (b = malloc(sizeof *b)) == 0)
+	    return 0;
+	b->used = 0;
+	b->next = f->blocks;
+	f->blocks = b;
+	f->nrblocks++;
+    }
+    p = b->text + b->used;
+    if (dir[0])
+	sprintf(p, "%s/%s", dir, name);
+    else
+	strcpy(p, name);
+    b->used += size;
+    return p;
+} /* stash */
+
+
+/*
+ * findPath() builds the path to a directory under the root of the walk
+ */
+static char *
+findPath(Finder *f, char *dir)
+{
+    int size = strlen(f->root) + strlen(dir) + 2;
+
+    if (size > f->szpath) {
+	char *tmp = realloc(f->path, size);
+
+	if (tmp == 0)
+	    return 0;
+	f->path = tmp;
+	f->szpath = size;
+    }
+    if (dir[0] == 0)
+	strcpy(f->path, f->root);
+    else if (strcmp(f->root, "/") == 0)
+	sprintf(f->path, "/%s", dir);
     else
-	setWritable(selector.dirlist);
+	sprintf(f->path, "%s/%s", f->root, dir);
+    return f->path;
+} /* findPath */
+
+
+/*
+ * fuzzy() scores how well text matches query, or returns -1 if it
+ * doesn't.  The letters of the query have to appear in the text in
+ * order (ignoring case);  they score more for starting a word or a
+ * path component, for following the letter before them, and for being
+ * in the filename, and less for the letters skipped between them.
+ */
+static int
+fuzzy(char *text, char *query)
+{
+    char *p, *start, *end, *base;
+    int ix, len = strlen(query);
+    int score = 0, run = 0;
+
+    /* find where the first match ends ... */
+    for (ix = 0, p = text; *p && ix < len; p++)
+	if (tolower((unsigned char)*p) == tolower((unsigned char)query[ix]))
+	    ix++;
+    if (ix < len)
+	return -1;
+    end = p;
+
+    /* ... and back up from there to the shortest match ending there */
+    for (ix = len-1, p = end-1; ix >= 0; --p)
+	if (tolower((unsigned char)*p) == tolower((unsigned char)query[ix]))
+	    --ix;
+    start = p+1;
+
+    base = strrchr(text, '/');
+    base = base ? base+1 : text;
+
+    for (p = start, ix = 0; p < end; p++)
+	if (tolower((unsigned char)*p) == tolower((unsigned char)query[ix])) {
+	    score += 16;
+	    if (p == text || strchr("/_-. ", p[-1]))
+		score += 24;
+	    if (run)
+		score += 12;
+	    if (p >= base)
+		score += 8;
+	    run = 1;
+	    ix++;
+	}
+	else {
+	    score -= run ? 4 : 1;
+	    run = 0;
+	}
+    return score;
+} /* fuzzy */
+
+
+/*
+ * better() tells whether match a goes ahead of match b:  higher scores
+ * first, then shorter paths, then the order they were found in.
+ */
+static int
+better(Finder *f, Match *a, Match *b)
+{
+    int la, lb;
+
+    if (a->score != b->score)
+	return a->score > b->score;
+    if (f->query[0]) {
+	la = strlen(f->cand[a->cand]);
+	lb = strlen(f->cand[b->cand]);
+	if (la != lb)
+	    return la < lb;
+    }
+    return a->cand < b->cand;
+} /* better */
+
+
+/*
+ * mergeMatches() merges the sorted runs m[0..mid) and m[mid..n)
+ */
+static void
+mergeMatches(Finder *f, Match *m, int mid, int n, Match *tmp)
+{
+    int i = 0, j = mid, k = 0;
+
+    /* nothing to do if they're already in order */
+    if (mid == 0 || mid == n || !better(f, &m[mid], &m[mid-1]))
+	return;
+
+    while (i < mid && j < n)
+	tmp[k++] = better(f, &m[j], &m[i]) ? m[j++] : m[i++];
+    while (i < mid)
+	tmp[k++] = m[i++];
+    while (j < n)
+	tmp[k++] = m[j++];
+    memcpy(m, tmp, n * sizeof m[0]);
+} /* mergeMatches */
+
+
+/*
+ * sortMatches() sorts m[0..n)
+ */
+static void
+sortMatches(Finder *f, Match *m, int n, Match *tmp)
+{
+    if (n > 1) {
+	sortMatches(f, m, n/2, tmp);
+	sortMatches(f, m+n/2, n-n/2, tmp);
+	mergeMatches(f, m, n/2, n, tmp);
+    }
+} /* sortMatches */
+
+
+/*
+ * addMatch() scores a candidate, and adds it to the matches if it
+ * matches
+ */
+static int
+addMatch(Finder *f, int cand)
+{
+    int score = f->query[0] ? fuzzy(f->cand[cand], f->query) : 0;
+
+    if (score < 0)
+	return 0;
+    if (f->nrmatch >= f->szmatch) {
+	int want = f->szmatch ? 2*f->szmatch : 1024;
+	Match *tmp = realloc(f->match, want * sizeof f->match[0]);
+
+	if (tmp == 0)
+	    return -1;
+	f->match = tmp;
+	f->szmatch = want;
+    }
+    f->match[f->nrmatch].cand = cand;
+    f->match[f->nrmatch].score = score;
+    f->nrmatch++;
+    return 1;
+} /* addMatch */
+
+
+/*
+ * sortFound() sorts the new matches into the ones already sorted
+ */
+static void
+sortFound(Finder *f)
+{
+    Match *tmp;
+
+    if (f->sorted < f->nrmatch
+		&& (tmp = malloc(f->nrmatch * sizeof tmp[0])) != 0) {
+	sortMatches(f, f->match + f->sorted, f->nrmatch - f->sorted, tmp);
+	mergeMatches(f, f->match, f->sorted, f->nrmatch, tmp);
+	free(tmp);
+    }
+    f->sorted = f->nrmatch;
+} /* sortFound */
+
+
+/*
+ * showFound() puts the best matches into the file list
+ */
+static void
+showFound(Selector *s, int keep)
+{
+    Finder *f = s->find;
+    int count = (f->nrmatch < FS_SHOW) ? f->nrmatch : FS_SHOW;
+    int cursor = keep ? getObjCursor(s->filelist) : 0;
+    char title[40];
+    int ix;
+
+    for (ix = 0; ix < count; ix++) {
+	f->items[ix].id = f->items[ix].help = 0;
+	f->items[ix].item = f->cand[f->match[ix].cand];
+	f->items[ix].selected = 0;
+    }
+    setObjData(s->filelist, 0L, f->items, count);
+    if (count == 0)
+	setReadonly(s->filelist);
+    else {
+	setWritable(s->filelist);
+	if (cursor > 0 && cursor < count)
+	    setObjCursor(s->filelist, cursor);
+    }
+
+    sprintf(title, "Found (%d%s)", f->nrmatch,
+		    f->full ? "+" : (f->dir || f->head < f->tail) ? "..." : "");
+    sprintf(title+strlen(title), "%*s", (int)(16 - strlen(title)), "");
+    setObjTitle(s->filelist, title);
+    touchObj(s->self);
+} /* showFound */
+
+
+/*
+ * findSlice() walks the tree for FS_SLICE msec, or until it's all been
+ * walked, then matches what it found and returns 1 if the walk is done.
+ */
+static int
+findSlice(Selector *s)
+{
+    Finder *f = s->find;
+    struct timeval start, now;
+    char *name, *p;
+    int isdir, depth;
+    int count = 0;
+    int last = f->nrmatch;
+
+    gettimeofday(&start, 0);
+    while (!f->full) {
+	if (f->dir == 0) {
+	    /* on to the next directory */
+	    if (f->head >= f->tail)
+		break;
+	    f->dirpath = f->queue[f->head++];
+	    if ((p = findPath(f, f->dirpath)) == 0)
+		continue;
+	    if ((f->dir = (*s->provider->open)(s->ctx, p)) == 0)
+		continue;
+	}
+
+	if ((name = (*s->provider->read)(s->ctx, f->dir, &isdir)) == 0) {
+	    (*s->provider->close)(s->ctx, f->dir);
+	    f->dir = 0;
+	    continue;
+	}
+	if (name[0] == '.' && (!name[1] || (name[1] == '.' && !name[2])))
+	    continue;
+
+	if (isdir == 1) {
+	    for (depth = 1, p = f->dirpath; *p; p++)
+		if (*p == '/')
+		    depth++;
+	    if (depth < FS_DEPTH) {
+		if (f->tail >= f->szqueue) {
+		    /* slide the queue down, or make it bigger */
+		    char **tmp;
+		    int want = f->szqueue ? 2*f->szqueue : 256;
+
+		    if (f->head > f->szqueue/2) {
+			memmove(f->queue, f->queue+f->head,
+				(f->tail-f->head) * sizeof f->queue[0]);
+			f->tail -= f->head;
+			f->head = 0;
+		    }
+		    else if ((tmp = realloc(f->queue, want * sizeof tmp[0])) != 0) {
+			f->queue = tmp;
+			f->szqueue = want;
+		    }
+		}
+		if (f->tail >= f->szqueue
+		    || (f->queue[f->tail] = stash(f, f->dirpath, name)) == 0)
+		    f->full = 1;
+		else
+		    f->tail++;
+	    }
+	}
+	else if (isdir == 0 && (!s->compiled || regexec(&s->re, name, 0, 0, 0) == 0)) {
+	    if (f->nrcand >= f->szcand) {
+		int want = f->szcand ? 2*f->szcand : 1024;
+		char **tmp = realloc(f->cand, want * sizeof tmp[0]);
+
+		if (tmp == 0) {
+		    f->full = 1;
+		    break;
+		}
+		f->cand = tmp;
+		f->szcand = want;
+	    }
+	    if ((f->cand[f->nrcand] = stash(f, f->dirpath, name)) == 0)
+		f->full = 1;
+	    else
+		f->nrcand++;
+	}
+
+	if (++count % FS_CHECK == 0) {
+	    gettimeofday(&now, 0);
+	    if ((now.tv_sec - start.tv_sec) * 1000
+		    + (now.tv_usec - start.tv_usec) / 1000 >= FS_SLICE)
+		break;
+	}
+    }
+
+    if (f->full && f->dir) {
+	/* out of room;  what we've got is all we'll get */
+	(*s->provider->close)(s->ctx, f->dir);
+	f->dir = 0;
+	f->head = f->tail;
+    }
+
+    for ( ; f->scored < f->nrcand; f->scored++)
+	if (addMatch(f, f->scored) < 0)
+	    break;
+    sortFound(f);
+
+    if (f->nrmatch != last || f->dir == 0)
+	showFound(s, 1);
+    return f->dir == 0 && f->head >= f->tail;
+} /* findSlice */
+
+
+/*
+ * fs_find() is the form timer that walks the tree
+ */
+static int
+fs_find(ndForm form, void *arg)
+{
+    Selector *s = FS(arg);
+
+    if (s->find == 0 || findSlice(s)) {
+	if (s->find)
+	    s->find->timer = -1;
+	return 1;
+    }
+    return 0;
+} /* fs_find */
+
+
+/*
+ * refind() matches the candidates against a new query
+ */
+static void
+refind(Selector *s, int keep)
+{
+    Finder *f = s->find;
+    int longer = f->query[0] && strncmp(s->result, f->query, strlen(f->query)) == 0;
+    int ix, count;
+
+    strcpy(f->query, s->result);
+
+    if (longer) {
+	/* anything that matches now matched before, so only the old
+	 * matches need to be looked at again
+	 */
+	for (count = ix = 0; ix < f->nrmatch; ix++)
+	    if ((f->match[count].score = fuzzy(f->cand[f->match[ix].cand],
+					       f->query)) >= 0)
+		f->match[count++].cand = f->match[ix].cand;
+	f->nrmatch = count;
+    }
+    else {
+	f->nrmatch = 0;
+	for (ix = 0; ix < f->scored; ix++)
+	    if (addMatch(f, ix) < 0)
+		break;
+    }
+    f->sorted = 0;
+    sortFound(f);
+    showFound(s, keep);
+} /* refind */
+
+
+/*
+ * stopFind() abandons the walk, and throws away everything it found
+ */
+static void
+stopFind(Selector *s)
+{
+    Finder *f = s->find;
+    Fblock *b;
+
+    if (f->timer >= 0 && s->form)
+	removeFormTimer(s->form, f->timer);
+    f->timer = -1;
+    if (f->dir)
+	(*s->provider->close)(s->ctx, f->dir);
+    f->dir = 0;
+
+    while ((b = f->blocks) != 0) {
+	f->blocks = b->next;
+	free(b);
+    }
+    f->nrblocks = 0;
+    f->full = 0;
+    f->head = f->tail = 0;
+    f->nrcand = f->scored = f->nrmatch = f->sorted = 0;
+    if (f->root) {
+	free(f->root);
+	f->root = 0;
+    }
+} /* stopFind */
+
+
+/*
+ * freeFinder() leaves find mode
+ */
+static void
+freeFinder(Selector *s)
+{
+    Finder *f = s->find;
+
+    stopFind(s);
+    if (f->queue)
+	free(f->queue);
+    if (f->cand)
+	free(f->cand);
+    if (f->match)
+	free(f->match);
+    if (f->items)
+	free(f->items);
+    if (f->path)
+	free(f->path);
+    free(f);
+    s->find = 0;
+} /* freeFinder */
+
+
+/*
+ * startFind() starts walking the tree under the current directory
+ */
+static void
+startFind(Selector *s)
+{
+    Finder *f = s->find;
 
-    setObjData(selector.filelist,0L,LIAlist(selector.files),
-				    LIAcount(selector.files));
-    if (LIAcount(selector.files) == 0)
-	setReadonly(selector.filelist);
+    stopFind(s);
+    f->root = strdup(s->curdir[0] ? s->curdir : "/");
+
+    if (f->szqueue == 0 && (f->queue = malloc(256 * sizeof f->queue[0])) != 0)
+	f->szqueue = 256;
+    if (f->root == 0 || f->szqueue == 0)
+	f->full = 1;
     else
-	setWritable(selector.filelist);
+	f->queue[f->tail++] = "";
 
-    strcpy(selector.result, selector.curdir);
-    strcat(selector.result, "/");
-    setObjCursor(selector.selection, strlen(selector.result)-1);
+    showFound(s, 0);
 
-    if (display) {
-	drawObj(selector.filelist, display);
-	drawObj(selector.dirlist, display);
-	drawObj(selector.selection, display);
+    if (f->timer < 0 && s->form)
+	f->timer = addFormTimer(s->form, 1, 1, fs_find, s->self);
+    if (f->timer < 0) {
+	/* no form to walk it from, so walk it all now */
+	while (!findSlice(s))
+	    ;
     }
-    else {
-	touchObj(selector.filelist);
-	touchObj(selector.dirlist);
-	touchObj(selector.selection);
+} /* startFind */
+
+
+/*
+ * populateSelector() fills the dirlist and filelist with directory
+ *                    entries when we change directories.
+ */
+static void
+populateSelector(Selector *s, ndDisplay display)
+{
+    showDirectory(s, 0);
+
+    if (s->find)
+	startFind(s);	/* the query stays, and is looked for here */
+    else if (strlen(s->curdir) + 1 < sizeof s->result) {
+	strcpy(s->result, s->curdir);
+	strcat(s->result, "/");
+	setObjCursor(s->selection, strlen(s->result)-1);
     }
+    else
+	s->result[0] = 0;
+
+    if (display)
+	drawObj(s->self, display);
+    else
+	touchObj(s->self);
 } /* populateSelector */
 
 
@@ -130,169 +1589,754 @@ populateSelector(ndDisplay display)
 static int
 fs_dir_cb(ndObject obj, ndDisplay display)
 {
+    Selector *s = FS(OBJ(obj)->parent);
     int i = getObjCursor(obj);
     ListItem *tmp = getObjList(obj);
     char *p;
+    int size;
 
     if (strcmp(tmp[i].item, "..") == 0) {
 	/* going up one directory; trim a directory level
-	 * from selector.curdir
+	 * from s->curdir
 	 */
-	if ((p = strrchr(selector.curdir, '/')) != 0) {
+	if ((p = strrchr(s->curdir, '/')) != 0) {
 	    *p = 0;
-	    selector.szcurdir = (p-selector.curdir);
+	    s->szcurdir = (p-s->curdir);
 	}
     }
     else {
-	/* going down a directory */
-	selector.szcurdir += 1+strlen(tmp[i].item);
-	selector.curdir = realloc(selector.curdir, 1+selector.szcurdir);
-	strcat(selector.curdir, "/");
-	strcat(selector.curdir, tmp[i].item);
+	/* going down a directory, as long as the selection will
+	 * still fit
+	 */
+	size = s->szcurdir + 1 + strlen(tmp[i].item);
+	if (size + 1 >= sizeof s->result) {
+	    errno = ENAMETOOLONG;
+	    Error(tmp[i].item);
+	    return 0;
+	}
+	if ((p = realloc(s->curdir, 1+size)) == 0) {
+	    Error(tmp[i].item);
+	    return 0;
+	}
+	s->curdir = p;
+	s->szcurdir = size;
+	strcat(s->curdir, "/");
+	strcat(s->curdir, tmp[i].item);
     }
-    populateSelector(display);
+    populateSelector(s, display);
     return 0;
 } /* fs_dir_cb */
 
+
+/*
+ * picked() calls the user callback when a selection is made
+ */
+static int
+picked(Selector *s, ndDisplay display)
+{
+    return s->callback ? (*s->callback)(s->self, display) : 1;
+} /* picked */
+
+
 /*
  * fs_sel_cb() deals with a user-entered selection
  */
 static int
-fs_sel_cb()
+fs_sel_cb(ndObject obj, ndDisplay display)
 {
-    if (access(selector.result, F_OK) != 0) {
-	Error(selector.result);
-	return 1;
+    Selector *s = FS(OBJ(obj)->parent);
+    char *name;
+
+    if (s->find) {
+	/* the query picks the best match */
+	if (s->find->nrmatch == 0) {
+	    errno = ENOENT;
+	    Error("Nothing matches %s", s->result);
+	    return 0;
+	}
+	name = s->find->cand[s->find->match[0].cand];
+	if (strlen(s->curdir) + strlen(name) + 1 >= sizeof s->result)
+	    return 0;
+	sprintf(s->result, "%s/%s", s->curdir, name);
+	strcpy(s->find->query, s->result);
+	drawObj(s->self, display);
     }
-    return -1;
+    else if (s->provider->exists && !(*s->provider->exists)(s->ctx, s->result)) {
+	Error(s->result);
+	return 0;
+    }
+    return picked(s, display);
 } /* fs_sel_cb */
 
 
 /*
- * fs_file_cb() attaches a file to the selection and fails successfully
+ * fs_file_cb() makes a file the selection
  */
 static int
 fs_file_cb(ndObject obj, ndDisplay display)
 {
-    strcat(selector.result, getObjList(obj)[getObjCursor(obj)].item);
-    drawObj(selector.selection, display);
-    return -1;
-} /* fs_file_callback */
+    Selector *s = FS(OBJ(obj)->parent);
+    char *name = getObjList(obj)[getObjCursor(obj)].item;
 
+    if (strlen(s->curdir) + strlen(name) + 1 < sizeof s->result) {
+	sprintf(s->result, "%s/%s", s->curdir, name);
+	if (s->find)	/* picking it isn't a new query */
+	    strcpy(s->find->query, s->result);
+    }
+    drawObj(s->self, display);
+    return picked(s, display);
+} /* fs_file_cb */
 
 
 /*
- * fileselector() pops up a file selection box.  (This should be generalized
- *                into a widget, but will be kept as a user-level function
- *                until I've got it debugged.)
+ * newFileSelector() creates a file selector that starts out in dir and
+ * only shows the files that match the (shell) pattern.  If provider is
+ * 0 it reads the filesystem.
  */
-char *
-fileselector(int width, int depth, char *title, char *pattern, char *dir)
+ndObject
+newFileSelector(int x, int y, int width, int depth, char *dir, char *pattern,
+		ndDirProvider *provider, void *ctx, pfo callback, char *help)
 {
-    ndObject chain;
-    int rc;
-    char *p;
-    char *ret;
+    Obj *tmp;
+    Selector *s;
+    char *re, *p;
 
-    if (width < 40 && depth < 10) {
+    if (width < 40 || depth < 10 || dir == 0) {
+	errno = EINVAL;
+	return 0;
+    }
+    if (strlen(dir) + 1 >= FS_PATHMAX) {
+	errno = ENAMETOOLONG;
+	return 0;
+    }
+    if (provider && (provider->open == 0 || provider->read == 0
+					 || provider->close == 0
+		     || (provider->watch && provider->changed == 0))) {
 	errno = EINVAL;
 	return 0;
     }
 
-    /* build the menu:  selection at the top, with directory and
+#if DYNAMIC_BINDING
+    if (W_FILESEL == O_ERROR) {
+	static struct _nd_object_table t = { 0, (nd_edit)editFileSelector,
+						(nd_draw)drawFileSelector,
+						(nd_free)deleteFileSelector,
+						0, 0, 0, 0,
+						(nd_start)startFileSelector,
+						(nd_key)keyFileSelector } ;
+	W_FILESEL = nd_register_objtab(sizeof t, &t);
+    }
+    if (W_FILESEL == -1) {
+	errno = ENFILE;
+	return 0;
+    }
+#endif
+
+    tmp = _nd_newObj(0, W_FILESEL, 0, 0, 0, x, y, width, depth, help);
+    if (tmp == 0)
+	return 0;
+
+    if ((tmp->item.generic = calloc(1, sizeof *s)) == 0) {
+	deleteObj(tmp);
+	return 0;
+    }
+    s = FS(tmp);
+    s->self = tmp;
+    s->callback = callback;
+    s->timer = s->watcher = -1;
+
+    if (provider) {
+	s->provider = provider;
+	s->ctx = ctx;
+    }
+    else if ((s->ctx = newPosix()) != 0) {
+	s->provider = &posix;
+	s->ownctx = 1;
+    }
+    else {
+	deleteObj(tmp);
+	return 0;
+    }
+
+    s->szcurdir = strlen(dir);
+    if ((s->curdir = strdup(dir)) == 0) {
+	deleteObj(tmp);
+	return 0;
+    }
+    /* / is kept as "", so going up from /a gets us there */
+    while (s->szcurdir > 0 && s->curdir[s->szcurdir-1] == '/')
+	s->curdir[--s->szcurdir] = 0;
+
+    /* convert shell pattern to regex() pattern, and compile it once
+     * instead of every time we change directories
+     */
+    if (pattern && (re = malloc(strlen(pattern) * 2 + 1)) != 0) {
+	for (p = re; *pattern; ) {
+	    if (*pattern == '\\' && pattern[1]) {
+		*p++ = *pattern++;
+		*p++ = *pattern++;
+	    }
+	    else if (*pattern == '*') {	/* expand * to .* */
+		*p++ = '.';
+		*p++ = *pattern++;
+	    }
+	    else if (*pattern == '?') {	/* ? maps to . */
+		*p++ = '.';
+		pattern++;
+	    }
+	    else if (*pattern == '.') {	/* . expands to \. */
+		*p++ = '\\';
+		*p++ = *pattern++;
+	    }
+	    else			/* pass everything else */
+		*p++ = *pattern++;
+	}
+	*p = 0;
+	s->compiled = (regcomp(&s->re, re, REG_NOSUB) == 0);
+	free(re);
+    }
+
+    /* build the widget:  selection at the top, with directory and
      * file lists side-by-side below it.
      */
-    selector.selection = chain = newString(0,0, width-12,
-		      sizeof selector.result, selector.result,
-		      0, "Selection:|", fs_sel_cb, 0);
+    s->selection = newString(x, y, width-12, sizeof s->result, s->result,
+			     0, "Selection:|", fs_sel_cb, help);
+    s->dirlist = newMenu(x, y+3, (width/2)-2, depth-6, 0, 0,
+			 "Directories", "", 0, fs_dir_cb, help);
+    s->filelist = newMenu(x+(width/2), y+3, (width/2)-2, depth-6, 0, 0,
+			  "Files", "", 0, fs_file_cb, help);
 
-    chain = ObjChain(chain,
-		    selector.dirlist = newMenu(0,3, (width/2)-2,
-					       depth-6, 0, 0, "Directories", "",
-					       0, fs_dir_cb, 0));
+    if (s->selection == 0 || s->dirlist == 0 || s->filelist == 0) {
+	deleteObj(tmp);
+	return 0;
+    }
+    s->selection->parent = s->dirlist->parent = s->filelist->parent = tmp;
+    s->selection->flags |= OBJ_DRAW;
+    s->dirlist->flags |= OBJ_DRAW;
+    s->filelist->flags |= OBJ_DRAW;
 
-    chain = ObjChain(chain,
-		    selector.filelist = newMenu(width/2, 3, (width/2)-2,
-						depth-6, 0, 0, "Files", "",
-						0, fs_file_cb, 0));
+    /* the directory isn't read until the selector is put on a form or
+     * drawn, whichever comes first
+     */
+    return tmp;
+} /* newFileSelector */
 
-#if DIRECTORY_SELECT_ONLY
-    chain = ObjChain(chain, newOKButton(0, "OK", fs_sel_cb, 0));
-#endif
-    chain = ObjChain(chain, newCancelButton(1, "Cancel", 0, 0));
 
-    /* populate the selector pseudo-widget */
-    selector.directories = newLIA(0,0);
-    selector.files = newLIA(0,0);
-    selector.pattern = malloc(strlen(pattern) * 2);
+/*
+ * setFileSelectorForm() tells a file selector which form it's on, so it
+ * can read (and watch) directories from form timers.  Call it with a
+ * null form before the form is deleted.
+ */
+int
+setFileSelectorForm(ndObject o, ndForm form)
+{
+    Selector *s;
 
-    /* convert shell pattern to regex() pattern
-     */
-    for (p=selector.pattern; *pattern; ) {
-	if (*pattern == '\\' && pattern[1]) {
-	    *p++ = *pattern++;
-	    *p++ = *pattern++;
+    if (o == 0 || objType(o) != W_FILESEL) {
+	errno = EINVAL;
+	return -1;
+    }
+    s = FS(o);
+
+    if (s->form) {
+	if (s->timer >= 0)
+	    removeFormTimer(s->form, s->timer);
+	if (s->watcher >= 0)
+	    removeFormTimer(s->form, s->watcher);
+	s->timer = s->watcher = -1;
+	if (s->find && s->find->timer >= 0) {
+	    removeFormTimer(s->form, s->find->timer);
+	    s->find->timer = -1;
+	}
+
+	/* a half-read directory can't be finished without a timer, so
+	 * it'll be read again the next time it's shown
+	 */
+	stopScan(s);
+    }
+
+    if ((s->form = form) != 0) {
+	if (s->provider->watch)
+	    s->watcher = addFormTimer(form, FS_RECHECK, 1, fs_watch, s->self);
+	if (s->shown == 0)
+	    populateSelector(s, 0);
+	else if (!s->shown->complete)
+	    showDirectory(s, 1);
+
+	/* a walk can pick up where it left off */
+	if (s->find && (s->find->dir || s->find->head < s->find->tail))
+	    s->find->timer = addFormTimer(form, 1, 1, fs_find, s->self);
+    }
+    return 0;
+} /* setFileSelectorForm */
+
+
+/*
+ * fileSelectorPath() returns the selection
+ */
+char *
+fileSelectorPath(ndObject o)
+{
+    if (o == 0 || objType(o) != W_FILESEL) {
+	errno = EINVAL;
+	return 0;
+    }
+    return FS(o)->result;
+} /* fileSelectorPath */
+
+
+/*
+ * fileSelectorSort() returns the order the lists are sorted in
+ */
+int
+fileSelectorSort(ndObject o)
+{
+    if (o == 0 || objType(o) != W_FILESEL) {
+	errno = EINVAL;
+	return -1;
+    }
+    return FS(o)->sort;
+} /* fileSelectorSort */
+
+
+/*
+ * setFileSelectorSort() changes the order the lists are sorted in
+ */
+int
+setFileSelectorSort(ndObject o, int sort)
+{
+    Selector *s;
+
+    if (o == 0 || objType(o) != W_FILESEL || sort < 0 || sort >= FS_NRSORTS) {
+	errno = EINVAL;
+	return -1;
+    }
+    s = FS(o);
+    s->sort = sort;
+    if (s->shown)
+	showEntries(s, 0);
+    return 0;
+} /* setFileSelectorSort */
+
+
+/*
+ * fileSelectorFind() tells whether a file selector is in find mode
+ */
+int
+fileSelectorFind(ndObject o)
+{
+    if (o == 0 || objType(o) != W_FILESEL) {
+	errno = EINVAL;
+	return -1;
+    }
+    return FS(o)->find != 0;
+} /* fileSelectorFind */
+
+
+/*
+ * setFileSelectorFind() puts a file selector into find mode, where the
+ * selection is a query for the files anywhere under the current
+ * directory, or takes it out again.
+ */
+int
+setFileSelectorFind(ndObject o, int on)
+{
+    Selector *s;
+    Finder *f;
+
+    if (o == 0 || objType(o) != W_FILESEL) {
+	errno = EINVAL;
+	return -1;
+    }
+    s = FS(o);
+
+    if (on && s->find == 0) {
+	if ((f = calloc(1, sizeof *f)) == 0)
+	    return -1;
+	if ((f->items = calloc(FS_SHOW, sizeof f->items[0])) == 0) {
+	    free(f);
+	    return -1;
 	}
-	else if (*pattern == '*') {	/* expand * to .* */
-	    *p++ = '.';
-	    *p++ = *pattern++;
+	f->timer = -1;
+	s->find = f;
+
+	s->result[0] = 0;
+	setObjCursor(s->selection, 0);
+	if (s->shown)
+	    startFind(s);
+    }
+    else if (!on && s->find) {
+	freeFinder(s);
+	populateSelector(s, 0);
+    }
+    return 0;
+} /* setFileSelectorFind */
+
+
+/*
+ * drawFileSelector() draws a file selector, reading the directory
+ * first if nothing has yet
+ */
+DYN_STATIC void
+drawFileSelector(void *o, void *w)
+{
+    Selector *s;
+
+    if (o == 0 || objType(o) != W_FILESEL)
+	return;
+    s = FS(o);
+
+    if (s->shown == 0)
+	populateSelector(s, 0);
+
+    drawString(s->selection, w);
+    drawList(s->dirlist, w);
+    drawList(s->filelist, w);
+} /* drawFileSelector */
+
+
+/*
+ * deleteFileSelector() does what you'd expect it to.
+ */
+DYN_STATIC void
+deleteFileSelector(ndObject o)
+{
+    Selector *s;
+    int ix;
+
+    if (o == 0 || objType(o) != W_FILESEL)
+	return;
+
+    if ((s = FS(o)) != 0) {
+	if (s->form)
+	    setFileSelectorForm(o, 0);
+	if (s->selection)
+	    deleteObj(s->selection);
+	if (s->dirlist)
+	    deleteObj(s->dirlist);
+	if (s->filelist)
+	    deleteObj(s->filelist);
+	if (s->find)
+	    freeFinder(s);
+	if (s->provider) {
+	    stopScan(s);
+	    for (ix = 0; ix < FS_CACHE; ix++)
+		release(s, &s->cache[ix]);
 	}
-	else if (*pattern == '?') {	/* ? maps to . */
-	    *p++ = '.';
-	    pattern++;
+	if (s->ownctx)
+	    freePosix(s->ctx);
+	if (s->compiled)
+	    regfree(&s->re);
+	if (s->curdir)
+	    free(s->curdir);
+	free(s);
+    }
+} /* deleteFileSelector */
+
+
+/*
+ * editFileSelector() lets the user move around a file selector.  Like
+ * the indexed menu, this is a little MENU() edit loop split into a
+ * start function, a key function, and fssettle() to deal with whatever
+ * the active object returns.
+ */
+#define NROBJS	3/* selection, dirlist, filelist */
+
+/*
+ * fssettle() moves to (and starts) the next or previous object, or
+ * returns the editCode that takes us out of the file selector.  It
+ * returns eNOP if an object is waiting for keys.
+ */
+static editCode
+fssettle(Obj *obj, void *w, MEVENT *mev, editCode cc)
+{
+    Selector *s = FS(obj);
+    Obj* objs[NROBJS];
+    int idx = s->which;
+
+    objs[0] = s->selection;
+    objs[1] = s->dirlist;
+    objs[2] = s->filelist;
+
+    while (cc != eNOP) {
+	int incr = 0;
+
+	switch (cc) {
+	case eTAB:
+	case eRETURN:
+		incr = 1;
+		break;
+	case eBACKTAB:
+		incr = -1;
+		break;
+
+	case eEVENT:
+	case eREFRESH:
+	case eEXITFORM:
+	case eESCAPE:
+		drawObj(obj, w);
+		goto byebye;
+
+	case eERROR:
+		Error("fileselector");
+		incr = 1;
+		break;
+	default:
+		incr = 0;
+		break;
 	}
-	else if (*pattern == '.') {	/* . expands to \. */
-	    *p++ = '\\';
-	    *p++ = *pattern++;
+	drawObj(obj, w);
+
+	if (incr) {
+	    /* empty lists are passed by */
+	    do
+		idx += incr;
+	    while (idx > 0 && idx < NROBJS && OBJ_READONLY(objs[idx]));
+
+	    if (idx < 0 || idx >= NROBJS) {
+		idx = (idx < 0) ? 0 : NROBJS-1;
+		break;
+	    }
+	    cc = (incr > 0) ? eTAB : eBACKTAB;
 	}
-	else				/* pass everything else */
-	    *p++ = *pattern++;
+	cc = _nd_startObj(objs[idx], w, mev, cc);
     }
-    *p = 0;
+byebye:
+    s->which = idx;
+    return cc;
+} /* fssettle */
 
-    selector.szcurdir = 1024;
-    selector.curdir = strdup(dir);
-    memset(selector.result, 0, sizeof selector.result);
 
-    populateSelector(0);
+DYN_STATIC editCode
+startFileSelector(void* o, void* w, MEVENT *mev, editCode cc)
+{
+    Obj *obj = OBJ(o);
+    Selector *s;
+    Obj* objs[NROBJS];
+    int idx;
+
+    if (o == 0 || objType(o) != W_FILESEL) {
+	errno = EINVAL;
+	return eERROR;
+    }
+    s = FS(obj);
 
-    
-    rc = MENU(chain,-1,-1,title ? title : "File selector",0,0);
+    /* build our little navigation array */
+    objs[0] = s->selection;
+    objs[1] = s->dirlist;
+    objs[2] = s->filelist;
 
-    deleteObjChain(chain);
+    /* set the initial position in the widget */
+    switch (cc) {
+#ifdef VERMIN
+    case eEVENT:	/* mouse click */
+	    for (idx=0; idx<NROBJS; idx++)
+		if (_nd_inside(objs[idx], mev))
+		    break;
+	    if (idx == NROBJS)
+		idx = s->which;
+	    break;
+#endif
+    case eBACKTAB:	/* backtab */
+	    for (idx = NROBJS-1; idx > 0 && OBJ_READONLY(objs[idx]); --idx)
+		;
+	    break;
+    case eTAB:		/* tab */
+	    idx = 0;
+	    break;
+    default:
+	    idx = s->which;
+	    break;
+    }
+    s->which = idx;
+
+    return fssettle(obj, w, mev, _nd_startObj(objs[idx], w, mev, cc));
+} /* startFileSelector */
+
+
+DYN_STATIC editCode
+keyFileSelector(void* o, void* w, int c)
+{
+    Selector *s = FS(o);
+    Obj *current = (s->which == 0) ? s->selection
+				   : (s->which == 1) ? s->dirlist
+						     : s->filelist;
+    editCode cc = _nd_keyObj(current, w, c);
+
+    /* in find mode, the matches follow the query as it's typed */
+    if (s->find && strcmp(s->result, s->find->query) != 0) {
+	refind(s, 0);
+	drawObj(s->filelist, w);
+    }
+    return fssettle(OBJ(o), w, 0, cc);
+} /* keyFileSelector */
+
+
+DYN_STATIC editCode
+editFileSelector(void* o, void* w, MEVENT *mev, editCode cc)
+{
+    return _nd_editKeys(o, w, mev, cc, (nd_start)startFileSelector,
+				       (nd_key)keyFileSelector);
+} /* editFileSelector */
+
+
+/* the sort button says how the lists are sorted
+ */
+static char *sortnames[FS_NRSORTS] = {
+    "Sort:Name   ", "Sort:Natural", "Sort:Time   ", "Sort:Size   "
+};
+
+
+/*
+ * fs_picked() leaves the form when a file is picked
+ */
+static int
+fs_picked(ndObject obj, ndDisplay display)
+{
+    return -1;
+} /* fs_picked */
+
+
+#if DIRECTORY_SELECT_ONLY
+/*
+ * fs_ok_cb() checks the selection before leaving the form
+ */
+static int
+fs_ok_cb(ndObject obj, ndDisplay display)
+{
+    return fs_sel_cb(FS(getUserData(obj))->selection, display);
+} /* fs_ok_cb */
+#endif
+
+
+/*
+ * fs_sort_cb() changes the order the lists are sorted in
+ */
+static int
+fs_sort_cb(ndObject obj, ndDisplay display)
+{
+    ndObject fs = getUserData(obj);
+    int sort = (fileSelectorSort(fs) + 1) % FS_NRSORTS;
+
+    setFileSelectorSort(fs, sort);
+    setObjTitle(obj, sortnames[sort]);
+
+    drawObj(fs, display);
+    drawObj(obj, display);
+    return 0;
+} /* fs_sort_cb */
+
+
+/*
+ * fs_find_cb() switches between browsing and finding
+ */
+static int
+fs_find_cb(ndObject obj, ndDisplay display)
+{
+    ndObject fs = getUserData(obj);
+    int find = !fileSelectorFind(fs);
+
+    setFileSelectorFind(fs, find);
+    setObjTitle(obj, find ? "Browse" : "Find  ");
+
+    drawObj(fs, display);
+    drawObj(obj, display);
+    return 0;
+} /* fs_find_cb */
+
+
+/*
+ * fileselectorFrom() pops up a file selection box on the directories a
+ *                    provider gives it, and returns the selection (which
+ *                    the caller should free()) or 0 if it was cancelled.
+ */
+char *
+fileselectorFrom(int width, int depth, char *title, char *pattern, char *dir,
+		 ndDirProvider *provider, void *ctx)
+{
+    ndObject chain, fs, button;
+    ndForm form;
+    char *ret;
+    int rc;
+
+    if ((fs = newFileSelector(0, 0, width, depth, dir, pattern,
+					provider, ctx, fs_picked, 0)) == 0)
+	return 0;
+    chain = fs;
+
+#if DIRECTORY_SELECT_ONLY
+    if ((button = newOKButton(0, "OK", fs_ok_cb, 0)) != 0) {
+	setUserData(button, fs);
+	chain = ObjChain(chain, button);
+    }
+#endif
+    chain = ObjChain(chain, newCancelButton(1, "Cancel", 0, 0));
+    if ((button = newButton(2, sortnames[FS_BYNAME], fs_sort_cb, 0)) != 0) {
+	setUserData(button, fs);
+	chain = ObjChain(chain, button);
+    }
+    if ((button = newButton(3, "Find  ", fs_find_cb, 0)) != 0) {
+	setUserData(button, fs);
+	chain = ObjChain(chain, button);
+    }
+
+    if ((form = compileForm(chain,-1,-1,title ? title : "File selector",0,0)) != 0) {
+	setFileSelectorForm(fs, form);
+	rc = runForm(form);
+	setFileSelectorForm(fs, 0);
+	deleteForm(form);
+    }
+    else
+	rc = MENU_ERROR;
 
     if (rc == MENU_OK)
-	ret = strdup(selector.result);
+	ret = strdup(fileSelectorPath(fs));
     else
 	ret = 0;
 
-    /* wipe out the contents of the selector
-     */
-    deleteLIA(selector.directories);
-    deleteLIA(selector.files);
-    if (selector.pattern)
-	free(selector.pattern);
-    if (selector.curdir)
-	free(selector.curdir);
-
+    deleteObjChain(chain);
     return ret;
+} /* fileselectorFrom */
+
+
+/*
+ * fileselector() pops up a file selection box on the filesystem
+ */
+char *
+fileselector(int width, int depth, char *title, char *pattern, char *dir)
+{
+    return fileselectorFrom(width, depth, title, pattern, dir, 0, 0);
 } /* fileselector */
 
 
 #ifdef TEST
 int
-main()
+main(int argc, char **argv)
 {
     char *res;
     char here[1024];
+    void *manifest = 0;
+
+    /* fs manifest browses a manifest instead of the filesystem */
+    if (argc > 1 && (manifest = openManifest(argv[1])) == 0) {
+	perror(argv[1]);
+	exit(1);
+    }
 
     init_dialog();
-    getcwd(here, sizeof here);
-    res = fileselector(50,18,"Test", "*.c", here);
+    if (manifest)
+	res = fileselectorFrom(50,18,"Test", "*.c", "/",
+				&ndManifestProvider, manifest);
+    else {
+	getcwd(here, sizeof here);
+	res = fileselector(50,18,"Test", "*.c", here);
+    }
     end_dialog();
 
     if (res)
 	puts(res);
+    if (manifest)
+	closeManifest(manifest);
     adump();
     exit(0);
 }
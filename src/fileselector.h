@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 1996-2017 David L Parsons.
+ * The redistribution terms are provided in the COPYRIGHT file that must
+ * be distributed with this source code.
+ */
+#ifndef __FILESELECTOR_D
+#define __FILESELECTOR_D
+
+#include <ndialog.h>
+#include <sys/types.h>
+#include <time.h>
+
+/* A file selector gets its directories from a directory provider.  If
+ * it isn't given one, it reads the filesystem.
+ */
+typedef struct {
+    void *(*open)(void *ctx, char *dir);
+		/* start reading a directory;  return a handle for it,
+		 * or 0 if it can't be read (required) */
+    char *(*read)(void *ctx, void *handle, int *isdir);
+		/* return the next entry in the directory (the name only
+		 * has to last until the next call) and set *isdir to 1 if
+		 * it's a directory, 2 if it's a link to one (which find
+		 * mode won't walk into), 0 if it isn't, or -1 if it
+		 * shouldn't be shown;  return 0 at the end of the
+		 * directory (required) */
+    void (*close)(void *ctx, void *handle);
+		/* done reading a directory (required) */
+    int (*stat)(void *ctx, char *dir, char *name, off_t *size,
+						  time_t *mtime);
+		/* get the size and mtime of an entry for sorting;
+		 * return 0, or -1 if it can't (optional) */
+    void *(*watch)(void *ctx, char *dir);
+		/* start watching a directory that's about to be read
+		 * (optional;  without it, directories never change) */
+    int (*changed)(void *ctx, void *watch);
+		/* has a watched directory changed? */
+    void (*unwatch)(void *ctx, void *watch);
+		/* stop watching it */
+    int (*exists)(void *ctx, char *path);
+		/* does this path exist?  (optional;  without it, any
+		 * selection is accepted) */
+} ndDirProvider;
+
+/* the orders a file selector can sort its lists in
+ */
+enum { FS_BYNAME, FS_NATURAL, FS_BYTIME, FS_BYSIZE, FS_NRSORTS };
+
+ndObject newFileSelector(int x, int y, int width, int depth,
+			 char *dir, char *pattern,
+			 ndDirProvider *provider, void *ctx,
+			 pfo callback, char *help);
+int setFileSelectorForm(ndObject obj, ndForm form);
+char *fileSelectorPath(ndObject obj);
+int fileSelectorSort(ndObject obj);
+int setFileSelectorSort(ndObject obj, int sort);
+int fileSelectorFind(ndObject obj);
+int setFileSelectorFind(ndObject obj, int on);
+
+char *fileselector(int width, int depth, char *title, char *pattern,
+		   char *dir);
+char *fileselectorFrom(int width, int depth, char *title, char *pattern,
+		       char *dir, ndDirProvider *provider, void *ctx);
+
+/* A manifest is a sorted list of the paths in a tree, one to a line
+ * (with directories ending in /, if they're listed at all), so a file
+ * selector can browse the tree without going near it.
+ */
+extern ndDirProvider ndManifestProvider;
+
+void *openManifest(char *file);
+void closeManifest(void *manifest);
+
+#endif/*__FILESELECTOR_D*/
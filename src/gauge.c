@@ -0,0 +1,232 @@
+/*
+ * gauge: a progress gauge that stays on the screen between updates
+ *
+ * Copyright (C) 1996-2017 David L Parsons.
+ * The redistribution terms are provided in the COPYRIGHT file that must
+ * be distributed with this source code.
+ */
+#include <config.h>
+
+#include "ndwin.h"
+#include "nd_objects.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/time.h>
+
+/* dialog_gauge() builds a form, draws it, and tears it down every time
+ * it's called, which is fine for a handful of updates but hopeless if
+ * you're feeding it from a tight loop.   A Gauge keeps the form open
+ * and only repaints when what it displays actually changes, and then
+ * no more often than every GAUGE_DELAY microseconds.
+ */
+#define GAUGE_DELAY	50000
+
+extern int strwidth(char*);
+extern int strdepth(char*);
+
+typedef struct {
+    void *form;			/* the form (from _nd_newForm) */
+    void *chain;		/* the gauge object, all by itself */
+    int percent;		/* what the gauge object points at */
+    int shown;			/* percentage currently on the screen */
+    int pending;		/* something needs to be repainted */
+    int newprompt;		/* .. and it's the prompt */
+    int nlines;			/* lines reserved for the prompt */
+    int cols;			/* columns reserved for the prompt */
+    char *prompt;		/* the prompt, padded out to nlines */
+    char *work;			/* scratch space for setprompt() */
+    struct timeval last;	/* when we last repainted */
+} Gauge;
+
+
+/*
+ * setprompt() copies a message into the gauge prompt, clipping it to the
+ * area that was reserved when the gauge was opened.  It returns 1 if the
+ * prompt changed, 0 if it didn't.
+ */
+static int
+setprompt(Gauge *g, char *msg)
+{
+    char *p = g->work;
+    int x, y;
+
+    for (y = 0; y < g->nlines; y++) {
+	for (x = 0; msg && *msg && *msg != '\n'; msg++)
+	    if (x < g->cols) {
+		*p++ = (*msg == '\t') ? ' ' : *msg;
+		x++;
+	    }
+	if (msg && *msg == '\n')
+	    msg++;
+	if (y < g->nlines-1)
+	    *p++ = '\n';
+    }
+    *p = 0;
+
+    if (strcmp(g->work, g->prompt) == 0)
+	return 0;
+    strcpy(g->prompt, g->work);
+    return 1;
+} /* setprompt */
+
+
+/*
+ * repaint() puts the current state of the gauge on the screen.  If only
+ * the percentage changed, we only redraw the bar.
+ */
+static void
+repaint(Gauge *g)
+{
+    Display *display = _nd_formDisplay(g->form);
+
+    if (g->newprompt)
+	_nd_setFormPrompt(g->form, g->prompt);
+    else
+	drawObj(g->chain, display);
+    wrefresh(Window(display));
+
+    g->shown = g->percent;
+    g->pending = g->newprompt = 0;
+    gettimeofday(&g->last, 0);
+} /* repaint */
+
+
+/*
+ * openGauge() puts up a gauge window and leaves it there until
+ * closeGauge() is called.  It expects
+ *	title	-- the title of the window
+ *	prompt	-- the text above the gauge
+ *	height	-- how many lines to reserve for the prompt (the prompt
+ *		   will never be given fewer lines than it starts with)
+ *	width	-- how wide the gauge is
+ *
+ * It returns a gauge handle, or 0 (with errno set) if it couldn't
+ * make one.
+ */
+ndGauge
+openGauge(char *title, char *prompt, int height, int width)
+{
+    Gauge *g;
+
+    if (width < 1 || width > COLS-4) {
+	errno = EINVAL;
+	return 0;
+    }
+
+    if ((g = calloc(1, sizeof *g)) == 0)
+	return 0;
+
+    g->nlines = strdepth(prompt);
+    if (g->nlines < height)
+	g->nlines = height;
+    g->cols = strwidth(prompt);
+    if (g->cols < width)
+	g->cols = width;
+    if (g->cols > COLS-4)
+	g->cols = COLS-4;
+
+    g->prompt = calloc(2, g->nlines * (g->cols+1) + 1);
+    g->chain = ObjChain(0, newGauge(-1, 0, width, &g->percent, 0, ""));
+
+    if (g->prompt && g->chain) {
+	g->work = g->prompt + g->nlines * (g->cols+1) + 1;
+	setprompt(g, prompt);
+	if ((g->form = _nd_newForm(g->chain, -1, -1, title,
+					g->nlines ? g->prompt : 0, 0)) != 0) {
+	    wrefresh(Window(_nd_formDisplay(g->form)));
+	    gettimeofday(&g->last, 0);
+	    return g;
+	}
+    }
+    if (g->chain)
+	deleteObjChain(g->chain);
+    if (g->prompt)
+	free(g->prompt);
+    free(g);
+    return 0;
+} /* openGauge */
+
+
+/*
+ * updateGauge() sets the gauge to a new percentage and (if prompt is
+ * not null) a new prompt.  Nothing is repainted unless something that
+ * shows on the screen has changed, and if the last repaint was too
+ * recent the new state is held back until the next update or until
+ * flushGauge() is called.
+ *
+ * It returns 1 if there's an update waiting to be painted, 0 if the
+ * screen is up to date, and -1 if the gauge handle is bad.
+ */
+int
+updateGauge(ndGauge o, int percent, char *prompt)
+{
+    Gauge *g = (Gauge*)o;
+    struct timeval now;
+    long elapsed;
+
+    if (g == 0) {
+	errno = EINVAL;
+	return -1;
+    }
+
+    if (percent < 0)
+	percent = 0;
+    else if (percent > 100)
+	percent = 100;
+
+    if (prompt && g->nlines && setprompt(g, prompt))
+	g->pending = g->newprompt = 1;
+    if (percent != g->shown)
+	g->pending = 1;
+    g->percent = percent;
+
+    if (!g->pending)
+	return 0;
+
+    gettimeofday(&now, 0);
+    elapsed = (now.tv_sec - g->last.tv_sec) * 1000000L
+	    + (now.tv_usec - g->last.tv_usec);
+    if (elapsed >= 0 && elapsed < GAUGE_DELAY)
+	return 1;
+
+    repaint(g);
+    return 0;
+} /* updateGauge */
+
+
+/*
+ * flushGauge() paints any update that updateGauge() held back.
+ */
+int
+flushGauge(ndGauge o)
+{
+    Gauge *g = (Gauge*)o;
+
+    if (g == 0) {
+	errno = EINVAL;
+	return -1;
+    }
+    if (g->pending)
+	repaint(g);
+    return 0;
+} /* flushGauge */
+
+
+/*
+ * closeGauge() takes the gauge off the screen and frees it.
+ */
+void
+closeGauge(ndGauge o)
+{
+    Gauge *g = (Gauge*)o;
+
+    if (g == 0)
+	return;
+
+    _nd_deleteForm(g->form);
+    deleteObjChain(g->chain);
+    free(g->prompt);
+    free(g);
+} /* closeGauge */
@@ -0,0 +1,189 @@
+/*
+ * hitgrid: find the object on a form that a mouse click landed in
+ *
+ * Copyright (C) 1996-2017 David L Parsons.
+ * The redistribution terms are provided in the COPYRIGHT file that must
+ * be distributed with this source code.
+ */
+#include <config.h>
+
+#include "ndwin.h"
+#include "nd_objects.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/* Rather than asking every object on a form whether a click is inside it,
+ * MENU() drops the selection areas of the objects into a grid of cells
+ * HITCELL columns wide and one line deep.  A click then only needs to
+ * look at the handful of objects that overlap the cell it's in.
+ *
+ * Whether an object is hidden or readonly is left for _nd_inside() to
+ * decide when the click happens, so the grid only needs to be rebuilt
+ * if an object moves.  Anything that moves an object after the form is
+ * laid out bumps _nd_geometry, and the grid notices it's stale the next
+ * time it's used.
+ */
+#define HITCELL	8
+
+typedef struct {
+    int x0, y0;		/* top left corner of the gridded area */
+    int cols, rows;	/* size of the grid, in cells */
+    int *first;		/* hits[first[cell]] .. hits[first[cell+1]-1] */
+    int *hits;		/* items[] indexes, cell by cell */
+    int geometry;	/* _nd_geometry when this grid was built */
+} HitGrid;
+
+
+/*
+ * _nd_freeHitGrid() throws away a hit grid
+ */
+void
+_nd_freeHitGrid(void *o)
+{
+    HitGrid *g = (HitGrid*)o;
+
+    if (g) {
+	if (g->first) free(g->first);
+	if (g->hits) free(g->hits);
+	free(g);
+    }
+} /* _nd_freeHitGrid */
+
+
+#if VERMIN
+/*
+ * cells() works out which cells an object's selection area covers
+ */
+static int
+cells(HitGrid *g, Obj *o, int *x0, int *y0, int *x1, int *y1)
+{
+    if (o->selwidth <= 0 || o->seldepth <= 0)
+	return 0;
+
+    *x0 = (o->selx - g->x0) / HITCELL;
+    *x1 = (o->selx + o->selwidth - 1 - g->x0) / HITCELL;
+    *y0 = o->sely - g->y0;
+    *y1 = o->sely + o->seldepth - 1 - g->y0;
+    return 1;
+} /* cells */
+
+
+/*
+ * newHitGrid() builds a hit grid for an items[] array.  Objects are
+ * put into each cell in items[] order, so a lookup finds the same object
+ * that a walk down items[] would.
+ */
+static HitGrid *
+newHitGrid(Obj **items, int nritems)
+{
+    HitGrid *g;
+    int ix, x, y, x0, y0, x1, y1;
+    int maxx = 0, maxy = 0, ncells, nrhits;
+    int *fill;
+
+    if ((g = calloc(1, sizeof *g)) == 0)
+	return 0;
+
+    g->geometry = _nd_geometry;
+
+    /* find the area that the objects cover
+     */
+    for (nrhits = ix = 0; ix < nritems; ix++) {
+	Obj *o = items[ix];
+
+	if (o->selwidth <= 0 || o->seldepth <= 0)
+	    continue;
+
+	if (nrhits == 0 || o->selx < g->x0) g->x0 = o->selx;
+	if (nrhits == 0 || o->sely < g->y0) g->y0 = o->sely;
+	if (nrhits == 0 || o->selx + o->selwidth > maxx)
+	    maxx = o->selx + o->selwidth;
+	if (nrhits == 0 || o->sely + o->seldepth > maxy)
+	    maxy = o->sely + o->seldepth;
+	nrhits++;
+    }
+    if (nrhits == 0)
+	return g;
+
+    g->cols = (maxx - g->x0 + HITCELL - 1) / HITCELL;
+    g->rows = maxy - g->y0;
+    ncells = g->cols * g->rows;
+
+    if ((g->first = calloc(ncells + 1, sizeof g->first[0])) == 0
+		    || (fill = calloc(ncells, sizeof fill[0])) == 0) {
+	_nd_freeHitGrid(g);
+	return 0;
+    }
+
+    /* count how many objects land in each cell, then carve up hits[]
+     */
+    for (ix = 0; ix < nritems; ix++)
+	if (cells(g, items[ix], &x0, &y0, &x1, &y1))
+	    for (y = y0; y <= y1; y++)
+		for (x = x0; x <= x1; x++)
+		    g->first[1 + y*g->cols + x]++;
+
+    for (ix = 0; ix < ncells; ix++) {
+	g->first[ix+1] += g->first[ix];
+	fill[ix] = g->first[ix];
+    }
+
+    if ((g->hits = malloc((1+g->first[ncells]) * sizeof g->hits[0])) == 0) {
+	free(fill);
+	_nd_freeHitGrid(g);
+	return 0;
+    }
+
+    for (ix = 0; ix < nritems; ix++)
+	if (cells(g, items[ix], &x0, &y0, &x1, &y1))
+	    for (y = y0; y <= y1; y++)
+		for (x = x0; x <= x1; x++)
+		    g->hits[fill[y*g->cols + x]++] = ix;
+
+    free(fill);
+    return g;
+} /* newHitGrid */
+#endif
+
+
+/*
+ * _nd_hitTest() returns the index of the first object in items[] (other
+ * than items[skip]) that the mouse event is inside, or -1 if it's not in
+ * any of them.  The grid is (re)built in *grid if it's not there yet or
+ * if objects have moved since it was built;  if it can't be built, we
+ * fall back to asking every object.
+ */
+int
+_nd_hitTest(void **grid, Obj **items, int nritems, int skip, MEVENT *m)
+{
+#if VERMIN
+    HitGrid *g = (HitGrid*)(*grid);
+    int x, y, ix, cell;
+
+    if (g && g->geometry != _nd_geometry) {
+	_nd_freeHitGrid(g);
+	g = 0;
+    }
+    if (g == 0)
+	*grid = g = newHitGrid(items, nritems);
+
+    if (g == 0) {
+	for (ix = 0; ix < nritems; ix++)
+	    if (ix != skip && _nd_inside(items[ix], m))
+		return ix;
+	return -1;
+    }
+
+    x = m->x - g->x0;
+    y = m->y - g->y0;
+    if (x < 0 || y < 0 || y >= g->rows || x >= g->cols * HITCELL)
+	return -1;
+
+    cell = y * g->cols + (x / HITCELL);
+    for (ix = g->first[cell]; ix < g->first[cell+1]; ix++)
+	if (g->hits[ix] != skip && _nd_inside(items[g->hits[ix]], m))
+	    return g->hits[ix];
+#endif
+    return -1;
+} /* _nd_hitTest */
@@ -23,6 +23,7 @@
 #include "curse.h"
 #include "dialog.h"
 #include "ndwin.h"
+#include "indexed_menu.h"
 #include <errno.h>
 #include <stdlib.h>
 #include <string.h>
@@ -35,6 +36,8 @@
 DYN_STATIC void drawIndexedMenu(void *o, void *w);
 DYN_STATIC void deleteIndexedMenu(ndObject o);
 DYN_STATIC editCode editIndexedMenu(void* o, void* w, MEVENT *mev, editCode cc);
+DYN_STATIC editCode startIndexedMenu(void* o, void* w, MEVENT *mev, editCode cc);
+DYN_STATIC editCode keyIndexedMenu(void* o, void* w, int c);
 
 static int listType = O_ERROR;
 #define W_IMENU	listType
@@ -45,6 +48,16 @@ static int listType = O_ERROR;
 
 #endif
 
+/* a lazy indexed menu keeps the last few submenus it asked for
+ */
+#define IM_CACHE	8
+
+typedef struct {
+    int index;		/* the index row this is the submenu for, or -1 */
+    LIA menu;		/* the submenu (0 if the row doesn't have one) */
+    unsigned long used;	/* when we last looked at it */
+} Submenu;
+
 /* our generic object class */
 typedef struct {
     Obj *index;		/* the index menu */
@@ -53,6 +66,12 @@ typedef struct {
     int mkey;		/* and currently selected menu */
     int which_list;	/* 0=index, 1=menu */
     pfo callback;	/* user-supplied callback */
+    int shown;		/* index row whose submenu is showing, or -1 */
+    ndSubmenuProvider *provider;
+			/* where a lazy menu gets its submenus */
+    void *ctx;		/* passed to the provider */
+    Submenu cache[IM_CACHE];
+    unsigned long clock;/* for finding the least recently used submenu */
 } Imenu;
 
 static int indexselector(ndObject obj, ndDisplay win);
@@ -60,13 +79,93 @@ static int menuselector (ndObject obj, ndDisplay win);
 
 
 /*
- * newIndexedMenu() creates a new (ta dah!) indexed menu.
+ * release() gives a cached submenu back to the provider
+ */
+static void
+release(Imenu *local, Submenu *sub)
+{
+    if (sub->menu) {
+	if (local->provider->release)
+	    (*local->provider->release)(local->ctx, sub->index, sub->menu);
+	else
+	    deleteLIA(sub->menu);
+    }
+    sub->index = -1;
+    sub->menu = 0;
+} /* release */
+
+
+/*
+ * submenu() returns the submenu for an index row.  A lazy menu looks in
+ * its cache first, and only asks the provider (throwing away the least
+ * recently used submenu that isn't showing) if it isn't there.
+ */
+static LIA
+submenu(Imenu *local, int ix)
+{
+    ListItem *items = getObjList(local->index);
+    Submenu *sub, *victim = 0;
+    int i;
+
+    if (items == 0 || ix < 0 || ix >= getObjListSize(local->index))
+	return 0;
+
+    if (local->provider == 0)
+	return (LIA)(items[ix].id);
+
+    for (i = 0; i < IM_CACHE; i++) {
+	sub = &local->cache[i];
+	if (sub->index == ix) {
+	    sub->used = ++local->clock;
+	    return sub->menu;
+	}
+	if (sub->index == local->shown && sub->index >= 0)
+	    continue;
+	if (victim == 0 || sub->used < victim->used)
+	    victim = sub;
+    }
+
+    release(local, victim);
+    victim->menu = (*local->provider->submenu)(local->ctx, ix);
+    victim->index = ix;
+    victim->used = ++local->clock;
+    return victim->menu;
+} /* submenu */
+
+
+/*
+ * showSubmenu() puts the submenu for an index row into the menu list,
+ * unless it's already there
+ */
+static void
+showSubmenu(Imenu *local, int ix, int force)
+{
+    LIA sub;
+
+    if (ix == local->shown && local->provider && !force)
+	return;
+
+    sub = submenu(local, ix);
+
+    if (force || LIAlist(sub) != getObjList(local->menu)
+	      || LIAcount(sub) != getObjListSize(local->menu)) {
+	setObjData(local->menu, 0, LIAlist(sub), LIAcount(sub));
+	if (ix == local->ikey)
+	    setObjCursor(local->menu, local->mkey);
+    }
+    local->shown = ix;
+} /* showSubmenu */
+
+
+/*
+ * imenu() creates a new (ta dah!) indexed menu.
  * width and depth are the dimensions of the list box; the other dimensions
  * are computed automagically.
  */
-ndObject
-newIndexedMenu(int x, int y, int width, int depth, int indexwidth, LIA list,
-	      char* prompt, pfo select_callback, char *help)
+static ndObject
+imenu(int x, int y, int width, int depth, int indexwidth, LIA list,
+      ndSubmenuProvider *provider, void *ctx,
+      char* prompt, pfo select_callback, char *help)
 {
     Obj* tmp;
     Imenu* local;
@@ -84,9 +183,11 @@ newIndexedMenu(int x, int y, int width, int depth, int indexwidth, LIA list,
 
     width -= 4; /* compensate for frames */
 
-    /* automatically size the index width */
+    /* automatically size the index width;  once an item is too wide
+     * to fit, there's no point in looking at the rest of them.
+     */
     if (indexwidth < 0) {
-	for (idx = 0; idx < LIAcount(list); idx++)
+	for (idx = 0; idx < LIAcount(list) && indexwidth < width-2; idx++)
 	    if ((l = strlen(LIAlist(list)[idx].item)) > indexwidth)
 		indexwidth = l;
 	indexwidth+=2;
@@ -104,7 +205,9 @@ newIndexedMenu(int x, int y, int width, int depth, int indexwidth, LIA list,
 	static struct _nd_object_table t = { 0, (nd_edit)editIndexedMenu,
 						(nd_draw)drawIndexedMenu,
 						(nd_free)deleteIndexedMenu,
-						0, 0, 0, 0} ;
+						0, 0, 0, 0,
+						(nd_start)startIndexedMenu,
+						(nd_key)keyIndexedMenu } ;
 	W_IMENU = nd_register_objtab(sizeof t, &t);
     }
     if (W_IMENU == -1) {
@@ -137,6 +240,15 @@ newIndexedMenu(int x, int y, int width, int depth, int indexwidth, LIA list,
     local->ikey = local->mkey = 0;
     local->callback = select_callback;
     local->which_list = 0;
+    local->shown = -1;
+    local->provider = provider;
+    local->ctx = ctx;
+    local->clock = 0;
+    for (idx = 0; idx < IM_CACHE; idx++) {
+	local->cache[idx].index = -1;
+	local->cache[idx].menu = 0;
+	local->cache[idx].used = 0;
+    }
 
     local->index = newMenu(x,y, indexwidth-2, depth-2,
 			    LIAcount(list), LIAlist(list),
@@ -155,9 +267,40 @@ newIndexedMenu(int x, int y, int width, int depth, int indexwidth, LIA list,
     local->menu->parent = tmp;
     local->menu->flags |= OBJ_DRAW;
     return tmp;
+} /* imenu */
+
+
+/*
+ * newIndexedMenu() creates an indexed menu where the id of each item in
+ * the index is the LIA for its submenu (or 0 if it doesn't have one.)
+ */
+ndObject
+newIndexedMenu(int x, int y, int width, int depth, int indexwidth, LIA list,
+	      char* prompt, pfo select_callback, char *help)
+{
+    return imenu(x, y, width, depth, indexwidth, list, 0, 0,
+			prompt, select_callback, help);
 } /* newIndexedMenu */
 
 
+/*
+ * newLazyIndexedMenu() creates an indexed menu that asks a provider for
+ * each submenu the first time it's needed
+ */
+ndObject
+newLazyIndexedMenu(int x, int y, int width, int depth, int indexwidth,
+		   LIA list, ndSubmenuProvider *provider, void *ctx,
+		   char* prompt, pfo select_callback, char *help)
+{
+    if (provider == 0 || provider->submenu == 0) {
+	errno = EINVAL;
+	return 0;
+    }
+    return imenu(x, y, width, depth, indexwidth, list, provider, ctx,
+			prompt, select_callback, help);
+} /* newLazyIndexedMenu */
+
+
 /*
  * drawIndexedMenu() draws an indexed menu
  */
@@ -165,24 +308,14 @@ DYN_STATIC void
 drawIndexedMenu(void *o, void *w)
 {
     Obj* obj = OBJ(o);
-    int key;
     Imenu* local;
-    ListItem *menu;
 
     if (o == 0 || objType(o) != W_IMENU)
 	return;
 
     local = (Imenu*)(obj->item.generic);
 
-    menu = getObjList(local->index);
-
-    key = currentSelection(local->index);
-    if (LIAlist(menu[key].id) != getObjList(local->menu)) {
-	setObjData(local->menu, 0, LIAlist(menu[key].id),
-				   LIAcount(menu[key].id));
-	if (key == local->ikey)
-	    setObjCursor(local->menu,  local->mkey);
-    }
+    showSubmenu(local, currentSelection(local->index), 0);
 
     if (obj->title)
 	mvwaddstr(Window(w), obj->y + WY(w), obj->x + WX(w), obj->title);
@@ -217,6 +350,12 @@ deleteIndexedMenu(ndObject o)
 	    deleteObj(local->index);
 	if (local->menu)
 	    deleteObj(local->menu);
+	if (local->provider) {
+	    int i;
+
+	    for (i = 0; i < IM_CACHE; i++)
+		release(local, &local->cache[i]);
+	}
 	free(local);
     }
 } /* deleteIndexedMenu */
@@ -224,59 +363,32 @@ deleteIndexedMenu(ndObject o)
 
 /*
  * editIndexedMenu() lets the user manipulate the contents of an indexed menu.
- * the edit loop here is a smaller version of the MENU() edit loop, which
- * should be abstracted out of MENU() so that everyone can join in the fun.
+ * the edit loop here is a smaller version of the MENU() edit loop, split
+ * (like the list widget's) into a start function, a key function, and
+ * imsettle() to deal with whatever the active list returns.
  */
-DYN_STATIC editCode
-editIndexedMenu(void* o, void* w, MEVENT *mev, editCode cc)
-{
-    Obj *obj = OBJ(o);
-    Imenu *local;
 #define NROBJS	2/* index, menu */
-    Obj* lists[NROBJS];
-    int idx;
 
-    if (o == 0 || objType(o) != W_IMENU) {
-	errno = EINVAL;
-	return eERROR;
-    }
-    local = (Imenu*) (obj->item.generic);
+/*
+ * imsettle() moves to (and starts) the other list, or returns the
+ * editCode that takes us out of the indexed menu.  It returns eNOP if
+ * a list is waiting for keys.
+ */
+static editCode
+imsettle(Obj *obj, void *w, MEVENT *mev, editCode cc)
+{
+    Imenu *local = (Imenu*) (obj->item.generic);
+    Obj* lists[NROBJS];
+    int idx = local->which_list;
 
-    /* build our little navigation array */
     lists[0] = local->index;
     lists[1] = local->menu;
 
-    /* set the initial position in the widget */
-    switch (cc) {
-#ifdef VERMIN
-    case eEVENT:	/* mouse click */
-	    for (idx=0; idx<NROBJS; idx++)
-		if (lists[idx] && _nd_inside(lists[idx], mev))
-		    break;
-	    if (idx == NROBJS)
-		idx = local->which_list;
-	    break;
-#endif
-    case eBACKTAB:	/* backtab */
-	    idx = LIAcount(local->menu) ? 1 : 0;
-	    break;
-    case eTAB:		/* tab */
-	    idx = 0;
-	    break;
-    default:
-	    idx = local->which_list;
-	    break;
-    }
-
-
     /* chomp happily through the indexed menu
      */
-
-    while (1) {
+    while (cc != eNOP) {
 	int incr = 0;
 
-	cc = editObj(lists[idx], w, mev, cc);
-
 	switch (cc) {
 	case eTAB:
 		incr = 1;
@@ -289,7 +401,7 @@ editIndexedMenu(void* o, void* w, MEVENT *mev, editCode cc)
 	case eREFRESH:
 	case eEXITFORM:
 	case eESCAPE:
-		drawObj(o, w);
+		drawObj(obj, w);
 		goto byebye;
 
 	case eERROR:
@@ -305,7 +417,7 @@ editIndexedMenu(void* o, void* w, MEVENT *mev, editCode cc)
 		incr = 0;
 		break;
 	}
-	drawObj(o, w);
+	drawObj(obj, w);
 
 	if (incr > 0) {
 	    if (idx == 1 || getObjListSize(local->menu) == 0)
@@ -317,10 +429,75 @@ editIndexedMenu(void* o, void* w, MEVENT *mev, editCode cc)
 		break;
 	    --idx;
 	}
+	cc = _nd_startObj(lists[idx], w, mev, cc);
     }
 byebye:
     local->which_list = idx;
     return cc;
+} /* imsettle */
+
+
+DYN_STATIC editCode
+startIndexedMenu(void* o, void* w, MEVENT *mev, editCode cc)
+{
+    Obj *obj = OBJ(o);
+    Imenu *local;
+    Obj* lists[NROBJS];
+    int idx;
+
+    if (o == 0 || objType(o) != W_IMENU) {
+	errno = EINVAL;
+	return eERROR;
+    }
+    local = (Imenu*) (obj->item.generic);
+
+    /* build our little navigation array */
+    lists[0] = local->index;
+    lists[1] = local->menu;
+
+    /* set the initial position in the widget */
+    switch (cc) {
+#ifdef VERMIN
+    case eEVENT:	/* mouse click */
+	    for (idx=0; idx<NROBJS; idx++)
+		if (lists[idx] && _nd_inside(lists[idx], mev))
+		    break;
+	    if (idx == NROBJS)
+		idx = local->which_list;
+	    break;
+#endif
+    case eBACKTAB:	/* backtab */
+	    idx = getObjListSize(local->menu) > 0 ? 1 : 0;
+	    break;
+    case eTAB:		/* tab */
+	    idx = 0;
+	    break;
+    default:
+	    idx = local->which_list;
+	    break;
+    }
+    local->which_list = idx;
+
+    return imsettle(obj, w, mev, _nd_startObj(lists[idx], w, mev, cc));
+} /* startIndexedMenu */
+
+
+DYN_STATIC editCode
+keyIndexedMenu(void* o, void* w, int c)
+{
+    Obj *obj = OBJ(o);
+    Imenu *local = (Imenu*) (obj->item.generic);
+    Obj *current = local->which_list ? local->menu : local->index;
+
+    return imsettle(obj, w, 0, _nd_keyObj(current, w, c));
+} /* keyIndexedMenu */
+
+
+DYN_STATIC editCode
+editIndexedMenu(void* o, void* w, MEVENT *mev, editCode cc)
+{
+    return _nd_editKeys(o, w, mev, cc, (nd_start)startIndexedMenu,
+				       (nd_key)keyIndexedMenu);
 } /* editIndexedMenu */
 
 
@@ -331,26 +508,21 @@ byebye:
 static int
 indexselector(ndObject obj, ndDisplay display)
 {
-    ListItem *menu;
     int ix;
     Imenu* local;
 
-    menu = getObjList(obj);
     ix = currentSelection(obj);
 
     local = (Imenu*)(OBJ(obj)->parent->item.generic);
 
-    if (menu[ix].id == 0) {
+    if (submenu(local, ix) == 0) {
 	/* selected something that doesn't have a submenu */
 	local->ikey = ix;
 	local->mkey = 0;
 	return local->callback(OBJ(obj)->parent, display);
     }
 
-    setObjData(local->menu, 0, LIAlist(menu[ix].id), LIAcount(menu[ix].id));
-
-    if (ix == local->ikey)
-	setObjCursor(local->menu, local->mkey);
+    showSubmenu(local, ix, 1);
 
     drawObj(local->menu, display);
     return 1;
@@ -402,7 +574,6 @@ setIndexedMenuSelection(void* o, int ikey, int mkey)
 {
     Obj* obj = OBJ(o);
     Imenu* local;
-    ListItem *midx;
 
     if (o == 0 || objType(o) != W_IMENU) {
 	errno = EINVAL;
@@ -410,15 +581,9 @@ setIndexedMenuSelection(void* o, int ikey, int mkey)
     }
     local = (Imenu*)(obj->item.generic);
     setObjCursor(local->index, local->ikey = ikey);
-    midx = getObjList(local->index);
 
-    if (midx[ikey].id) {
-	setObjData(local->menu, 0, LIAlist(midx[ikey].id),
-				   LIAcount(midx[ikey].id));
-	setObjCursor(local->menu,  local->mkey = mkey);
-    }
-    else
-	setObjData(local->menu, 0, 0, 0);
+    local->mkey = mkey;
+    showSubmenu(local, ikey, 1);
 
     return 0;
 } /* setIndexedMenuSelection */
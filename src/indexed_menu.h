@@ -11,6 +11,24 @@
 ndObject newIndexedMenu(int x, int y, int width, int depth, int indexwidth,
 			LIA list, char* prompt, pfo callback, char* help);
 
+/* A lazy indexed menu doesn't need its submenus until they're looked
+ * at;  it asks a submenu provider for them, and keeps the last few it
+ * was given.
+ */
+typedef struct {
+    LIA (*submenu)(void *ctx, int index);
+		/* return the submenu for an index row, or 0 if it doesn't
+		 * have one (required) */
+    void (*release)(void *ctx, int index, LIA submenu);
+		/* the menu is done with a submenu (optional;  if there
+		 * isn't one, the submenu is deleteLIA()ed) */
+} ndSubmenuProvider;
+
+ndObject newLazyIndexedMenu(int x, int y, int width, int depth,
+			    int indexwidth, LIA list,
+			    ndSubmenuProvider *provider, void *ctx,
+			    char* prompt, pfo callback, char* help);
+
 int getIndexedMenuSelection(ndObject obj, int* ikey, int* mkey);
 int setIndexedMenuSelection(ndObject obj, int ikey, int mkey);
 
@@ -155,7 +155,7 @@ ndwgetch(WINDOW *w)
 again:
     c = wgetch(w);
 
-    if ( key_hash[c/(8*sizeof key_hash[0])] & 1<<(c%(8*sizeof key_hash[0])) ) {
+    if ( c != ERR && key_hash[c/(8*sizeof key_hash[0])] & 1<<(c%(8*sizeof key_hash[0])) ) {
 	/* possible function key */
 
 	ct = 1;
@@ -0,0 +1,123 @@
+/*
+ * time building and tearing down List Arrays
+ */
+#include <config.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "ndialog.h"
+
+#define BATCH	1024
+
+static double
+now()
+{
+    struct timeval tv;
+
+    gettimeofday(&tv, 0);
+    return tv.tv_sec + tv.tv_usec / 1e6;
+} /* now */
+
+
+/*
+ * check() makes sure that a LIA holds what we put into it
+ */
+static int
+check(LIA l, int size)
+{
+    char id[20];
+    int x;
+
+    if (LIAcount(l) != size)
+	return 0;
+    for (x = 0; x < size; x += 1 + size/100) {
+	sprintf(id, "%d", x);
+	if (strcmp(LIAlist(l)[x].id, id) != 0)
+	    return 0;
+    }
+    return 1;
+} /* check */
+
+
+static void
+bench(int size)
+{
+    static ListItem batch[BATCH];
+    static char ids[BATCH][20], items[BATCH][40];
+    LIA l;
+    char id[20], item[40];
+    double t0, add, many, del, teardown;
+    int x, y, ok;
+
+    /* one item at a time */
+    t0 = now();
+    l = newLIA(0, 0);
+    for (x = 0; x < size; x++) {
+	sprintf(id, "%d", x);
+	sprintf(item, "list item number %d", x);
+	addToLIA(l, id, item, 0);
+    }
+    add = now() - t0;
+    ok = check(l, size);
+    deleteLIA(l);
+
+    /* in batches */
+    t0 = now();
+    l = newLIA(0, 0);
+    for (x = 0; x < size; x += y) {
+	for (y = 0; y < BATCH && x+y < size; y++) {
+	    sprintf(ids[y], "%d", x+y);
+	    sprintf(items[y], "list item number %d", x+y);
+	    batch[y].id = ids[y];
+	    batch[y].item = items[y];
+	    batch[y].help = 0;
+	    batch[y].selected = 0;
+	}
+	addManyToLIA(l, batch, y);
+    }
+    many = now() - t0;
+    ok = ok && check(l, size);
+
+    /* throw away the back half, then the rest a batch at a time from
+     * the end (deleting from the front would spend all its time
+     * in memmove() shuffling the survivors down)
+     */
+    t0 = now();
+    delRangeFromLIA(l, size/2, size - size/2);
+    del = now() - t0;
+    ok = ok && check(l, size/2);
+    t0 = now();
+    while ((x = LIAcount(l)) > 0)
+	delRangeFromLIA(l, x > BATCH ? x - BATCH : 0, x > BATCH ? BATCH : x);
+    del += now() - t0;
+
+    t0 = now();
+    deleteLIA(l);
+    teardown = now() - t0;
+
+    printf("%8d %12.4f %12.4f %12.4f %12.4f %s\n",
+		size, add, many, del, teardown, ok ? "" : "FAILED");
+} /* bench */
+
+
+int
+main(int argc, char **argv)
+{
+    int x;
+
+    printf("%8s %12s %12s %12s %12s\n",
+		"items", "addToLIA", "addManyToLIA", "delRange", "deleteLIA");
+
+    if (argc > 1)
+	for (x = 1; x < argc; x++)
+	    bench(atoi(argv[x]));
+    else {
+	bench(1000);
+	bench(100000);
+	bench(1000000);
+    }
+    exit(0);
+}
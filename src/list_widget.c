@@ -38,6 +38,8 @@ static int listwidget_delete(Obj*, void*);
 DYN_STATIC void drawListWidget(void *o, void *w);
 DYN_STATIC void deleteListWidget(ndObject o);
 DYN_STATIC editCode editListWidget(void* o, void* w, MEVENT *mev, editCode cc);
+DYN_STATIC editCode startListWidget(void* o, void* w, MEVENT *mev, editCode cc);
+DYN_STATIC editCode keyListWidget(void* o, void* w, int c);
 
 static int listType = O_ERROR;
 #define W_LIST	listType
@@ -105,7 +107,9 @@ newEditableList(int x, int y, int width, int depth, LIA list,
 	static struct _nd_object_table t = { 0,  (nd_edit)editListWidget,
 						 (nd_draw)drawListWidget,
 						 (nd_free)deleteListWidget,
-						 0, 0, 0, 0 };
+						 0, 0, 0, 0,
+						 (nd_start)startListWidget,
+						 (nd_key)keyListWidget };
 	W_LIST = nd_register_objtab(sizeof t, &t);
     }
     if (W_LIST == -1) {
@@ -416,60 +420,43 @@ listwidget_delete(Obj *obj, void* w)
 
 /*
  * editListWidget() lets the user manipulate the contents of a list widget
- * the edit loop here is a smaller version of the MENU() edit loop, which
- * should be abstracted out of MENU() so that everyone can join in the fun.
+ * the edit loop here is a smaller version of the MENU() edit loop.  It's
+ * broken up into startListWidget(), which picks the part of the widget
+ * to start in, and keyListWidget(), which passes keys to that part;
+ * lwsettle() deals with whatever the active part returns.
  */
-DYN_STATIC editCode
-editListWidget(void* o, void* w, MEVENT *mev, editCode cc)
-{
-    Obj *obj = OBJ(o);
 #define NROBJS	5/* add, add-button, list, update, delete */
-    Obj *lwlist[NROBJS];
-    int idx;
-
-    if (o == 0 || objType(o) != W_LIST) {
-	errno = EINVAL;
-	return eERROR;
-    }
 
+static void
+lwparts(Obj *obj, Obj **lwlist)
+{
     /* build our little navigation array */
     lwlist[lw_A] = obj->item.listwidget.add;
     lwlist[lw_AB]= obj->item.listwidget.addbutton;
     lwlist[lw_L] = obj->item.listwidget.list;
     lwlist[lw_U] = obj->item.listwidget.update;
     lwlist[lw_D] = obj->item.listwidget.delete;
+} /* lwparts */
 
-    /* set the initial position in the widget */
-    switch (cc) {
-#ifdef VERMIN
-    case eEVENT:	/* mouse click */
-	    for (idx=0; idx<NROBJS; idx++)
-		if (lwlist[idx] && _nd_inside(lwlist[idx], mev))
-		    break;
-	    if (idx == NROBJS)
-		idx = obj->item.listwidget.active;
-	    break;
-#endif
-    case eBACKTAB:	/* backtab */
-	    idx = LIAcount(obj->item.listwidget.thelist) ? lw_D : lw_AB;
-	    break;
-    case eTAB:		/* tab */
-	    idx = 0;
-	    break;
-    default:
-	    idx = obj->item.listwidget.active;
-	    break;
-    }
 
+/*
+ * lwsettle() moves to (and starts) another part of the widget, or returns
+ * the editCode that takes us out of the widget.  It returns eNOP if a
+ * part of the widget is waiting for keys.
+ */
+static editCode
+lwsettle(Obj *obj, void *w, MEVENT *mev, editCode cc)
+{
+    Obj *lwlist[NROBJS];
+    int idx = obj->item.listwidget.active;
+
+    lwparts(obj, lwlist);
 
     /* chomp happily through the listwidget
      */
-
-    while (1) {
+    while (cc != eNOP) {
 	int incr;
 
-	cc = editObj(lwlist[idx], w, mev, cc);
-
 	switch (cc) {
 	case eTAB:
 		incr = 1;
@@ -482,7 +469,7 @@ editListWidget(void* o, void* w, MEVENT *mev, editCode cc)
 	case eREFRESH:
 	case eEXITFORM:
 	case eESCAPE:
-		drawObj(o, w);
+		drawObj(obj, w);
 		goto byebye;
 
 	case eERROR:
@@ -494,7 +481,7 @@ editListWidget(void* o, void* w, MEVENT *mev, editCode cc)
 		incr = 0;
 		break;
 	}
-	drawObj(o, w);
+	drawObj(obj, w);
 
 	if (incr > 0) {
 	forward:
@@ -524,10 +511,73 @@ editListWidget(void* o, void* w, MEVENT *mev, editCode cc)
 		    goto backward;
 	    }
 	}
+	cc = _nd_startObj(lwlist[idx], w, mev, cc);
     }
 byebye:
     obj->item.listwidget.active = idx;
     return cc;
+} /* lwsettle */
+
+
+DYN_STATIC editCode
+startListWidget(void* o, void* w, MEVENT *mev, editCode cc)
+{
+    Obj *obj = OBJ(o);
+    Obj *lwlist[NROBJS];
+    int idx;
+
+    if (o == 0 || objType(o) != W_LIST) {
+	errno = EINVAL;
+	return eERROR;
+    }
+
+    lwparts(obj, lwlist);
+
+    /* set the initial position in the widget */
+    switch (cc) {
+#ifdef VERMIN
+    case eEVENT:	/* mouse click */
+	    for (idx=0; idx<NROBJS; idx++)
+		if (lwlist[idx] && _nd_inside(lwlist[idx], mev))
+		    break;
+	    if (idx == NROBJS)
+		idx = obj->item.listwidget.active;
+	    break;
+#endif
+    case eBACKTAB:	/* backtab */
+	    idx = LIAcount(obj->item.listwidget.thelist) ? lw_D : lw_AB;
+	    break;
+    case eTAB:		/* tab */
+	    idx = 0;
+	    break;
+    default:
+	    idx = obj->item.listwidget.active;
+	    break;
+    }
+    obj->item.listwidget.active = idx;
+
+    return lwsettle(obj, w, mev, _nd_startObj(lwlist[idx], w, mev, cc));
+} /* startListWidget */
+
+
+DYN_STATIC editCode
+keyListWidget(void* o, void* w, int c)
+{
+    Obj *obj = OBJ(o);
+    Obj *lwlist[NROBJS];
+
+    lwparts(obj, lwlist);
+
+    return lwsettle(obj, w, 0,
+		    _nd_keyObj(lwlist[obj->item.listwidget.active], w, c));
+} /* keyListWidget */
+
+
+DYN_STATIC editCode
+editListWidget(void* o, void* w, MEVENT *mev, editCode cc)
+{
+    return _nd_editKeys(o, w, mev, cc, (nd_start)startListWidget,
+				       (nd_key)keyListWidget);
 } /* editListWidget */
 
 
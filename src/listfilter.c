@@ -0,0 +1,452 @@
+/*
+ * listfilter: narrow a list down to the items containing a string
+ *
+ * Copyright (C) 1996-2017 David L Parsons.
+ * The redistribution terms are provided in the COPYRIGHT file that must
+ * be distributed with this source code.
+ */
+#include <config.h>
+
+#include "nd_objects.h"
+#include "curse.h"
+#include "ndwin.h"
+#include "listfilter.h"
+
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* A filtered list shows its rows through item.list.view[], which maps
+ * rows on the screen to items in the ListItem array, so the items (and
+ * which of them are selected) aren't touched by filtering.
+ *
+ * To filter, we keep a lowercased copy of the text of every item packed
+ * end to end (with the id in front of it, if the list shows ids), and
+ * memchr() through that for the first letter of the query;  memchr()
+ * is about as fast a way as there is to sweep through a lot of memory
+ * looking for a byte.  If the new query contains the last one, every
+ * item it matches is already in the view, so only those items need to
+ * be looked at again.
+ */
+typedef struct {
+    char *text;		/* the packed item text */
+    int *off;		/* where each item starts in text[] */
+    char *query;	/* the query that built the view */
+} Filter;
+
+#define L(o)		(OBJ(o)->item.list)
+
+
+/*
+ * _nd_listFilterFree() throws away a list's view and filter
+ */
+void
+_nd_listFilterFree(Obj *obj)
+{
+    Filter *f = (Filter*)(L(obj).filter);
+
+    if (L(obj).view) {
+	free(L(obj).view);
+	L(obj).view = 0;
+    }
+    L(obj).nrview = 0;
+
+    if (f) {
+	if (f->text) free(f->text);
+	if (f->off) free(f->off);
+	if (f->query) free(f->query);
+	free(f);
+	L(obj).filter = 0;
+    }
+} /* _nd_listFilterFree */
+
+
+/*
+ * lcpy() copies a string, lowercasing it, and returns the end of the copy
+ */
+static char *
+lcpy(char *dest, char *src)
+{
+    if (src)
+	while (*src)
+	    *dest++ = tolower((unsigned char)*src++);
+    return dest;
+} /* lcpy */
+
+
+/*
+ * pack() builds the packed text for a list
+ */
+static Filter *
+pack(Obj *obj)
+{
+    Filter *f;
+    ListItem *it = L(obj).items;
+    int n = L(obj).nritems;
+    int ids = obj->flags & SHOW_IDS;
+    size_t size;
+    char *p;
+    int ix;
+
+    if ((f = calloc(1, sizeof *f)) == 0)
+	return 0;
+
+    for (size = 1, ix = 0; ix < n; ix++) {
+	size += (it[ix].item ? strlen(it[ix].item) : 0) + 1;
+	if (ids)
+	    size += (it[ix].id ? strlen(it[ix].id) : 0) + 1;
+    }
+
+    f->text = malloc(size);
+    f->off = malloc((n+1) * sizeof f->off[0]);
+
+    if (f->text == 0 || f->off == 0) {
+	if (f->text) free(f->text);
+	if (f->off) free(f->off);
+	free(f);
+	return 0;
+    }
+
+    for (p = f->text, ix = 0; ix < n; ix++) {
+	f->off[ix] = p - f->text;
+	if (ids) {
+	    /* \001 can't be typed into a query, so a match
+	     * can't run from the id into the item
+	     */
+	    p = lcpy(p, it[ix].id);
+	    *p++ = '\001';
+	}
+	p = lcpy(p, it[ix].item);
+	*p++ = 0;
+    }
+    f->off[n] = p - f->text;
+
+    L(obj).filter = f;
+    return f;
+} /* pack */
+
+
+/*
+ * search() finds q (len bytes) in p..end, or returns 0
+ */
+static char *
+search(char *p, char *end, char *q, int len)
+{
+    while (end - p >= len) {
+	if ((p = memchr(p, q[0], (end - p) - len + 1)) == 0)
+	    return 0;
+	if (memcmp(p+1, q+1, len-1) == 0)
+	    return p;
+	p++;
+    }
+    return 0;
+} /* search */
+
+
+/*
+ * setListFilter() shows only the items in a list (or their ids, if the
+ * list shows ids) that contain query, ignoring case.  A null or empty
+ * query shows all the items again.  The current item stays current if
+ * it's still showing.
+ *
+ * setListFilter() returns the number of items showing.
+ */
+int
+setListFilter(ndObject o, char *query)
+{
+    Obj *obj = OBJ(o);
+    Filter *f;
+    int *view;
+    char *q, *hit, *end;
+    int len, ix, row, nrrows, cur;
+
+    if (obj == 0 || objType(obj) != O_LIST) {
+	errno = EINVAL;
+	return -1;
+    }
+
+    cur = (L(obj).cury < LIST_ROWS(obj)) ? LIST_ITEM(obj, L(obj).cury) : -1;
+
+    if (query == 0 || *query == 0 || L(obj).items == 0) {
+	if (L(obj).view) {
+	    free(L(obj).view);
+	    L(obj).view = 0;
+	    L(obj).nrview = 0;
+	}
+	if ((f = L(obj).filter) && f->query) {
+	    free(f->query);
+	    f->query = 0;
+	}
+	nrrows = L(obj).nritems;
+	view = 0;
+	goto settle;
+    }
+
+    if ((f = L(obj).filter) == 0 && (f = pack(obj)) == 0)
+	return -1;
+
+    len = strlen(query);
+    if ((q = malloc(len+1)) == 0)
+	return -1;
+    *lcpy(q, query) = 0;
+
+    if ((view = malloc((L(obj).nritems+1) * sizeof view[0])) == 0) {
+	free(q);
+	return -1;
+    }
+    nrrows = 0;
+
+    if (L(obj).view && f->query && strstr(q, f->query)) {
+	/* narrowing the last query, so only look at what it found */
+	for (row = 0; row < L(obj).nrview; row++) {
+	    ix = L(obj).view[row];
+	    if (search(f->text + f->off[ix], f->text + f->off[ix+1], q, len))
+		view[nrrows++] = ix;
+	}
+    }
+    else {
+	/* sweep through all the text, skipping to the next item
+	 * whenever one matches
+	 */
+	end = f->text + f->off[L(obj).nritems];
+	for (ix = 0, hit = f->text; (hit = search(hit, end, q, len)) != 0; ) {
+	    while (f->off[ix+1] <= hit - f->text)
+		ix++;
+	    view[nrrows++] = ix;
+	    hit = f->text + f->off[++ix];
+	}
+    }
+
+    /* an empty view still has a row 0, so the cursor always points
+     * at some item
+     */
+    view[nrrows] = 0;
+
+    if (L(obj).view)
+	free(L(obj).view);
+    L(obj).view = view;
+    L(obj).nrview = nrrows;
+
+    if (f->query)
+	free(f->query);
+    f->query = q;
+
+settle:
+    /* keep the current item current if we can, otherwise go back to
+     * the top
+     */
+    L(obj).cury = L(obj).topy = 0;
+    if (cur >= 0) {
+	if (view == 0)
+	    row = cur;
+	else {
+	    int lo = 0, hi = nrrows;
+
+	    while (lo < hi) {
+		row = (lo + hi) / 2;
+		if (view[row] < cur)
+		    lo = row+1;
+		else
+		    hi = row;
+	    }
+	    row = (lo < nrrows && view[lo] == cur) ? lo : -1;
+	}
+	if (row >= 0) {
+	    L(obj).cury = row;
+	    if (row >= obj->depth)
+		L(obj).topy = (row - obj->depth) + 1;
+	}
+    }
+    touchObj(obj);
+    return nrrows;
+} /* setListFilter */
+
+
+/*
+ * The list filter widget is a string field that filters a list every
+ * time its contents change.
+ */
+#if DYNAMIC_BINDING
+
+#define DYN_STATIC	static
+
+DYN_STATIC void drawListFilter(void *o, void *w);
+DYN_STATIC void deleteListFilter(ndObject o);
+DYN_STATIC editCode editListFilter(void* o, void* w, MEVENT *mev, editCode cc);
+DYN_STATIC editCode startListFilter(void* o, void* w, MEVENT *mev, editCode cc);
+DYN_STATIC editCode keyListFilter(void* o, void* w, int c);
+
+static int filterType = O_ERROR;
+#define W_LFILTER	filterType
+
+#else
+
+#Error "This widget won't work unless DYNAMIC_BINDING is set"
+
+#endif
+
+typedef struct {
+    Obj *field;		/* the string we type into */
+    Obj *list;		/* the list it filters */
+    char *bfr;		/* what's in the string */
+    char *last;		/* what was in it the last time we filtered */
+} Lfilter;
+
+#define LF(o)	((Lfilter*)(OBJ(o)->item.generic))
+
+
+/*
+ * newListFilter() creates a string field that filters list
+ */
+ndObject
+newListFilter(int x, int y, int width, int size, ndObject list,
+	      char *prompt, char *prefix, char *help)
+{
+    Obj *tmp;
+    Lfilter *local;
+
+    if (list == 0 || objType(list) != O_LIST || width < 1 || size < 1) {
+	errno = EINVAL;
+	return 0;
+    }
+
+#if DYNAMIC_BINDING
+    if (W_LFILTER == O_ERROR) {
+	static struct _nd_object_table t = { 0, (nd_edit)editListFilter,
+						(nd_draw)drawListFilter,
+						(nd_free)deleteListFilter,
+						0, 0, 0, 0,
+						(nd_start)startListFilter,
+						(nd_key)keyListFilter } ;
+	W_LFILTER = nd_register_objtab(sizeof t, &t);
+    }
+    if (W_LFILTER == -1) {
+	errno = ENFILE;
+	return 0;
+    }
+#endif
+
+    tmp = _nd_newObj(0, W_LFILTER, 0, prompt, prefix, x, y, width, 1, help);
+    if (tmp == 0)
+	return 0;
+
+    if ((tmp->item.generic = calloc(1, sizeof *local)) == 0) {
+	deleteObj(tmp);
+	return 0;
+    }
+    local = LF(tmp);
+    local->list = list;
+    local->bfr = calloc(1, size+1);
+    local->last = calloc(1, size+1);
+
+    if (local->bfr == 0 || local->last == 0
+	   || (local->field = newString(x, y, width, size, local->bfr,
+					prompt, prefix, 0, help)) == 0) {
+	deleteObj(tmp);
+	return 0;
+    }
+    local->field->parent = tmp;
+    local->field->flags |= OBJ_DRAW;
+    return tmp;
+} /* newListFilter */
+
+
+/*
+ * deleteListFilter() deletes the string field (but not the list)
+ */
+DYN_STATIC void
+deleteListFilter(ndObject o)
+{
+    Lfilter *local;
+
+    if (o == 0 || objType(o) != W_LFILTER)
+	return;
+
+    if ((local = LF(o)) != 0) {
+	if (local->field)
+	    deleteObj(local->field);
+	if (local->bfr)
+	    free(local->bfr);
+	if (local->last)
+	    free(local->last);
+	free(local);
+    }
+} /* deleteListFilter */
+
+
+/*
+ * drawListFilter() draws the string field
+ */
+DYN_STATIC void
+drawListFilter(void *o, void *w)
+{
+    if (o == 0 || objType(o) != W_LFILTER)
+	return;
+
+    OBJ(LF(o)->field)->flags = (OBJ(LF(o)->field)->flags & ~OBJ_CURRENT)
+			     | (OBJ(o)->flags & OBJ_CURRENT);
+    drawString(LF(o)->field, w);
+} /* drawListFilter */
+
+
+/*
+ * refilter() filters the list if the string has changed
+ */
+static void
+refilter(Obj *obj, void *w)
+{
+    Lfilter *local = LF(obj);
+
+    if (strcmp(local->bfr, local->last) != 0) {
+	strcpy(local->last, local->bfr);
+	setListFilter(local->list, local->bfr);
+	drawObj(local->list, w);
+    }
+} /* refilter */
+
+
+DYN_STATIC editCode
+startListFilter(void* o, void* w, MEVENT *mev, editCode cc)
+{
+    if (o == 0 || objType(o) != W_LFILTER) {
+	errno = EINVAL;
+	return eERROR;
+    }
+    OBJ(LF(o)->field)->flags |= OBJ_CURRENT;
+    return _nd_startObj(LF(o)->field, w, mev, cc);
+} /* startListFilter */
+
+
+DYN_STATIC editCode
+keyListFilter(void* o, void* w, int c)
+{
+    editCode rc = _nd_keyObj(LF(o)->field, w, c);
+
+    refilter(OBJ(o), w);
+    if (rc != eNOP)
+	OBJ(LF(o)->field)->flags &= ~OBJ_CURRENT;
+    return rc;
+} /* keyListFilter */
+
+
+DYN_STATIC editCode
+editListFilter(void* o, void* w, MEVENT *mev, editCode cc)
+{
+    return _nd_editKeys(o, w, mev, cc, (nd_start)startListFilter,
+				       (nd_key)keyListFilter);
+} /* editListFilter */
+
+
+/*
+ * listFilterText() returns what's been typed into a list filter
+ */
+char *
+listFilterText(ndObject o)
+{
+    if (o == 0 || objType(o) != W_LFILTER) {
+	errno = EINVAL;
+	return 0;
+    }
+    return LF(o)->bfr;
+} /* listFilterText */
@@ -0,0 +1,18 @@
+/*
+ * Copyright (C) 1996-2017 David L Parsons.
+ * The redistribution terms are provided in the COPYRIGHT file that must
+ * be distributed with this source code.
+ */
+#ifndef __LISTFILTER_D
+#define __LISTFILTER_D
+
+#include <ndialog.h>
+
+/* A list filter is a string field that narrows a list down to the items
+ * that contain whatever's been typed into it.
+ */
+ndObject newListFilter(int x, int y, int width, int size, ndObject list,
+		       char *prompt, char *prefix, char *help);
+char *listFilterText(ndObject obj);
+
+#endif/*__LISTFILTER_D*/
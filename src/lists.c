@@ -179,22 +179,28 @@ ndialog_list(char *title, char *prompt,
     *sc = 0;
     *ch = getObjCursor(listobj);
 
-    deleteObjChain(chain);
-
     result[0] = 0;
     if (rc == MENU_OK) {
 	retval = 0;
-	for (x=0; x<nrlist;x++)
-	    if (list[x].selected) {
-		strcat(result, list[x].id);
-		strcat(result, "\n");
-	    }
+	/* walk the selected items only, appending at the end of the
+	 * result instead of strcat()ing from the start each time
+	 */
+	for (p = result, x = nextSelection(listobj, 0); x >= 0;
+					x = nextSelection(listobj, x+1)) {
+	    tw = strlen(list[x].id);
+	    memcpy(p, list[x].id, tw);
+	    p += tw;
+	    *p++ = '\n';
+	}
+	*p = 0;
     }
     else if (rc == MENU_ESCAPE || rc < MENU_ERROR)
 	retval = -1;
     else
 	retval = 1;
 
+    deleteObjChain(chain);
+
 byebye:
     free(list);
     return retval;
@@ -0,0 +1,262 @@
+/*
+ * listsel: selection sets for list objects
+ *
+ * Copyright (C) 1996-2017 David L Parsons.
+ * The redistribution terms are provided in the COPYRIGHT file that must
+ * be distributed with this source code.
+ */
+#include <config.h>
+
+#include "nd_objects.h"
+
+#include <errno.h>
+#include <fnmatch.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* The ListItem.selected flags belong to the caller, who expects to find
+ * them set when MENU() returns, so they're still kept up to date.  But a
+ * list object also keeps its own copy of which items are selected in a
+ * bitset, along with how many there are and (for radio lists) which one
+ * it is, so that clearing a radio list or a menu doesn't mean walking
+ * every item, and walking the selected items only needs to look at a
+ * word at a time.
+ *
+ * If the bitset can't be allocated (sel == 0), these functions fall back
+ * to using the ListItem flags directly.
+ */
+#define SELBITS		(CHAR_BIT * sizeof(unsigned long))
+#define SELWORDS(n)	(((n) + SELBITS - 1) / SELBITS)
+
+#define L(o)		(OBJ(o)->item.list)
+
+
+/*
+ * _nd_listSelInit() (re)builds the selection set from the ListItem flags
+ */
+int
+_nd_listSelInit(Obj *obj)
+{
+    int ix;
+
+    _nd_listSelFree(obj);
+    L(obj).nrselected = 0;
+    L(obj).radio = -1;
+
+    if (L(obj).items == 0 || L(obj).nritems <= 0)
+	return 0;
+
+    L(obj).sel = calloc(SELWORDS(L(obj).nritems), sizeof L(obj).sel[0]);
+
+    for (ix = 0; ix < L(obj).nritems; ix++)
+	if (L(obj).items[ix].selected) {
+	    if (L(obj).sel)
+		L(obj).sel[ix/SELBITS] |= 1UL << (ix % SELBITS);
+	    L(obj).nrselected++;
+	    if (L(obj).radio < 0)
+		L(obj).radio = ix;
+	}
+
+    return L(obj).sel ? 0 : -1;
+} /* _nd_listSelInit */
+
+
+/*
+ * _nd_listSelFree() throws away a selection set
+ */
+void
+_nd_listSelFree(Obj *obj)
+{
+    if (L(obj).sel) {
+	free(L(obj).sel);
+	L(obj).sel = 0;
+    }
+} /* _nd_listSelFree */
+
+
+/*
+ * _nd_listIsSelected() tells us if an item is selected
+ */
+int
+_nd_listIsSelected(Obj *obj, int ix)
+{
+    if (L(obj).sel)
+	return (L(obj).sel[ix/SELBITS] >> (ix % SELBITS)) & 1;
+    return L(obj).items[ix].selected != 0;
+} /* _nd_listIsSelected */
+
+
+/*
+ * _nd_listSelect() selects or unselects one item.  Selecting an item in
+ * a radio list unselects the item that was selected before it.
+ */
+void
+_nd_listSelect(Obj *obj, int ix, int on)
+{
+    on = (on != 0);
+
+    if (ix < 0 || ix >= L(obj).nritems || _nd_listIsSelected(obj, ix) == on)
+	return;
+
+    if (on && (obj->flags & RADIO_LIST) && L(obj).radio >= 0)
+	_nd_listSelect(obj, L(obj).radio, 0);
+
+    if (L(obj).sel) {
+	if (on)
+	    L(obj).sel[ix/SELBITS] |= 1UL << (ix % SELBITS);
+	else
+	    L(obj).sel[ix/SELBITS] &= ~(1UL << (ix % SELBITS));
+    }
+    L(obj).items[ix].selected = on;
+
+    if (on) {
+	L(obj).nrselected++;
+	L(obj).radio = ix;
+    }
+    else {
+	L(obj).nrselected--;
+	if (L(obj).radio == ix)
+	    L(obj).radio = -1;
+    }
+} /* _nd_listSelect */
+
+
+/*
+ * _nd_listNext() returns the first selected item at or after from, or -1
+ * if there aren't any more.
+ */
+int
+_nd_listNext(Obj *obj, int from)
+{
+    int n = L(obj).nritems;
+    int w;
+    unsigned long bits;
+
+    if (from < 0)
+	from = 0;
+    if (L(obj).nrselected == 0 || from >= n)
+	return -1;
+
+    if (L(obj).sel == 0) {
+	for ( ; from < n; from++)
+	    if (L(obj).items[from].selected)
+		return from;
+	return -1;
+    }
+
+    w = from / SELBITS;
+    bits = L(obj).sel[w] & (~0UL << (from % SELBITS));
+
+    while (bits == 0) {
+	if (++w >= SELWORDS(n))
+	    return -1;
+	bits = L(obj).sel[w];
+    }
+    for (from = w * SELBITS; (bits & 1) == 0; bits >>= 1)
+	from++;
+
+    return (from < n) ? from : -1;
+} /* _nd_listNext */
+
+
+/*
+ * _nd_listClear() unselects everything
+ */
+void
+_nd_listClear(Obj *obj)
+{
+    int ix;
+
+    for (ix = _nd_listNext(obj, 0); ix >= 0; ix = _nd_listNext(obj, ix+1))
+	_nd_listSelect(obj, ix, 0);
+} /* _nd_listClear */
+
+
+/*
+ * nrSelected() tells how many items in a list are selected
+ */
+int
+nrSelected(void *obj)
+{
+    if (obj && objType(obj) == O_LIST)
+	return L(obj).nrselected;
+    errno = EINVAL;
+    return -1;
+} /* nrSelected */
+
+
+/*
+ * nextSelection() returns the first selected item at or after from, or
+ * -1 if there aren't any;  so
+ *
+ *	for (i = nextSelection(o,0); i >= 0; i = nextSelection(o,i+1))
+ *
+ * visits every selected item.
+ */
+int
+nextSelection(void *obj, int from)
+{
+    if (obj && objType(obj) == O_LIST)
+	return _nd_listNext(OBJ(obj), from);
+    errno = EINVAL;
+    return -1;
+} /* nextSelection */
+
+
+/*
+ * selectListItems() selects all, none, or the inverse of the items in a
+ * list, or the items whose id or text matches a shell pattern.  Radio
+ * lists can't have more than one item selected, so SELECT_ALL and
+ * SELECT_INVERT don't work on them, and SELECT_MATCHING only selects
+ * the first match.  The list is redrawn once, the next time the form
+ * refreshes.
+ *
+ * selectListItems() returns the number of selected items.
+ */
+int
+selectListItems(void *o, int how, char *pattern)
+{
+    Obj *obj = OBJ(o);
+    ListItem *it;
+    int ix, radio = obj && (obj->flags & RADIO_LIST);
+
+    if (obj == 0 || objType(obj) != O_LIST
+		 || (how == SELECT_MATCHING && pattern == 0)
+		 || (radio && (how == SELECT_ALL || how == SELECT_INVERT))) {
+	errno = EINVAL;
+	return -1;
+    }
+
+    switch (how) {
+    case SELECT_NONE:
+	_nd_listClear(obj);
+	break;
+
+    case SELECT_ALL:
+    case SELECT_INVERT:
+	for (ix = 0; ix < L(obj).nritems; ix++)
+	    _nd_listSelect(obj, ix, (how == SELECT_ALL)
+					|| !_nd_listIsSelected(obj, ix));
+	break;
+
+    case SELECT_MATCHING:
+	for (ix = 0; ix < L(obj).nritems; ix++) {
+	    it = &L(obj).items[ix];
+	    if ((it->id && fnmatch(pattern, it->id, 0) == 0)
+		    || (it->item && fnmatch(pattern, it->item, 0) == 0)) {
+		_nd_listSelect(obj, ix, 1);
+		if (radio)
+		    break;
+	    }
+	}
+	break;
+
+    default:
+	errno = EINVAL;
+	return -1;
+    }
+
+    touchObj(obj);
+    return L(obj).nrselected;
+} /* selectListItems */
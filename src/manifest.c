@@ -0,0 +1,399 @@
+/*
+ * manifest: a file selector directory provider that reads a manifest
+ *
+ * Copyright (C) 1996-2017 David L Parsons.
+ * The redistribution terms are provided in the COPYRIGHT file that must
+ * be distributed with this source code.
+ */
+#include <config.h>
+
+#include "fileselector.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+/* A manifest is a list of the paths in a tree, relative to the top of
+ * the tree, one to a line, sorted bytewise (LC_ALL=C sort.)  It might
+ * come from
+ *
+ *	find . | LC_ALL=C sort > manifest
+ *
+ * so a leading ./ (or /) on every line is ignored.  Directories don't
+ * have to be listed by themselves;  anything with paths under it is a
+ * directory, and so is anything listed with a / on the end (which is
+ * the only way an empty directory shows up as one.)
+ *
+ * The manifest is mmap()ed and never indexed.  Everything under a
+ * directory sorts together, so a directory is read by binary searching
+ * for the first line that starts with it and walking forward from
+ * there, binary searching past the contents of each subdirectory
+ * instead of walking through them.  Opening a directory in a manifest
+ * of millions of paths only looks at a few dozen lines more than the
+ * ones it shows.
+ */
+typedef struct {
+    char *data;		/* the manifest */
+    size_t size;
+    size_t mapped;	/* how much of it is mmap()ed, if it is */
+    char *lead;		/* what to ignore at the start of each line */
+    int skip;		/* ... and how long it is */
+    char *key;		/* scratch space for building search keys */
+    int szkey;
+} Manifest;
+
+typedef struct {
+    char *prefix;	/* the directory, with a / on the end (or "") */
+    int plen;
+    size_t pos;		/* the next line to look at */
+    char *name;		/* the last entry we returned */
+    int szname;
+} Mdir;
+
+
+/*
+ * line() finds the path on the line starting at pos, and returns the
+ * start of the next line
+ */
+static size_t
+line(Manifest *m, size_t pos, char **path, int *len)
+{
+    char *start = m->data + pos;
+    char *end = memchr(start, '\n', m->size - pos);
+
+    if (end == 0)
+	end = m->data + m->size;
+    *path = start;
+    *len = end - start;
+
+    if (*len >= m->skip && memcmp(start, m->lead, m->skip) == 0) {
+	*path += m->skip;
+	*len -= m->skip;
+    }
+    else if (*len == 1 && *start == '.')	/* . (from find .) is the top */
+	*len = 0;
+
+    return (end - m->data) + 1;
+} /* line */
+
+
+/*
+ * compare() compares a path with a key, like strcmp()
+ */
+static int
+compare(char *path, int len, char *key, int klen)
+{
+    int rc = memcmp(path, key, len < klen ? len : klen);
+
+    return rc ? rc : (len - klen);
+} /* compare */
+
+
+/*
+ * lowerBound() finds the first line that isn't less than key
+ */
+static size_t
+lowerBound(Manifest *m, char *key, int klen)
+{
+    size_t lo = 0, hi = m->size, mid, next;
+    char *path;
+    int len;
+
+    while (lo < hi) {
+	/* back up to the start of the line the middle is in */
+	for (mid = lo + (hi-lo)/2; mid > lo && m->data[mid-1] != '\n'; --mid)
+	    ;
+	next = line(m, mid, &path, &len);
+
+	if (compare(path, len, key, klen) < 0)
+	    lo = next;
+	else
+	    hi = mid;
+    }
+    return lo;
+} /* lowerBound */
+
+
+/*
+ * setKey() puts the first len bytes of a path, followed by a suffix,
+ * into the scratch key
+ */
+static char *
+setKey(Manifest *m, char *path, int len, char *suffix)
+{
+    int size = len + strlen(suffix) + 1;
+
+    if (size > m->szkey) {
+	char *tmp = realloc(m->key, size);
+
+	if (tmp == 0)
+	    return 0;
+	m->key = tmp;
+	m->szkey = size;
+    }
+    memcpy(m->key, path, len);
+    strcpy(m->key + len, suffix);
+    return m->key;
+} /* setKey */
+
+
+/*
+ * under() tells whether there are any paths under path
+ */
+static int
+under(Manifest *m, char *path, int len)
+{
+    size_t pos;
+    char *p;
+    int plen;
+
+    if (setKey(m, path, len, "/") == 0)
+	return 0;
+    if ((pos = lowerBound(m, m->key, len+1)) >= m->size)
+	return 0;
+    line(m, pos, &p, &plen);
+    return plen >= len+1 && memcmp(p, m->key, len+1) == 0;
+} /* under */
+
+
+/*
+ * listed() tells whether the first len bytes of a path are a line by
+ * themselves
+ */
+static int
+listed(Manifest *m, char *path, int len)
+{
+    size_t pos;
+    char *p;
+    int plen;
+
+    if (setKey(m, path, len, "") == 0)
+	return 0;
+    if ((pos = lowerBound(m, m->key, len)) >= m->size)
+	return 0;
+    line(m, pos, &p, &plen);
+    return plen == len && memcmp(p, m->key, len) == 0;
+} /* listed */
+
+
+static void *
+manifestOpen(void *ctx, char *dir)
+{
+    Manifest *m = (Manifest*)ctx;
+    Mdir *d;
+    int len;
+
+    while (*dir == '/')
+	++dir;
+    len = strlen(dir);
+    while (len > 0 && dir[len-1] == '/')
+	--len;
+
+    /* the top is always there;  anything else has to have something
+     * under it
+     */
+    if (len > 0 && !under(m, dir, len)) {
+	errno = ENOENT;
+	return 0;
+    }
+
+    if ((d = calloc(1, sizeof *d)) == 0)
+	return 0;
+    if ((d->prefix = malloc(len+2)) == 0) {
+	free(d);
+	return 0;
+    }
+    memcpy(d->prefix, dir, len);
+    if (len > 0)
+	d->prefix[len++] = '/';
+    d->prefix[len] = 0;
+    d->plen = len;
+    d->pos = lowerBound(m, d->prefix, d->plen);
+    return d;
+} /* manifestOpen */
+
+
+static char *
+manifestRead(void *ctx, void *handle, int *isdir)
+{
+    Manifest *m = (Manifest*)ctx;
+    Mdir *d = (Mdir*)handle;
+    char *path, *rest, *slash;
+    int len, nlen;
+    size_t next;
+
+    while (d->pos < m->size) {
+	next = line(m, d->pos, &path, &len);
+
+	if (len < d->plen || memcmp(path, d->prefix, d->plen) != 0)
+	    break;		/* past the end of the directory */
+
+	rest = path + d->plen;
+	len -= d->plen;
+
+	if (len == 0) {		/* the directory itself */
+	    d->pos = next;
+	    continue;
+	}
+
+	if ((slash = memchr(rest, '/', len)) != 0) {
+	    /* something in a subdirectory, so skip past everything
+	     * in it ('0' is the character after '/') and return the
+	     * subdirectory, unless it's listed by itself (in which
+	     * case we've already returned it.)
+	     */
+	    nlen = slash - rest;
+	    if (setKey(m, path, d->plen + nlen, "0") == 0)
+		break;
+	    d->pos = lowerBound(m, m->key, d->plen + nlen + 1);
+
+	    if (listed(m, path, d->plen + nlen))
+		continue;
+	    *isdir = 1;
+	}
+	else {
+	    /* a file, or a directory that's listed by itself */
+	    nlen = len;
+	    *isdir = under(m, path, d->plen + nlen);
+	    d->pos = next;
+	}
+
+	if (nlen+1 > d->szname) {
+	    char *tmp = realloc(d->name, nlen+1);
+
+	    if (tmp == 0)
+		break;
+	    d->name = tmp;
+	    d->szname = nlen+1;
+	}
+	memcpy(d->name, rest, nlen);
+	d->name[nlen] = 0;
+	return d->name;
+    }
+    d->pos = m->size;
+    return 0;
+} /* manifestRead */
+
+
+static void
+manifestClose(void *ctx, void *handle)
+{
+    Mdir *d = (Mdir*)handle;
+
+    free(d->prefix);
+    if (d->name)
+	free(d->name);
+    free(d);
+} /* manifestClose */
+
+
+static int
+manifestExists(void *ctx, char *path)
+{
+    Manifest *m = (Manifest*)ctx;
+    int len;
+
+    while (*path == '/')
+	++path;
+    len = strlen(path);
+    while (len > 0 && path[len-1] == '/')
+	--len;
+
+    return len == 0 || listed(m, path, len) || under(m, path, len);
+} /* manifestExists */
+
+
+/* a manifest never changes underneath us, and doesn't know how big
+ * anything is or when it was changed
+ */
+ndDirProvider ndManifestProvider = {
+    manifestOpen, manifestRead, manifestClose, 0,
+    0, 0, 0, manifestExists
+};
+
+
+/*
+ * openManifest() maps in a manifest, or returns 0 (with errno set) if
+ * it can't
+ */
+void *
+openManifest(char *file)
+{
+    Manifest *m;
+    struct stat st;
+    char *last;
+    int fd;
+
+    if (file == 0) {
+	errno = EINVAL;
+	return 0;
+    }
+    if ((fd = open(file, O_RDONLY)) < 0)
+	return 0;
+    if (fstat(fd, &st) != 0 || (m = calloc(1, sizeof *m)) == 0) {
+	close(fd);
+	return 0;
+    }
+    m->size = st.st_size;
+
+    if (m->size > 0) {
+	m->data = mmap(0, m->size, PROT_READ, MAP_SHARED, fd, 0);
+	if (m->data != MAP_FAILED)
+	    m->mapped = m->size;
+	else if ((m->data = malloc(m->size)) == 0
+		 || read(fd, m->data, m->size) != m->size) {
+	    /* can't map it, and can't read it either */
+	    if (m->data)
+		free(m->data);
+	    close(fd);
+	    free(m);
+	    errno = EIO;
+	    return 0;
+	}
+    }
+    close(fd);
+
+    /* don't count a newline at the end as an empty line */
+    if (m->size > 0 && m->data[m->size-1] == '\n')
+	--m->size;
+
+    /* every line starts the same way, so the last line says whether
+     * there's a ./ or / to ignore (the first might be a lone .)
+     */
+    for (last = m->data + m->size; last > m->data && last[-1] != '\n'; --last)
+	;
+    if (m->size - (last - m->data) >= 2 && memcmp(last, "./", 2) == 0)
+	m->lead = "./";
+    else if (m->size > (last - m->data) && *last == '/')
+	m->lead = "/";
+    else
+	m->lead = "";
+    m->skip = strlen(m->lead);
+
+    return m;
+} /* openManifest */
+
+
+/*
+ * closeManifest() gets rid of a manifest
+ */
+void
+closeManifest(void *manifest)
+{
+    Manifest *m = (Manifest*)manifest;
+
+    if (m == 0)
+	return;
+    if (m->mapped)
+	munmap(m->data, m->mapped);
+    else if (m->data)
+	free(m->data);
+    if (m->key)
+	free(m->key);
+    free(m);
+} /* closeManifest */
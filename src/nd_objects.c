@@ -12,6 +12,7 @@
 #include <errno.h>
 #include <stdarg.h>
 #include <stdlib.h>
+#include <stddef.h>
 
 #include "nd_objects.h"
 #include "ndwin.h"
@@ -149,6 +150,27 @@ copyObj(void *ob)
     }
     tmp->next = tmp->prev = 0;
 
+    if (objType(tmp) == O_LIST) {
+	/* the copy needs its own selection set, can build its own
+	 * hotkey index, and isn't filtered
+	 */
+	if (tmp->item.list.view) {
+	    tmp->item.list.cury = OBJ(ob)->item.list.view[tmp->item.list.cury];
+	    tmp->item.list.topy = 0;
+	    if (tmp->item.list.cury >= tmp->depth)
+		tmp->item.list.topy = (tmp->item.list.cury - tmp->depth) + 1;
+	}
+	tmp->item.list.sel = 0;
+	tmp->item.list.keys = 0;
+	tmp->item.list.view = 0;
+	tmp->item.list.nrview = 0;
+	tmp->item.list.filter = 0;
+	if (_nd_listSelInit(tmp) != 0) {
+	    deleteObj(tmp);
+	    return 0;
+	}
+    }
+
     return tmp;
 } /* copyObj */
 
@@ -355,6 +377,10 @@ newList(int x, int y, int width, int depth, int nritems, ListItem *items,
 	tmp->flags |= (flags & (SHOW_IDS|NO_HOTKEYS|CR_LIST|DEL_LIST|ALWAYS_HIGHLIT));
 	if ((flags & DEL_LIST) == 0)
 	    tmp->flags |= CR_LIST;
+	if (_nd_listSelInit(tmp) != 0) {
+	    deleteObj(tmp);
+	    return 0;
+	}
     }
     return tmp;
 } /* newList */
@@ -428,13 +454,28 @@ newGauge(int x, int y, int width, int *percent, char *prompt, char *prefix)
 static void
 freeText(Obj *obj)
 {
-    if (obj->item.text.lines)
-	free(obj->item.text.lines);
+    _nd_textFree(obj);
+    _nd_searchFree(obj);
     if (obj->item.text.class == T_IS_HTML) {
 	free(obj->item.text.bs);
 	deletePage(obj->item.text.extra);
     }
+    else if (obj->item.text.class == T_IS_FOLLOW)
+	_nd_followFree(obj);
 } /* freeText */
+
+
+/*
+ * freeList() wipes out the selection set, hotkey index, and filter for
+ * a LIST object
+ */
+static void
+freeList(Obj *obj)
+{
+    _nd_listSelFree(obj);
+    _nd_listKeysFree(obj);
+    _nd_listFilterFree(obj);
+} /* freeList */
 #endif
 
 
@@ -461,12 +502,19 @@ deleteObj(void *o)
 #else
     switch (objType(obj)) {
     case O_TEXT:
-		if (obj->item.text.lines)
-		    free(obj->item.text.lines);
+		_nd_textFree(obj);
+		_nd_searchFree(obj);
 		if (obj->item.text.class == T_IS_HTML) {
 		    free(obj->item.text.bs);
 		    deletePage(obj->item.text.extra);
 		}
+		else if (obj->item.text.class == T_IS_FOLLOW)
+		    _nd_followFree(obj);
+		break;
+    case O_LIST:
+		_nd_listSelFree(obj);
+		_nd_listKeysFree(obj);
+		_nd_listFilterFree(obj);
 		break;
     case W_LIST:
 		deleteListWidget(obj);
@@ -602,6 +650,76 @@ editObj(void *obj, void *win, void *event, editCode cc)
 } /* editobj */
 
 
+/*
+ * _nd_startObj() starts editing an object without waiting for any
+ * input.  It returns eNOP if the object is waiting for keys (which
+ * should be passed to it with _nd_keyObj()), or the editCode that
+ * took us out of the object.
+ *
+ * Objects that can't be edited a keystroke at a time are edited
+ * with editObj(), which blocks until the user leaves them.
+ */
+editCode
+_nd_startObj(void *obj, void *win, void *event, editCode cc)
+{
+    editCode rc;
+
+    if (obj == 0 || OBJ_READONLY(obj))
+	return eTAB;
+
+#if DYNAMIC_BINDING
+    if (nd_object_table[objType(obj)].start && nd_object_table[objType(obj)].key) {
+	MAKE_CURRENT(obj);
+	drawObj(obj,win);
+	rc = (nd_object_table[objType(obj)].start)(obj,win,event,cc);
+	if (rc != eNOP) {
+	    NOT_CURRENT(obj);
+	    touchObj(obj);
+	}
+	return rc;
+    }
+#endif
+    return editObj(obj,win,event,cc);
+} /* _nd_startObj */
+
+
+/*
+ * _nd_keyedObj() tells whether an object is edited a key at a time by
+ * its start and key functions, or all at once by its edit function.
+ */
+int
+_nd_keyedObj(void *obj)
+{
+#if DYNAMIC_BINDING
+    if (obj && !OBJ_READONLY(obj))
+	return nd_object_table[objType(obj)].start
+	    && nd_object_table[objType(obj)].key;
+#endif
+    return 0;
+} /* _nd_keyedObj */
+
+
+/*
+ * _nd_keyObj() passes a keystroke to an object that _nd_startObj() left
+ * waiting for keys.
+ */
+editCode
+_nd_keyObj(void *obj, void *win, int c)
+{
+    editCode rc = eESCAPE;
+
+#if DYNAMIC_BINDING
+    if (nd_object_table[objType(obj)].key)
+	rc = (nd_object_table[objType(obj)].key)(obj,win,c);
+#endif
+    if (rc != eNOP) {
+	NOT_CURRENT(obj);
+	touchObj(obj);
+    }
+    return rc;
+} /* _nd_keyObj */
+
+
 #if DYNAMIC_BINDING
 /*-----------------------------------------------*
  *                                               *
@@ -609,21 +727,27 @@ editObj(void *obj, void *win, void *event, editCode cc)
  *                                               *
  *-----------------------------------------------*/
     
-#define REGISTER(edit,draw,free,bind,size,getp,setp) \
+#define REGISTER(edit,draw,free,bind,size,getp,setp,start,key) \
 	{ 1, (nd_edit)edit, (nd_draw)draw, (nd_free)free, \
-	     (nd_bind)bind, (nd_size)size, (nd_getp)getp, (nd_setp)setp }
+	     (nd_bind)bind, (nd_size)size, (nd_getp)getp, (nd_setp)setp, \
+	     (nd_start)start, (nd_key)key }
 
 struct _nd_object_table nd_object_table[ND_TABLE_SIZE] = {
     { 1,  },
     REGISTER(editString, drawString, 0, nd_bindToString, nd_typeSize,
-				getStringCursor, setStringCursor),
-    REGISTER(editCheck, drawCheck, 0, nd_bindToType, nd_typeSize, 0, 0),
-    REGISTER(editButton,drawButton, 0, nd_bindToType, nd_buttonSize, 0, 0),
-    REGISTER(editList, drawList, 0, nd_bindToList, nd_typeSize,
-				getListCursor, setListCursor),
+				getStringCursor, setStringCursor,
+				startString, keyString),
+    REGISTER(editCheck, drawCheck, 0, nd_bindToType, nd_typeSize, 0, 0,
+				startCheck, keyCheck),
+    REGISTER(editButton,drawButton, 0, nd_bindToType, nd_buttonSize, 0, 0,
+				startButton, keyButton),
+    REGISTER(editList, drawList, freeList, nd_bindToList, nd_typeSize,
+				getListCursor, setListCursor,
+				startList, keyList),
     REGISTER(editText, drawText, freeText, nd_bindToText, nd_typeSize,
-				 0, setTextCursor),
-    REGISTER(0, drawGauge, 0, nd_bindToType, nd_typeSize, 0, 0),
+				 0, setTextCursor,
+				 startText, keyText),
+    REGISTER(0, drawGauge, 0, nd_bindToType, nd_typeSize, 0, 0, 0, 0),
 } ;
 
 
@@ -674,7 +798,8 @@ nd_register_objtab(int recsize, struct _nd_object_table *rec)
      *   3) the record size is misaligned
      */
     if ( (recsize <= sizeof rec->edit) || (recsize > sizeof *rec)
-      || ((recsize - sizeof rec->used) % sizeof rec->edit) != 0) {
+      || ((recsize - offsetof(struct _nd_object_table, edit))
+						% sizeof rec->edit) != 0) {
 	errno = EINVAL;
 	return -1;
     }
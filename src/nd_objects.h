@@ -85,6 +85,14 @@ typedef struct {
     int itemoffset;	/* when displaying both id and item, we need to
 			 * properly offset the item in the field
 			 */
+    int cursor;		/* cursor visibility to restore when we leave */
+    unsigned long *sel;	/* bitset of selected items (see listsel.c) */
+    int nrselected;	/* how many items are selected */
+    int radio;		/* the selected item in a radio list, or -1 */
+    void *keys;		/* hotkey index (see typeahead.c) */
+    int *view;		/* rows -> items when filtered (see listfilter.c) */
+    int nrview;		/* how many rows the filter left */
+    void *filter;	/* the filter itself */
 /* generic flag bits */
 #define RADIO_LIST	0x0100		/* this is a radio list */
 #define MENU_LIST	0x0200		/* this is a menu list */
@@ -92,6 +100,13 @@ typedef struct {
 			/* how to show checked items */
 } L_Obj;
 
+/* cury and topy count rows, which are items unless the list is filtered
+ */
+#define LIST_ROWS(o)	(OBJ(o)->item.list.view ? OBJ(o)->item.list.nrview \
+						: OBJ(o)->item.list.nritems)
+#define LIST_ITEM(o,r)	(OBJ(o)->item.list.view ? OBJ(o)->item.list.view[r] \
+						: (r))
+
 
 /*
  * a text object is a display-only box displaying an arbitrarily
@@ -101,14 +116,17 @@ typedef struct {
     int class;		/* is this regular text, or something special? */
 #define T_IS_TEXT	0		/* regular text */
 #define T_IS_HTML	1		/* html */
-    char **lines;	/* pointers to each line in the string */
-    int nrlines;	/* number of lines in the string */
+#define T_IS_FOLLOW	2		/* following a file */
+    void *index;	/* where the lines are (see textlines.c) */
+    int nrlines;	/* number of lines in the string (found so far) */
     int topy;		/* top of window */
     int off_x;		/* X offset, if scrolled left or right */
     int width;		/* width of widest line */
     short *bs;		/* T_IS_HTML: text backing store */
     short href;		/* T_IS_HTML: current href# */
     void *extra;	/* subclass-defined content */
+    int cursor;		/* cursor visibility to restore when we leave */
+    void *search;	/* in-view search (see textsearch.c) */
 } T_Obj;
 
 
@@ -248,6 +266,7 @@ extern int _nd_callback(Obj *, void*);
 typedef struct _nd_display {
     void* window;	/* the curses window */
     int x, y;		/* X, Y origin */
+    void* form;		/* the form this display belongs to, if any */
 } Display;
 
 extern void* newDisplay(void*, int, int);
@@ -271,6 +290,64 @@ extern void deleteDisplay(Display*);
 extern int ndgetch(Display* from);
 
 
+/* objects that can be edited a keystroke at a time provide a start
+ * function, which sets up for editing (and deals with any mouse event
+ * that sent us there), and a key function, which deals with one keystroke.
+ * Both return eNOP if the object wants more keys, or the editCode that
+ * takes us out of the object.  The key function is passed EOF if input
+ * dries up, and must return eESCAPE (after cleaning up) when that happens.
+ */
+typedef editCode (*nd_start)(void*,void*,void*,editCode);
+typedef editCode (*nd_key)(void*,void*,int);
+
+extern editCode _nd_editKeys(void*,void*,void*,editCode,nd_start,nd_key);
+extern editCode _nd_startObj(void*,void*,void*,editCode);
+extern editCode _nd_keyObj(void*,void*,int);
+extern int      _nd_keyedObj(void*);
+
+/* list selection sets (listsel.c) */
+extern int  _nd_listSelInit(Obj*);
+extern void _nd_listSelFree(Obj*);
+extern int  _nd_listIsSelected(Obj*,int);
+extern void _nd_listSelect(Obj*,int,int);
+extern int  _nd_listNext(Obj*,int);
+extern void _nd_listClear(Obj*);
+
+/* list hotkeys (typeahead.c) */
+extern int  _nd_listHotkey(Obj*,int);
+extern void _nd_listKeysFree(Obj*);
+
+/* list filters (listfilter.c) */
+extern void _nd_listFilterFree(Obj*);
+
+/* text line indexes (textlines.c) */
+extern int   _nd_textIndex(Obj*,long);
+extern void  _nd_textFree(Obj*);
+extern int   _nd_textLines(Obj*,int);
+extern int   _nd_textCount(Obj*);
+extern int   _nd_textDone(Obj*);
+extern void  _nd_textBackground(Obj*,void*);
+extern void  _nd_textGrow(Obj*,char*,long);
+extern long  _nd_textTrim(Obj*,long);
+extern long  _nd_textSize(Obj*);
+extern int   _nd_textLineAt(Obj*,long);
+
+/* text boxes that follow files (textfollow.c) */
+extern void  _nd_textFollow(Obj*,void*);
+extern void  _nd_followFree(Obj*);
+
+/* searching text boxes (textsearch.c) */
+extern int   _nd_searchKey(Obj*,void*,int);
+extern void  _nd_searchReset(Obj*);
+extern void  _nd_searchGrow(Obj*);
+extern void  _nd_searchTrim(Obj*,long);
+extern void  _nd_searchFree(Obj*);
+extern void  _nd_searchLine(Obj*,char*,int);
+extern int   _nd_searchHit(Obj*,char*);
+extern char *_nd_searchPrompt(Obj*);
+extern char *_nd_textLine(Obj*,int,int*);
+
+
 #if DYNAMIC_BINDING
 /*
  * we keep a table of registered objects, so that users can add their own
@@ -299,6 +376,8 @@ struct _nd_object_table {
     nd_size size;
     nd_getp getp;
     nd_setp setp;
+    nd_start start;
+    nd_key key;
 };
 
 #define SZOBJTAB	sizeof(struct _nd_object_table)
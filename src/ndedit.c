@@ -51,6 +51,26 @@ _nd_callback(Obj *obj, void* win)
 } /* _nd_callback */
 
 
+/*
+ * _nd_editKeys() is the blocking edit loop for objects that are edited
+ * a keystroke at a time:  start the object, then feed it keys until it
+ * tells us we're done.
+ */
+editCode
+_nd_editKeys(void *o, void *win, void *ev, editCode cc,
+					nd_start start, nd_key key)
+{
+    editCode rc;
+
+    if ((rc = (*start)(o, win, ev, cc)) != eNOP)
+	return rc;
+
+    while ((rc = (*key)(o, win, ndgetch(win))) == eNOP)
+	;
+    return rc;
+} /* _nd_editKeys */
+
+
 /* 
  * editString() allows editing of a string object.  Pretty much as
  * you'd expect, but we put <| and |> tabs on the editing frame to
@@ -62,22 +82,18 @@ _nd_callback(Obj *obj, void* win)
  * in a perfect world, this would handle wchar_t.  It's not a perfect
  * world yet :-(
  */
+#define STARTX	(obj->item.string.startx)
+#define CURX	(obj->item.string.curx)
+
 editCode
-editString(void* o, void* win, MEVENT* ev, editCode cc)
+startString(void* o, void* win, MEVENT* ev, editCode cc)
 {
     Obj *obj = OBJ(o);
-    int c;
-    int rc = 0;
-    int touch = 0;		/* flag marking changes to the display */
     int datalen;		/* how long is the string right now? */
-    int insert_mode;		/* inserting or overwriting characters? */
     char *data;
 
     int xdata, ydata;
 
-#define STARTX	(obj->item.string.startx)
-#define CURX	(obj->item.string.curx)
-
     if (obj == 0 || obj->Class != O_STRING) {
 	errno = EINVAL;
 	return eERROR;
@@ -93,7 +109,6 @@ editString(void* o, void* win, MEVENT* ev, editCode cc)
 	return eTAB;
 
     datalen = strlen(data);
-    insert_mode = (obj->flags & INSERT_MODE);
 
     /*
      * first, set up the initial cursor position and handle any mouse
@@ -138,106 +153,129 @@ editString(void* o, void* win, MEVENT* ev, editCode cc)
 #endif
 
     wmove(Window(win), ydata, xdata+CURX-STARTX);
-    /* and away we go! */
-    while ((c = ndgetch(win)) != EOF) {
+    return eNOP;
+} /* startString */
 
-	switch (c) {
-	case KEY_F(1):	_nd_help(objHelp(obj));	break;
+
+editCode
+keyString(void* o, void* win, int c)
+{
+    Obj *obj = OBJ(o);
+    int rc = 0;
+    int touch = 0;		/* flag marking changes to the display */
+    char *data = (char*)(obj->content);
+    int datalen = strlen(data);	/* how long is the string right now? */
+    int insert_mode = (obj->flags & INSERT_MODE);
+				/* inserting or overwriting characters? */
+    int xdata = obj->dtx + WX(win),
+	ydata = obj->dty + WY(win);
+
+    switch (c) {
+    case EOF:	return eESCAPE;		/* bail out on EOF */
+    case KEY_F(1):	_nd_help(objHelp(obj));	break;
 #if VERMIN
-	case KEY_MOUSE:	return eEVENT; 	/* mouse press; bail back to caller */
+    case KEY_MOUSE:	return eEVENT; 	/* mouse press; bail back to caller */
 #endif
-	case 'R'-'@':	return eREFRESH;
-	case ESCAPE:	return eESCAPE;
-	case KEY_BTAB:
-	case KEY_UP:	return eBACKTAB;
-	case KEY_DOWN:
-	case '\t':	return eTAB;
-	case KEY_IC:	if ((insert_mode = !insert_mode) != 0)
-			    obj->flags |= INSERT_MODE;
-			else
-			    obj->flags &= ~INSERT_MODE;
-			break;
+    case 'R'-'@':	return eREFRESH;
+    case ESCAPE:	return eESCAPE;
+    case KEY_BTAB:
+    case KEY_UP:	return eBACKTAB;
+    case KEY_DOWN:
+    case '\t':	return eTAB;
+    case KEY_IC:	if ((insert_mode = !insert_mode) != 0)
+			obj->flags |= INSERT_MODE;
+		    else
+			obj->flags &= ~INSERT_MODE;
+		    break;
 
-	case KEY_BACKSPACE:
-		if (CURX > 0) {
-		    int dix;
-
-		    for (dix=CURX; dix <= datalen; dix++)
-			data[dix-1] = data[dix];
-		    touch++;
-		    CURX--;
-		    datalen--;
-		    if (CURX < STARTX)
-			STARTX = CURX;
-		}
-		break;
+    case KEY_BACKSPACE:
+	    if (CURX > 0) {
+		int dix;
 
-	case KEY_LEFT:
-	    if (CURX == 0)
-		continue;
-	    CURX--;
-	    if (CURX < STARTX)
-		STARTX = CURX;
-	    touch++;
-	    break;
-	
-	case KEY_RIGHT:
-	    if (CURX >= datalen)
-		continue;
-	    else {
-		if (CURX-STARTX >= obj->width) {
-		    STARTX = (CURX - obj->width)+1;
-		    touch++;
-		}
-		CURX++;
+		for (dix=CURX; dix <= datalen; dix++)
+		    data[dix-1] = data[dix];
+		touch++;
+		CURX--;
+		datalen--;
+		if (CURX < STARTX)
+		    STARTX = CURX;
 	    }
 	    break;
 
-	case '\r':
-	case '\n':
-	    if ((rc = _nd_callback(obj, win)) == 0)
-		continue;
-	    return (rc < 0) ? eEXITFORM : eRETURN;
+    case KEY_LEFT:
+	if (CURX == 0)
+	    return eNOP;
+	CURX--;
+	if (CURX < STARTX)
+	    STARTX = CURX;
+	touch++;
+	break;
+    
+    case KEY_RIGHT:
+	if (CURX >= datalen)
+	    return eNOP;
+	else {
+	    if (CURX-STARTX >= obj->width) {
+		STARTX = (CURX - obj->width)+1;
+		touch++;
+	    }
+	    CURX++;
+	}
+	break;
+
+    case '\r':
+    case '\n':
+	if ((rc = _nd_callback(obj, win)) == 0)
+	    return eNOP;
+	return (rc < 0) ? eEXITFORM : eRETURN;
 
-	default:
-	    if ((c & ~0xff) || c < ' ' || CURX >= obj->item.string.maxlen) {
+    default:
+	if ((c & ~0xff) || c < ' ' || CURX >= obj->item.string.maxlen) {
+	    beep();
+	    break;
+	}
+	if (insert_mode) {
+	    /* if we're inserting, we need to PUSH the string over to
+	     * the right, a'la levee.
+	     */
+	    int ix;
+
+	    if (datalen >= obj->item.string.maxlen-1) {
 		beep();
 		break;
 	    }
-	    if (insert_mode) {
-		/* if we're inserting, we need to PUSH the string over to
-		 * the right, a'la levee.
-		 */
-		int ix;
-
-		if (datalen >= obj->item.string.maxlen-1) {
-		    beep();
-		    break;
-		}
-		for (ix=datalen; ix>=CURX; --ix)
-		    data[ix+1] = data[ix];
-		datalen++;
-	    }
-	    data[CURX++] = c;
-	    if (CURX > datalen) {
-		data[CURX] = 0;
-		datalen++;
-	    }
-	    touch++;
-	    if (CURX-STARTX >= obj->width && CURX < obj->item.string.maxlen)
-		STARTX = (CURX-obj->width)+1;
-	    break;
-
+	    for (ix=datalen; ix>=CURX; --ix)
+		data[ix+1] = data[ix];
+	    datalen++;
 	}
-
-	if (touch) {
-	    drawObj(obj, win);
-	    obj->flags |= OBJ_DIRTY;
-	    touch = 0;
+	data[CURX++] = c;
+	if (CURX > datalen) {
+	    data[CURX] = 0;
+	    datalen++;
 	}
-	wmove(Window(win), ydata, xdata+CURX-STARTX);
+	touch++;
+	if (CURX-STARTX >= obj->width && CURX < obj->item.string.maxlen)
+	    STARTX = (CURX-obj->width)+1;
+	break;
+
+    }
+
+    if (touch) {
+	drawObj(obj, win);
+	obj->flags |= OBJ_DIRTY;
     }
-    return eESCAPE;		/* bail out on EOF */
+    wmove(Window(win), ydata, xdata+CURX-STARTX);
+    return eNOP;
+} /* keyString */
+
+#undef STARTX
+#undef CURX
+
+
+editCode
+editString(void* o, void* win, MEVENT* ev, editCode cc)
+{
+    return _nd_editKeys(o, win, ev, cc, (nd_start)startString, keyString);
 } /* editString */
 
 
@@ -249,12 +287,11 @@ editString(void* o, void* win, MEVENT* ev, editCode cc)
  */
 #define BUTTON_CLICK_DELAY	100000
 editCode
-editButton(void* o, void* win, MEVENT* ev, editCode cc)
+startButton(void* o, void* win, MEVENT* ev, editCode cc)
 {
     Obj* obj = OBJ(o);
     int xdata, ydata;
     int rc = 0;
-    unsigned int c;
 
     if (obj == 0 || obj->Class != O_BUTTON) {
 	errno = EINVAL;
@@ -284,38 +321,56 @@ editButton(void* o, void* win, MEVENT* ev, editCode cc)
 #endif
 
     wmove(Window(win), ydata, xdata);
-    while ((c = ndgetch(win)) != EOF) {
-	switch (c) {
-	case KEY_F(1):	_nd_help(objHelp(obj));	break;
+    return eNOP;
+} /* startButton */
+
+
+editCode
+keyButton(void* o, void* win, int c)
+{
+    Obj* obj = OBJ(o);
+    int xdata = obj->dtx + WX(win),
+	ydata = obj->dty + WY(win);
+    int rc = 0;
+
+    switch (c) {
+    case EOF:	return eESCAPE;
+    case KEY_F(1):	_nd_help(objHelp(obj));	break;
 #if VERMIN
-	case KEY_MOUSE:	return eEVENT;
+    case KEY_MOUSE:	return eEVENT;
 #endif
-	case ESCAPE:	return eESCAPE;
-	case 'R'-'@':	return eREFRESH;
-	case KEY_UP:
-	case KEY_LEFT:
-	case KEY_BTAB:	return eBACKTAB;
-	case KEY_DOWN:
-	case KEY_RIGHT:
-	case '\t':	return eTAB;
-	case '\r':	
-	case '\n':
-			CLICKED(obj);
-			drawObj(obj,win);
-			REGULAR(obj);
-			wmove(Window(win), ydata, xdata);
-			wrefresh(Window(win));
-			usleep(BUTTON_CLICK_DELAY);
-			if ((rc = _nd_callback(obj,win)) == 0)
-			    break;
-			drawObj(obj,win);
-			return (rc < 0) ? eEXITFORM : eRETURN;
-	default:	beep();				break;
-	}
-	wmove(Window(win), ydata, xdata);
-	wrefresh(Window(win));
+    case ESCAPE:	return eESCAPE;
+    case 'R'-'@':	return eREFRESH;
+    case KEY_UP:
+    case KEY_LEFT:
+    case KEY_BTAB:	return eBACKTAB;
+    case KEY_DOWN:
+    case KEY_RIGHT:
+    case '\t':	return eTAB;
+    case '\r':	
+    case '\n':
+		    CLICKED(obj);
+		    drawObj(obj,win);
+		    REGULAR(obj);
+		    wmove(Window(win), ydata, xdata);
+		    wrefresh(Window(win));
+		    usleep(BUTTON_CLICK_DELAY);
+		    if ((rc = _nd_callback(obj,win)) == 0)
+			break;
+		    drawObj(obj,win);
+		    return (rc < 0) ? eEXITFORM : eRETURN;
+    default:	beep();				break;
     }
-    return eESCAPE;
+    wmove(Window(win), ydata, xdata);
+    wrefresh(Window(win));
+    return eNOP;
+} /* keyButton */
+
+
+editCode
+editButton(void* o, void* win, MEVENT* ev, editCode cc)
+{
+    return _nd_editKeys(o, win, ev, cc, (nd_start)startButton, keyButton);
 } /* editButton */
 
 
@@ -327,13 +382,11 @@ editButton(void* o, void* win, MEVENT* ev, editCode cc)
  * Checkboxes have their callback called every time they change state.
  */
 editCode
-editCheck(void* o, void* win, MEVENT* ev, editCode cc)
+startCheck(void* o, void* win, MEVENT* ev, editCode cc)
 {
     Obj* obj = OBJ(o);
     int xdata, ydata;
-    int touch = 0;
     int rc;
-    unsigned int c;
     char *data;
 
     if (obj == 0 || obj->Class != O_CHECK) {
@@ -364,42 +417,60 @@ editCheck(void* o, void* win, MEVENT* ev, editCode cc)
 #endif
 
     wmove(Window(win), ydata, xdata);
-    while ((c = ndgetch(win)) != EOF) {
-	switch (c) {
-	case KEY_F(1):	_nd_help(objHelp(obj));	break;
+    return eNOP;
+} /* startCheck */
+
+
+editCode
+keyCheck(void* o, void* win, int c)
+{
+    Obj* obj = OBJ(o);
+    int xdata = obj->dtx + WX(win),
+	ydata = obj->dty + WY(win);
+    int touch = 0;
+    int rc;
+    char *data = (char*)(obj->content);
+
+    switch (c) {
+    case EOF:	return eESCAPE;
+    case KEY_F(1):	_nd_help(objHelp(obj));	break;
 #if VERMIN
-	case KEY_MOUSE:	return eEVENT;
+    case KEY_MOUSE:	return eEVENT;
 #endif
-	case ESCAPE:	return eESCAPE;
-	case 'R'-'@':	return eREFRESH;
-	case KEY_UP:
-	case KEY_LEFT:
-	case KEY_BTAB:	return eBACKTAB;
-	case KEY_DOWN:
-	case KEY_RIGHT:
-	case '\t':	return eTAB;
-	case '\n':
-	case '\r':	return eRETURN;
-	case ' ':	*data = !(*data);
-			if ((rc = _nd_callback(obj,win)) == 0)
-			    *data = !(*data);
-			else if (rc < 0)
-			    return eEXITFORM;
-			else
-			    touch++;
-			break;
-	default:	beep();				break;
-	}
-	if (touch) {
-	    obj->flags |= OBJ_DIRTY;
-	    drawObj(obj,win);
-	    touch = 0;
-	}
-	wmove(Window(win), ydata, xdata);
-	wrefresh(Window(win));
+    case ESCAPE:	return eESCAPE;
+    case 'R'-'@':	return eREFRESH;
+    case KEY_UP:
+    case KEY_LEFT:
+    case KEY_BTAB:	return eBACKTAB;
+    case KEY_DOWN:
+    case KEY_RIGHT:
+    case '\t':	return eTAB;
+    case '\n':
+    case '\r':	return eRETURN;
+    case ' ':	*data = !(*data);
+		    if ((rc = _nd_callback(obj,win)) == 0)
+			*data = !(*data);
+		    else if (rc < 0)
+			return eEXITFORM;
+		    else
+			touch++;
+		    break;
+    default:	beep();				break;
+    }
+    if (touch) {
+	obj->flags |= OBJ_DIRTY;
+	drawObj(obj,win);
     }
+    wmove(Window(win), ydata, xdata);
+    wrefresh(Window(win));
+    return eNOP;
+} /* keyCheck */
+
 
-    return eESCAPE;
+editCode
+editCheck(void* o, void* win, MEVENT* ev, editCode cc)
+{
+    return _nd_editKeys(o, win, ev, cc, (nd_start)startCheck, keyCheck);
 } /* editCheck */
 
 
@@ -411,66 +482,79 @@ static editCode
 listItemToggle(Obj* obj, void* win, int index)
 {
     int rc = 0;
+    int was;
 
-    if (obj->item.list.items == 0 || index >= obj->item.list.nritems)
+    if (obj->item.list.items == 0 || index < 0 || index >= LIST_ROWS(obj))
 	return eNOP;
+    index = LIST_ITEM(obj, index);
+
+    was = _nd_listIsSelected(obj, index);
 
-#define TOGGLE(x)	((x) = !(x))
     if (obj->flags & MENU_LIST) {
-	TOGGLE(obj->item.list.items[index].selected);
+	_nd_listSelect(obj, index, !was);
 	if ((rc = _nd_callback(obj, win)) == 0)
-	    TOGGLE(obj->item.list.items[index].selected);
+	    _nd_listSelect(obj, index, was);
 	return (rc < 0) ? eEXITFORM : (rc > 0) ? eRETURN : eNOP;
     }
     else if (obj->flags & RADIO_LIST) {
-	if (!obj->item.list.items[index].selected) {
-	    int x;
-
-	    obj->item.list.items[index].selected = 1;
-	    for (x=0; x<obj->item.list.nritems; x++)
-		if (x != index)
-		    obj->item.list.items[x].selected = 0;
-	}
+	/* selecting a radio item unselects the old one */
+	_nd_listSelect(obj, index, 1);
 	rc = _nd_callback(obj, win);
     }
     else {
-	TOGGLE(obj->item.list.items[index].selected);
+	_nd_listSelect(obj, index, !was);
 	if ((rc = _nd_callback(obj, win)) == 0)
-	    TOGGLE(obj->item.list.items[index].selected);
+	    _nd_listSelect(obj, index, was);
     }
-#undef TOGGLE
     return (rc < 0) ? eEXITFORM : eNOP;
 } /* listItemToggle */
 
 
+/*
+ * filteredHotkey() is a local function that finds the next row of a
+ * filtered list that starts with a hotkey.  The hotkey index is built
+ * for the whole list, so just walk the (hopefully short) view.
+ */
+static int
+filteredHotkey(Obj *obj, int c)
+{
+    int nrrows = obj->item.list.nrview;
+    int row, i;
+    ListItem *it;
+    char *key;
+
+    for (i = 1; i <= nrrows; i++) {
+	row = (obj->item.list.cury + i) % nrrows;
+	it = &obj->item.list.items[obj->item.list.view[row]];
+	key = (obj->flags & SHOW_IDS) ? it->id : it->item;
+	if (key && toupper((unsigned char)key[0]) == toupper(c))
+	    return row;
+    }
+    return -1;
+} /* filteredHotkey */
+
+
 /*
  * editList() does editing on any of the family of list objects.
  */
+#define TOPY		(obj->item.list.topy)
+#define CURY		(obj->item.list.cury)
+#define NRITEMS		LIST_ROWS(obj)
+#define WINY		(obj->depth)
+
 editCode
-editList(void* o, void* win, MEVENT* ev, editCode cc)
+startList(void* o, void* win, MEVENT* ev, editCode cc)
 {
     Obj *obj = OBJ(o);
-    unsigned int c;
     int dy;			/* delta y for page up/page down movement */
     int ntopy, off_y, ncury;
     int yp;			/* cursor */
-    int touch = 0;		/* flag marking changes to the display */
-#if HAVE_CURS_SET
-    int cursor_visibility;	/* hide the cursor when doing a menu */
-#endif
-    editCode rc = eESCAPE;	/* default to bailing out */
-    int withids;		/* are we displaying IDs? */
+    editCode rc;
     int ismenu;			/* if it's a menu list, there is some
 				 * special handling
 				 */
-    int x;
     int xdata, ydata;
 
-#define TOPY		(obj->item.list.topy)
-#define CURY		(obj->item.list.cury)
-#define NRITEMS		(obj->item.list.nritems)
-#define WINY		(obj->depth)
-
     if (obj == 0 || obj->Class != O_LIST) {
 	errno = EINVAL;
 	return eERROR;
@@ -483,15 +567,12 @@ editList(void* o, void* win, MEVENT* ev, editCode cc)
     if (OBJ_READONLY(obj))
 	return eTAB;
 
-    withids = obj->flags & SHOW_IDS;
-
     if ((ismenu = (obj->flags & MENU_LIST)) != 0) {
 	/*
 	 * if we're a menu list, unselect everything
 	 */
 	if (obj->item.list.items)
-	    for (yp=0; yp<obj->item.list.nritems; yp++)
-		obj->item.list.items[yp].selected = 0;
+	    _nd_listClear(obj);
     }
 
     /*
@@ -514,7 +595,7 @@ editList(void* o, void* win, MEVENT* ev, editCode cc)
 	    }
 	    CURY -= dy;
 	}
-	else if (yp == obj->depth && TOPY < obj->item.list.nritems) {
+	else if (yp == obj->depth && TOPY < NRITEMS) {
 	    /* scroll forwards */
 	    ntopy = TOPY + WINY;
 	    off_y = CURY - TOPY;
@@ -531,8 +612,8 @@ editList(void* o, void* win, MEVENT* ev, editCode cc)
 	    /* convert yp into an list item index */
 
 	    yp += TOPY;
-	    if (yp > obj->item.list.nritems)
-		yp = obj->item.list.nritems;
+	    if (yp > NRITEMS)
+		yp = NRITEMS;
 
 	    /* and assign it back into the object */
 	    CURY = yp;
@@ -551,150 +632,180 @@ editList(void* o, void* win, MEVENT* ev, editCode cc)
 #endif
 
 #if HAVE_CURS_SET
-    cursor_visibility = curs_set(0);
+    /* hide the cursor when doing a menu */
+    obj->item.list.cursor = curs_set(0);
 #endif
-    /* and away we go! */
-    while ((c = ndgetch(win)) != EOF) {
+    return eNOP;
+} /* startList */
 
-	switch (c) {
-	case KEY_F(1): _nd_help(objHelp(obj)); break;
+
+editCode
+keyList(void* o, void* win, int c)
+{
+    Obj *obj = OBJ(o);
+    int dy;			/* delta y for page up/page down movement */
+    int ntopy, off_y, ncury;
+    int touch = 0;		/* flag marking changes to the display */
+    int moved = 0;		/* flag marking cursor movement */
+    int otopy = TOPY,		/* where the list was before the key */
+	ocury = CURY;
+    editCode rc = eNOP;
+    int ismenu = obj->flags & MENU_LIST;
+				/* if it's a menu list, there is some
+				 * special handling
+				 */
+    int x;
+
+    switch (c) {
+    case EOF:		rc = eESCAPE;	goto bailout;
+    case KEY_F(1): _nd_help(objHelp(obj)); break;
 #if VERMIN
-	case KEY_MOUSE:	rc = eEVENT; 	goto bailout;
+    case KEY_MOUSE:	rc = eEVENT; 	goto bailout;
 #endif
-	case 'R'-'@':	rc = eREFRESH;	goto bailout;
-	case ESCAPE:	rc = eESCAPE;	goto bailout;
-	case KEY_BTAB:
-	case KEY_LEFT:	rc = eBACKTAB;	goto bailout;
-	case KEY_RIGHT:
-	case '\t':	rc = eTAB;	goto bailout;
-
-	case KEY_HOME:
+    case 'R'-'@':	rc = eREFRESH;	goto bailout;
+    case ESCAPE:	rc = eESCAPE;	goto bailout;
+    case KEY_BTAB:
+    case KEY_LEFT:	rc = eBACKTAB;	goto bailout;
+    case KEY_RIGHT:
+    case '\t':	rc = eTAB;	goto bailout;
+
+    case KEY_HOME:
+	TOPY = 0;
+	if (CURY > obj->depth)
+	    CURY = 0;
+	moved++;
+	break;
+
+    case KEY_END:
+	TOPY = NRITEMS - obj->depth;
+	if (TOPY < 0)
 	    TOPY = 0;
-	    if (CURY > obj->depth)
-		CURY = 0;
-	    touch++;
-	    break;
-
-	case KEY_END:
-	    TOPY = obj->item.list.nritems - obj->depth;
-	    if (CURY < TOPY)
-		CURY = TOPY;
-	    touch++;
-	    break;
-
-	case 'U'-'@':
-	case KEY_PPAGE:
-	    dy = obj->depth;
-	    TOPY -= dy;
-	    if (TOPY < 0) {
-		dy += TOPY;
-		TOPY = 0;
-	    }
-	    CURY -= dy;
-	    touch++;
-	    break;
-
-	case '-':
-	case KEY_UP:
-	    if (CURY == 0)
-		continue;
-	    CURY--;
-	    if (CURY < TOPY)
-		TOPY = CURY;
-	    touch++;
-	    break;
-	
-	case 'D'-'@':
-	case KEY_NPAGE:
-	    /* scroll forwards */
-	    ntopy = TOPY + WINY;
-	    off_y = CURY - TOPY;
-
-	    if (ntopy + WINY < NRITEMS)
-		TOPY = ntopy;
-	    else if (NRITEMS - WINY > TOPY)
-		TOPY = NRITEMS - WINY;
-
-	    ncury = TOPY + off_y;
-	    CURY = (ncury < NRITEMS) ? ncury : (NRITEMS-1);
+	if (CURY < TOPY)
+	    CURY = TOPY;
+	moved++;
+	break;
+
+    case 'U'-'@':
+    case KEY_PPAGE:
+	dy = obj->depth;
+	TOPY -= dy;
+	if (TOPY < 0) {
+	    dy += TOPY;
+	    TOPY = 0;
+	}
+	CURY -= dy;
+	moved++;
+	break;
+
+    case '-':
+    case KEY_UP:
+	if (CURY == 0)
+	    return eNOP;
+	CURY--;
+	if (CURY < TOPY)
+	    TOPY = CURY;
+	moved++;
+	break;
+    
+    case 'D'-'@':
+    case KEY_NPAGE:
+	/* scroll forwards */
+	ntopy = TOPY + WINY;
+	off_y = CURY - TOPY;
+
+	if (ntopy + WINY < NRITEMS)
+	    TOPY = ntopy;
+	else if (NRITEMS - WINY > TOPY)
+	    TOPY = NRITEMS - WINY;
+
+	ncury = TOPY + off_y;
+	CURY = (ncury < NRITEMS) ? ncury : (NRITEMS-1);
+	if (CURY < 0)
+	    CURY = 0;
+
+	moved++;
+	break;
+
+    case '+':
+    case KEY_DOWN:
+	if (CURY < NRITEMS-1) {
+	    CURY++;
+	    if (CURY >= TOPY+obj->depth)
+		TOPY++;
+	    moved++;
+	}
+	break;
 
-	    touch++;
+    case KEY_BACKSPACE:
+    case KEY_DC:
+	if (!(obj->flags & DEL_LIST))
 	    break;
-
-	case '+':
-	case KEY_DOWN:
-	    if (CURY < obj->item.list.nritems-1) {
-		CURY++;
-		if (CURY >= TOPY+obj->depth)
-		    TOPY++;
-		touch++;
-	    }
+	rc = listItemToggle(obj, win, CURY);
+	if (rc == eEXITFORM || rc == eRETURN)
+	    goto bailout;
+	touch = 1;
+	break;
+
+    case ' ':
+	if (ismenu)
+	    return eNOP;
+    case '\n':
+    case '\r':
+	if (!(obj->flags & CR_LIST))
 	    break;
-
-	case KEY_BACKSPACE:
-	case KEY_DC:
-	    if (!(obj->flags & DEL_LIST))
-		break;
-	    rc = listItemToggle(obj, win, CURY);
-	    if (rc == eEXITFORM || rc == eRETURN)
-		goto bailout;
-	    touch = 1;
+	rc = listItemToggle(obj, win, CURY);
+	if (rc == eEXITFORM || rc == eRETURN)
+	    goto bailout;
+	touch = 1;
+	break;
+
+    default:
+	if (obj->flags & NO_HOTKEYS)
 	    break;
-
-	case ' ':
-	    if (ismenu)
-		continue;
-	case '\n':
-	case '\r':
-	    if (!(obj->flags & CR_LIST))
-		break;
-	    rc = listItemToggle(obj, win, CURY);
-	    if (rc == eEXITFORM || rc == eRETURN)
-		goto bailout;
-	    touch = 1;
-	    break;
-
-	default:
-	    if (obj->flags & NO_HOTKEYS)
-		break;
-	    if (obj->item.list.items == 0)
-		break;
-	    c = toupper(c);
-	    for (x = (CURY+1) % obj->item.list.nritems;
-					    x != CURY;
-		    x = (x+1) % obj->item.list.nritems) {
-
-		if (withids) {
-		    if (c == toupper(obj->item.list.items[x].id[0]))
-			break;
-		}
-		else if (c == toupper(obj->item.list.items[x].item[0]))
-			break;
-	    }
-	    if (x != CURY) {
-		CURY = x;
-		if (x < TOPY)
-		    TOPY=x;
-		else if (x >= TOPY+obj->depth)
-		    TOPY = (CURY-obj->depth)+1;
-
-		touch = 1;
-	    }
+	if (c <= ' ' || c > 255 || !isprint(c))
 	    break;
+	if (obj->item.list.view)
+	    x = filteredHotkey(obj, c);
+	else
+	    x = _nd_listHotkey(obj, c);
+	if (x >= 0 && x != CURY) {
+	    CURY = x;
+	    if (x < TOPY)
+		TOPY=x;
+	    else if (x >= TOPY+obj->depth)
+		TOPY = (CURY-obj->depth)+1;
+
+	    moved++;
 	}
+	break;
+    }
 
-	if (touch) {
-	    obj->flags |= OBJ_DIRTY;
-	    drawObj(obj, win);
-	    touch = 0;
-	}
+    if (touch) {
+	obj->flags |= OBJ_DIRTY;
+	drawObj(obj, win);
     }
-#undef TOPY
-#undef CURY
+    else if (moved) {
+	/* only redraw the rows that changed */
+	obj->flags |= OBJ_DIRTY;
+	_nd_drawListRows(obj, win, otopy, ocury);
+    }
+    return eNOP;
 
 bailout:
 #if HAVE_CURS_SET
-    curs_set(cursor_visibility);
+    curs_set(obj->item.list.cursor);
 #endif
     return rc;
+} /* keyList */
+
+#undef TOPY
+#undef CURY
+#undef NRITEMS
+#undef WINY
+
+
+editCode
+editList(void* o, void* win, MEVENT* ev, editCode cc)
+{
+    return _nd_editKeys(o, win, ev, cc, (nd_start)startList, keyList);
 } /* editList */
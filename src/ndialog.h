@@ -32,7 +32,9 @@ typedef void* LIA;
 LIA newLIA(ListItem *, int);
 void deleteLIA(LIA);
 int addToLIA(LIA, char*, char*, char*);
+int addManyToLIA(LIA, ListItem*, int);
 int delFromLIA(LIA, int);
+int delRangeFromLIA(LIA, int, int);
 int LIAcount(LIA);
 ListItem *LIAlist(LIA);
 
@@ -65,12 +67,20 @@ ndObject newCancelButton(int,char*,pfo,char*);
 		/* x, prompt, callback, help */
 ndObject newOKButton(int,char*,pfo,char*);
 		/* x, prompt, callback, help */
-ndObject newText(int,int,int,int,int,char*,char*,char*,pfo,char*);
+ndObject newText(int,int,int,int,long,char*,char*,char*,pfo,char*);
 		/* x, y, width, height, size, prompt, prefix, bfr,
 		 * callback, help
 		 */
 ndObject newHelp(int,int,int,int,char*,pfo,char*);
 		/* x, y, width, height, document, callback, help */
+ndObject newTailText(int,int,int,int,char*,long,char*,char*,pfo,char*);
+		/* x, y, width, height, file, maxsize, prompt, prefix,
+		 * callback, help
+		 */
+ndObject newStreamText(int,int,int,int,int,long,char*,char*,pfo,char*);
+		/* x, y, width, height, fd, maxsize, prompt, prefix,
+		 * callback, help
+		 */
 ndObject newList(int,int,int,int,int,ListItem *,char*,char*,int,pfo,char*);
 		/* x, y, width, height, nritems, items,
 		 * prompt, prefix, displayas, callback, help */
@@ -123,6 +133,14 @@ int   setButtonDataArea(ndObject,int,int);	/* set the display area for a button
 int   currentSelection(ndObject);	/* what's the current list selection? */
 ListItem *getObjList(ndObject);		/* get the list out of a list object */
 int getObjListSize(ndObject);		/* get the number of items in a list */
+int   nrSelected(ndObject);		/* how many list items are selected? */
+int   nextSelection(ndObject,int);	/* next selected list item */
+int   selectListItems(ndObject,int,char*);/* bulk (un)select list items */
+#define SELECT_NONE	0
+#define SELECT_ALL	1
+#define SELECT_INVERT	2
+#define SELECT_MATCHING	3		/* items matching a shell pattern */
+int   setListFilter(ndObject,char*);	/* only show items containing this */
 int   getObjCursor(ndObject);		/* get the current position in an
 					 * applicable object
 					 */
@@ -210,6 +228,50 @@ int MENU(ndObject,int,int,char*,char*,int);	/* process an object chain */
 					 * function returned eEXITFORM */
 #define	MENU_CANCEL	1		/* CANCEL button pressed */
 #define	MENU_ESCAPE	2		/* ESC pressed */
+#define MENU_RUNNING	3		/* formStep(): the form wants more
+					 * input */
+
+/* Forms that don't take over the program until they're done
+ */
+typedef void* ndForm;
+
+ndForm newForm(ndObject,int,int,char*,char*,int);	/* put up a form */
+	/* chain,width,depth,title,prompt,flags */
+int formFd(ndForm);			/* fd to wait for input on */
+int formStep(ndForm);			/* handle waiting input */
+void deleteForm(ndForm);		/* take the form down */
+
+/* Timers and idle callbacks run while a form waits for input.  A callback
+ * returns nonzero to cancel itself.
+ */
+typedef int (*ndTimer)(ndForm, void*);
+
+int addFormTimer(ndForm,int,int,ndTimer,void*);	/* returns a timer handle */
+	/* form,msec,periodic,callback,arg */
+int addFormIdle(ndForm,ndTimer,void*);	/* call when waiting for input */
+	/* form,callback,arg */
+int removeFormTimer(ndForm,int);	/* cancel a timer or idle callback */
+int formTimeout(ndForm);		/* msec until the next timer, or -1 */
+
+/* Compiled forms are laid out once and can be shown over and over.
+ */
+ndForm compileForm(ndObject,int,int,char*,char*,int);	/* lay out a form */
+	/* chain,width,depth,title,prompt,flags */
+int runForm(ndForm);			/* MENU() a compiled form */
+	/* (deleteForm() throws a compiled form away) */
+
+
+/* A gauge stays on the screen between updates, and only repaints when
+ * the percentage or prompt change.
+ */
+typedef void* ndGauge;
+
+ndGauge openGauge(char*,char*,int,int);	/* put up a gauge */
+	/* title,prompt,height,width */
+int updateGauge(ndGauge,int,char*);	/* set a new percentage and/or prompt */
+	/* gauge,percent,prompt (0 for no change) */
+int flushGauge(ndGauge);		/* paint any held-back update */
+void closeGauge(ndGauge);		/* take the gauge down */
 
 
 /* Functions that do exactly the same as libdialog functions, so
@@ -243,11 +305,7 @@ ndObject newEditableList(int,int,int,int,LIA,char*,pfo,pfo,pfo,char*);
 ndObject ListWidgetObj(ndObject obj);
 
 typedef int (*pfsel)(void*);
-ndObject newFileSelector(int,int,int,int,char*,char*,char*,int,pfsel,pfo,pfo,char*);
-		/* x, y, list_width, list_height, prompt,
-		 * start_dir, result, result size, file select function,
-		 * chdir_callback, fsel_callback, help
-		 */
+		/* (file selectors are declared in fileselector.h) */
 
 /*
  * color definitions (can be reset if you really want)
@@ -30,9 +30,11 @@
 #include "nd_objects.h"
 
 #include <errno.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <termios.h>
+#include <sys/time.h>
 
 /* MENU() keeps an array of object information for each object it wants to
  * deal with.  This array contains a pointer to the object, the origin of
@@ -73,25 +75,33 @@ static void refreshMenu(refreshParms* p);
 #if !HAVE_PANEL
 /* Panels are just used so that nested windows can be popped up and cleaned
  * up after.  If the curses library doesn't support panels (BSD curses),
- * fake panelling by keeping a list of active windows and refreshing the
- * whole stack at the first input after exiting a menu.
+ * fake panelling by keeping a list of active windows.  When a window is
+ * pushed, we copy what's on the screen underneath it into a backing
+ * window the same size, and when it's popped we put that back.  If there
+ * isn't a backing window, we fall back to refreshing the whole stack at
+ * the first input after exiting a menu.
  */
 struct frame {
     struct frame *up;
     struct frame *down;
     refreshParms *rf;
+    WINDOW *under;	/* what was on the screen under this frame */
 } ;
 
-static struct frame bottom = { 0, 0, 0 };
+static struct frame bottom = { 0, 0, 0, 0 };
 static struct frame *top = &bottom;
 static int needredraw = 0;
 
 static void
-push(refreshParms *win, struct frame *current)
+push(refreshParms *win, struct frame *current, WINDOW *under)
 {
     current->down = top;
     current->rf = win;
     current->up = 0;
+    current->under = under;
+
+    if (under)
+	overwrite(curscr, under);
 
     top->up = current;
     top = current;
@@ -100,9 +110,15 @@ push(refreshParms *win, struct frame *current)
 static void
 pop()
 {
+    if (top->under) {
+	touchwin(top->under);
+	wrefresh(top->under);
+    }
+    else
+	needredraw = 1;
+
     top = top->down;
     top->up = 0;
-    needredraw = 1;
 }
 
 void
@@ -113,11 +129,17 @@ ndredraw()
     if (needredraw) {
 	needredraw = 0;
 
-	for (p = &bottom; p; p = p->up)
-	    if (p->rf) {
-		wclear( Window(top->rf->menu) );
-		refreshMenu(top->rf);
-	    }
+	for (p = bottom.up; p; p = p->up) {
+	    if (p == bottom.up)
+		wclear( Window(p->rf->menu) );
+	    refreshMenu(p->rf);
+#if HAVE_DOUPDATE
+	    wnoutrefresh( Window(p->rf->menu) );
+#endif
+	}
+#if HAVE_DOUPDATE
+	doupdate();
+#endif
     }
 }
 #endif
@@ -260,42 +282,59 @@ refreshMenu(refreshParms* p)
 
 
 /*
- * MENU() builds up a form, then spits it out on the screen and
- * lets the user type into it.
- * If the display has a mouse (cf the ncurses mouse device support)
- * the user can use the mouse to navigate between fields on the form.
- *
- * Before calling menu for the first time, curses MUST be active and properly
- * configured (you don't need to set raw mode, but you do need to set mouse
- * event masks and color pairs.)
- *
- * MENU expects
- *	chain	-- an object chain, built by ObjChain or friends
- *	width	-- the expected width of the form (-1 for autosizing)
- *	depth	-- the expected depth of the form (-1 for autosizing)
- *	title	-- the titlebar at the top of the form.
- *	prompt	-- informative text that is placed at the top of the
- *		   form.
- *	flags	-- special display options (fancy windows, align prompt
- *		   text left or right, [more to follow, I'm sure])
- *
- * MENU returns
- *	0 if the user accepted the input on the form
- *	1 if the user cancelled out of the form (via a cancel button)
- *	2 if the user pressed ESCAPE to flee the form
- *     -1 if something horrible happened when setting up the form.
+ * Timers and idle callbacks that are attached to a form.  They are run
+ * from ndgetch() while the form is waiting for input.
  */
-int
-MENU(void *chain, int width, int depth, char *title, char *prompt, int flags)
-{
-    extern void *coreSortObjChain(void *, int (*)(const void*, const void*));
+typedef struct {
+    int id;			/* handle given back to the caller */
+    int idle;			/* an idle callback, not a timer */
+    int periodic;		/* keep firing every interval msec */
+    long interval;		/* msec between firings */
+    struct timeval due;		/* when this timer fires next */
+    int (*fn)(void*,void*);	/* callback (0 when it's been removed) */
+    void *arg;			/* passed to the callback */
+} formTimer;
+
+/* the last timer handle given out.  Handles are never reused, even
+ * on another form, so a handle that's been forgotten about by a form
+ * that went away can't turn up again on a new one that's been built
+ * at the same address.
+ */
+static int timerid = 0;
 
-    Obj *cur;
-    Obj **items = 0;		/* list of items in the chain */
-    int nritems = 0;		/* number of items in the chain */
-    int hasOKbutton = 0;	/* set true if any OK buttons */
-    int hasCANCELbutton = 0;	/* set true if any CANCEL buttons */
-    int hasbuttons = 0;		/* set true if there are any buttons */
+/* timers that come due within TIMER_SLOP msec of each other are run
+ * together so they share a screen update.
+ */
+#define TIMER_SLOP	10
+
+
+/*
+ * A compiled form remembers what each object looked like when it was
+ * laid out, so runForm() can tell if the layout can be used again.
+ */
+typedef struct {
+    char *title;		/* title (setObjTitle() makes a new one) */
+    int x, y;			/* origin */
+    int width, depth;		/* size */
+} formShape;
+
+
+/*
+ * A Form is everything MENU() needs to keep around while an object chain
+ * is on the screen:  the laid-out items, the window and panel they are
+ * drawn in, and the parameters for refreshMenu().  Splitting it out of
+ * MENU() lets other things (gauges, for instance) keep a form open across
+ * calls instead of building and tearing down a window every time.
+ */
+typedef struct {
+    refreshParms rp;		/* parameters passed to refreshMenu() */
+    int firstbutton;		/* first button (index into items[]) */
+    int hasOKbutton;		/* set true if any OK buttons */
+    int hasCANCELbutton;	/* set true if any CANCEL buttons */
+    int formx, formy;		/* origin of the data part of the window;
+				 * all non-button object manipulation is
+				 * relative to this origin
+				 */
     WINDOW *menu;		/* the curses window we play with */
 #if HAVE_PANEL
     PANEL *pan;			/* curses doesn't support backing stores,
@@ -306,26 +345,57 @@ MENU(void *chain, int width, int depth, char *title, char *prompt, int flags)
 				 */
 #else
     struct frame frame;
+    WINDOW *under;		/* backing store for the frame */
 #endif
-    int formx=1, formy=1;	/* origin of the data part of the window;
-				 * all non-button object manipulation is
-				 * relative to this origin
+    Display *display;		/* our magic display thing */
+    Display dpy;		/* .. which lives here */
+#if VERMIN
+    mmask_t mev;		/* mouse mask to restore when we're done */
+    MEVENT mouse;		/* for handling mouse clicks */
+#else
+    long mouse;			/* dummy the field if curses doesn't support */
+				/* vermin */
+#endif
+    int idx;			/* items[] index to the object we are currently
+				 * working with.
+				 */
+    int status;			/* MENU_RUNNING until the form is done */
+    formTimer *timers;		/* timers and idle callbacks */
+    int nrtimers;		/* how many are in use */
+    int sztimers;		/* how many there is room for */
+    int ticking;		/* _nd_formTick() is running callbacks */
+    int stepping;		/* formStep() is polling for input */
+    void *hits;			/* hit grid for mouse clicks */
+    int isopen;			/* the form is on the screen */
+    void *chain;		/* the (sorted) chain we were laid out from */
+    int askwidth, askdepth;	/* the size we were asked to make the form */
+    int cols, lines;		/* the size of the screen at layout time */
+    formShape *shape;		/* what the objects looked like at layout
+				 * time (compiled forms only)
 				 */
+} Form;
+
+
+/*
+ * layoutForm() sorts the chain, figures out how big the form needs to be,
+ * and builds the items[] array that the rest of MENU() works from.  It
+ * returns 0 if the form can be laid out, -1 (with errno set) otherwise.
+ */
+static int
+layoutForm(Form *f, void *chain, int width, int depth,
+				 char *title, char *prompt, int flags)
+{
+    extern void *coreSortObjChain(void *, int (*)(const void*, const void*));
+
+    Obj *cur;
+    Obj **items = 0;		/* list of items in the chain */
+    int nritems = 0;		/* number of items in the chain */
+    int hasbuttons = 0;		/* set true if there are any buttons */
     int interiorwidth;		/* width of the active part of the menu */
-    refreshParms menuInfo;	/* parameters passed to refreshMenu() */
-    int firstbutton = 0;	/* first button (index into items[]) */
     int buttony;		/* start line of the button bar */
     int buttonwidth = 0;	/* how much real estate a button needs */
     int autosized = 0;		/* TRUE if we autosized the form */
-    int idx;			/* items[] index to the object we are currently
-				 * working with.
-				 */
-    int incr;			/* direction to go to reach the next object
-				 * to edit
-				 */
-    int rc = eNOP;		/* return code from editObj() */
-				/* it does anything else */
-    int status = MENU_ERROR;	/* return status from input loop */
+    int idx;
     int promptwidth;		/* how wide is the prompt? */
 #if WITH_NCURSES
     int fancy = (flags & FANCY_MENU) ? 1 : 0;
@@ -333,31 +403,28 @@ MENU(void *chain, int width, int depth, char *title, char *prompt, int flags)
     int fancy = 0;
 #endif
     int wholescreen = 0;
-				/* fancy borders on windows? */
-#if VERMIN
-    int bymouse;		/* editing flag to tell editObj() that it */
-				/* needs to deal with a mouse event before */
-    MEVENT mouse;		/* for handling mouse clicks */
-    mmask_t mev;
-#else
-    long mouse;			/* dummy the field if curses doesn't support */
-				/* vermin */
-#endif
-    Display *display;		/* our magic display thing */
 
+    f->formx = f->formy = 1;
+    f->hasOKbutton = f->hasCANCELbutton = 0;
+    f->firstbutton = 0;
+    f->askwidth = width;
+    f->askdepth = depth;
+    f->cols = COLS;
+    f->lines = LINES;
 
     if (chain != 0) {
 	/* sort all buttons to the end of the chain */
 	chain = coreSortObjChain(chain, sortbybuttononly);
+	f->chain = chain;
 
 	/* count up how many items this chain has */
 	cur = OBJ(chain);
 	nritems = 0;
 	do {
 	    if (ISCANCEL(cur))
-		hasCANCELbutton = 1;
+		f->hasCANCELbutton = 1;
 	    else if (ISCONFIRM(cur))
-		hasOKbutton = 1;
+		f->hasOKbutton = 1;
 	    nritems++;
 	    cur = cur->next;
 
@@ -380,7 +447,7 @@ MENU(void *chain, int width, int depth, char *title, char *prompt, int flags)
 	width = COLS;
 	depth = LINES;
 	wholescreen = 1;
-	formy += strdepth(prompt);
+	f->formy += strdepth(prompt);
     }
     else if (width == -1 || depth == -1) {
 	/* We need to figure out the form dimensions from the
@@ -422,7 +489,7 @@ MENU(void *chain, int width, int depth, char *title, char *prompt, int flags)
 	/* if there's a prompt, add room for it */
 	xp = promptwidth;	/* previously computed from strwidth() */
 	dy = strdepth(prompt);
-	formy += dy;
+	f->formy += dy;
 
 	if (xp > width)
 	    width = xp;
@@ -437,7 +504,7 @@ MENU(void *chain, int width, int depth, char *title, char *prompt, int flags)
     } /* computing form size */
     else {
 	/* adjust the Y origin for the size of the prompt */
-	formy += strdepth(prompt);
+	f->formy += strdepth(prompt);
     }
 
     if (width > COLS || depth > LINES) {
@@ -455,11 +522,11 @@ MENU(void *chain, int width, int depth, char *title, char *prompt, int flags)
 	fancy = 1;
 	width += 2;	/* width and depth need to be wide enough for the */
 	depth += 2;	/* extra lines in the screen */
-	formx ++;	/* data entry origin needs to be tweaked for this */
-	formy ++;	/* as well. */
+	f->formx ++;	/* data entry origin needs to be tweaked for this */
+	f->formy ++;	/* as well. */
     }
     else fancy = 0;
-    
+
     /* the button bar will be the last line on the form.  If there are
      * no buttons, this will be gleefully ignored
      */
@@ -505,7 +572,7 @@ MENU(void *chain, int width, int depth, char *title, char *prompt, int flags)
 	    int spacing;
 	    int nrbuttons = (nritems - idx);
 
-	    firstbutton = idx;
+	    f->firstbutton = idx;
 
 	    if (nrbuttons == 0) {
 		if (nritems) free(items);
@@ -541,100 +608,249 @@ MENU(void *chain, int width, int depth, char *title, char *prompt, int flags)
 		items[idx] = walk;
 		setButtonDataArea(walk,
 			    bx + (spacing-strlen(walk->title)-1)/2,
-							     buttony-formy);
+							     buttony-f->formy);
 		bx += spacing;
 	    }
 	} /* populating items[] from the buttons */
     } /* if (chain != 0) ... buttonbar population */
 
-
-    /* crank open a window and away we go
+    /*
+     * set up the refresh control block (aka a simpler way of passing
+     * lots of arguments to a function).
+     *
+     * The simple way to do this is rewrite MENU as a C++ class and
+     * stuff all these variables into the MENU header.
      */
-    menu = newwin(depth, width, (LINES-depth)/2, (COLS-width)/2);
-    if (menu == (WINDOW*)0) {
-	/* can't create window.  Ooops */
-	if (nritems) free(items);
-	return MENU_ERROR;
+    f->rp.fancy       = fancy;
+    f->rp.wholescreen = wholescreen;
+    f->rp.depth       = depth;
+    f->rp.width       = width;
+    f->rp.title       = title;
+    f->rp.prompt      = prompt;
+    f->rp.promptwidth = promptwidth;
+    f->rp.buttons     = hasbuttons;
+    f->rp.items       = items;
+    f->rp.nritems     = nritems;
+    f->rp.flags       = flags;
+    return 0;
+} /* layoutForm */
+
+
+/*
+ * Forms pop up and go away all the time (help pages, error boxes, yes/no
+ * prompts), so rather than handing a window (and panel) back to curses
+ * when a form is closed, we keep the last WINPOOL of them around to use
+ * again for the next form of the same size.
+ */
+#define WINPOOL	8
+
+static struct {
+    WINDOW *win;
+#if HAVE_PANEL
+    PANEL *pan;			/* hidden until it's used again */
+#else
+    WINDOW *under;		/* backing store for push() */
+#endif
+    int depth, width;
+} winpool[WINPOOL];
+static int nrwinpool = 0;
+
+
+/*
+ * takeWindow() gets a window for a form, from the pool if there's one
+ * of the right size.
+ */
+static int
+takeWindow(Form *f, int depth, int width)
+{
+    int y = (LINES-depth)/2;
+    int x = (COLS-width)/2;
+    int ix;
+
+    for (ix = nrwinpool-1; ix >= 0; --ix)
+	if (winpool[ix].depth == depth && winpool[ix].width == width) {
+	    f->menu = winpool[ix].win;
+#if HAVE_PANEL
+	    f->pan = winpool[ix].pan;
+	    move_panel(f->pan, y, x);
+	    show_panel(f->pan);
+#else
+	    mvwin(f->menu, y, x);
+	    if ((f->under = winpool[ix].under) != 0)
+		mvwin(f->under, y, x);
+#endif
+	    --nrwinpool;
+	    for ( ; ix < nrwinpool; ix++)
+		winpool[ix] = winpool[ix+1];
+	    return 0;
+	}
+
+    if ((f->menu = newwin(depth, width, y, x)) == (WINDOW*)0)
+	return -1;
+#if HAVE_PANEL
+    if ((f->pan = new_panel(f->menu)) == (PANEL*)0) {
+	delwin(f->menu);
+	return -1;
     }
-    if ((display = newDisplay(menu, formx, formy)) == 0) {
-	/* can't create display object.  Drat */
-	delwin(menu);
-	if (nritems) free(items);
-	return MENU_ERROR;
+#else
+    /* if we can't get a backing window, push() will do without */
+    f->under = newwin(depth, width, y, x);
+#endif
+    return 0;
+} /* takeWindow */
+
+
+/*
+ * giveWindow() puts a form's window back into the pool, throwing away
+ * the oldest window in the pool if it's full.
+ */
+static void
+giveWindow(Form *f)
+{
+    int ix;
+
+    if (nrwinpool == WINPOOL) {
+#if HAVE_PANEL
+	del_panel(winpool[0].pan);
+#else
+	if (winpool[0].under)
+	    delwin(winpool[0].under);
+#endif
+	delwin(winpool[0].win);
+	--nrwinpool;
+	for (ix = 0; ix < nrwinpool; ix++)
+	    winpool[ix] = winpool[ix+1];
     }
 
 #if HAVE_PANEL
-    pan = new_panel(menu);
+    hide_panel(f->pan);
+    winpool[nrwinpool].pan = f->pan;
 #else
-    push(&menuInfo, &frame);
+    winpool[nrwinpool].under = f->under;
+#endif
+    winpool[nrwinpool].win = f->menu;
+    winpool[nrwinpool].depth = f->rp.depth;
+    winpool[nrwinpool].width = f->rp.width;
+    nrwinpool++;
+} /* giveWindow */
+
+
+/*
+ * openForm() cranks open a window for a laid-out form and draws it.
+ */
+static int
+openForm(Form *f)
+{
+    int depth = f->rp.depth;
+    int width = f->rp.width;
+
+    if (takeWindow(f, depth, width) != 0)
+	/* can't create window.  Ooops */
+	return MENU_ERROR;
+
+    f->display = &f->dpy;
+    f->dpy.window = f->menu;
+    f->dpy.x = f->formx;
+    f->dpy.y = f->formy;
+    f->dpy.form = f;
+    f->rp.menu = f->display;
+
+#if !HAVE_PANEL
+    push(&f->rp, &f->frame, f->under);
 #endif
 
 #if HAVE_KEYPAD
-    keypad(menu, TRUE);
+    keypad(f->menu, TRUE);
 #endif
     raw();
     nonl();
     noecho();
-    leaveok(menu, FALSE);
+    leaveok(f->menu, FALSE);
 
 #if VERMIN
-    mousemask(BUTTON1_PRESSED|BUTTON1_CLICKED|BUTTON1_DOUBLE_CLICKED, &mev);
+    mousemask(BUTTON1_PRESSED|BUTTON1_CLICKED|BUTTON1_DOUBLE_CLICKED, &f->mev);
 #endif
 
-    /*
-     * set up the refresh control block (aka a simpler way of passing
-     * lots of arguments to a function) and do the initial printing of
-     * the window.
-     *
-     * The simple way to do this is rewrite MENU as a C++ class and
-     * stuff all these variables into the MENU header.
-     */
-    menuInfo.menu        = display;
-    menuInfo.fancy       = fancy;
-    menuInfo.wholescreen = wholescreen;
-    menuInfo.depth       = depth;
-    menuInfo.width       = width;
-    menuInfo.title       = title;
-    menuInfo.prompt      = prompt;
-    menuInfo.promptwidth = promptwidth;
-    menuInfo.buttons     = hasbuttons;
-    menuInfo.items       = items;
-    menuInfo.nritems     = nritems;
-    menuInfo.flags       = flags;
-
-    refreshMenu(&menuInfo);
-
-    if (chain == 0) {
-	wrefresh(menu);
-	status = MENU_OK;
-	goto byebye_no_items;
-    }
-    tcflush(0, TCIFLUSH);	/* flush any typeahead on this menu */
+    refreshMenu(&f->rp);
+    f->isopen = 1;
+    return 0;
+} /* openForm */
 
-    /* |vvv| should all this be another function? |vvv| */
 
-    /* put the cursor on the first writable item */
-    for (idx = (flags&AT_BUTTON) ? firstbutton : 0; (idx < nritems) && !writable(items[idx]); idx++)
-	;
-	
-    if (idx >= nritems) {
-	/* nothing to write?  Bummer. */
-	wrefresh(menu);
-	status = MENU_OK;
-	goto byebye;
-    }
+/*
+ * closeForm() takes a form off the screen and throws away the window
+ * that openForm() built for it.
+ */
+static void
+closeForm(Form *f)
+{
+#if VERMIN
+    /* reset the mouse event mask back to what it was */
+    mousemask(f->mev, (mmask_t*)0);
+#endif
 
-    rc = eNOP;
-    while (1) {
-	int ix;
+#if !HAVE_PANEL
+    pop();
+#endif
+    giveWindow(f);
+#if HAVE_PANEL
+    update_panels();
+#endif
+    f->isopen = 0;
+} /* closeForm */
 
-	rc = editObj(items[idx], display, &mouse, rc);
 
+/*
+ * freeForm() throws away everything that layoutForm() and friends
+ * built for a form.
+ */
+static void
+freeForm(Form *f)
+{
+    if (f->rp.items)
+	free(f->rp.items);
+    if (f->shape)
+	free(f->shape);
+    if (f->timers)
+	free(f->timers);
+    _nd_freeHitGrid(f->hits);
+    f->rp.items = 0;
+    f->shape = 0;
+    f->timers = 0;
+    f->nrtimers = f->sztimers = 0;
+    f->hits = 0;
+} /* freeForm */
+
+
+/*
+ * formSettle() deals with the editCode that took us out of the current
+ * object (an editObj() return code):  it moves to the next object and
+ * starts editing it, or decides that the form is done.   It returns
+ * MENU_RUNNING if an object is waiting for keys, otherwise the status
+ * that MENU() returns.
+ */
+static int
+formSettle(Form *f, editCode rc)
+{
+    Obj **items = f->rp.items;	/* list of items in the chain */
+    int nritems = f->rp.nritems;/* number of items in the chain */
+    int idx = f->idx;
+    int incr;			/* direction to go to reach the next object
+				 * to edit
+				 */
+    int ix;
+#if VERMIN
+    int bymouse;		/* editing flag to tell editObj() that it */
+				/* needs to deal with a mouse event before */
+				/* it does anything else */
+#endif
+
+    do {
 	incr = 0;
 
 	switch (rc) {
-	case eEXITFORM:	status = MENU_OK;
-			goto byebye;
+	case eNOP:					break;
+	case eEXITFORM:	return MENU_OK;
 
 	case eERROR:	incr=1;				break;
 	case eCANCEL:	/* usually after a callback failed */break;
@@ -646,14 +862,10 @@ MENU(void *chain, int width, int depth, char *title, char *prompt, int flags)
 			 * special handling for OK or CANCEL
 			 * buttons
 			 */
-			if (isCANCELbutton(items[idx])) {
-			    status = MENU_CANCEL;
-			    goto byebye;
-			}
-			else if (isOKbutton(items[idx])) {
-			    status = MENU_OK;
-			    goto byebye;
-			}
+			if (isCANCELbutton(items[idx]))
+			    return MENU_CANCEL;
+			else if (isOKbutton(items[idx]))
+			    return MENU_OK;
 			else
 			    incr=1;
 			break;
@@ -669,22 +881,20 @@ MENU(void *chain, int width, int depth, char *title, char *prompt, int flags)
 			 * coordinates so they are relative to this
 			 * window
 			 */
-			getmouse(&mouse);
-			mouse.x -= formx + (COLS-width)/2;
-			mouse.y -= formy + (LINES-depth)/2;
+			getmouse(&f->mouse);
+			f->mouse.x -= f->formx + (COLS-f->rp.width)/2;
+			f->mouse.y -= f->formy + (LINES-f->rp.depth)/2;
 
 			/* then look to see if the mouse was anywhere within
 			 * a data entry field
 			 */
-			for (bymouse=ix=0; ix<nritems; ix++)
-			    if (ix != idx && _nd_inside(items[ix], &mouse)) {
-				idx = ix;
-				bymouse = 1;
-				break;
-			    }
+			ix = _nd_hitTest(&f->hits, items, nritems, idx,
+							    &f->mouse);
+			if ((bymouse = (ix >= 0)))
+			    idx = ix;
 			/* or if the mouse was inside the current field */
 			if (!bymouse)
-			    bymouse = _nd_inside(items[idx], &mouse);
+			    bymouse = _nd_inside(items[idx], &f->mouse);
 
 			if (!bymouse)
 			    rc = eNOP;
@@ -696,13 +906,12 @@ MENU(void *chain, int width, int depth, char *title, char *prompt, int flags)
 			/* fall through into eREFRESH */
 
 		/* user pressed ^R */
-	case eREFRESH:	wclear(menu);
-			refreshMenu(&menuInfo);
-			continue;
+	case eREFRESH:	wclear(f->menu);
+			refreshMenu(&f->rp);
+			break;
 
 		/* user pressed ESCAPE */
-	case eESCAPE:	status = MENU_ESCAPE;
-			goto byebye;
+	case eESCAPE:	return MENU_ESCAPE;
 	}
 
 	/* after processing the return from editObj, we'll update anything
@@ -712,7 +921,7 @@ MENU(void *chain, int width, int depth, char *title, char *prompt, int flags)
 	 */
 	for (ix=0; ix<nritems; ix++)
 	    if (touched(items[ix])) {
-		drawObj(items[ix], display);
+		drawObj(items[ix], f->display);
 		untouchObj(items[ix]);
 	    }
 
@@ -729,14 +938,13 @@ MENU(void *chain, int width, int depth, char *title, char *prompt, int flags)
 		if (ix < 0)
 		    ix = nritems-1;
 		else if (ix >= nritems) {
-		    if ((rc == eTAB) || hasOKbutton || hasCANCELbutton)
+		    if ((rc == eTAB) || f->hasOKbutton || f->hasCANCELbutton)
 			ix = 0;
 		    else {
 			/* if there are no OK or Cancel buttons, we return
 			 * as soon as we reach the end of the form.
 			 */
-			status = MENU_OK;
-			goto byebye;
+			return MENU_OK;
 		    }
 		}
 		/* when we find a writable item or wrap around to the start,
@@ -748,31 +956,679 @@ MENU(void *chain, int width, int depth, char *title, char *prompt, int flags)
 	    if (!writable(items[ix])) {
 		/* If we didn't find anything writable, we are done!
 		 */
-		status = MENU_OK;
-		goto byebye;
+		return MENU_OK;
 	    }
 	    idx = ix;
 	}
+	f->idx = idx;
+
+	rc = _nd_startObj(items[idx], f->display, &f->mouse, rc);
+
+	/* an edit function that returned eNOP is simply started again;
+	 * only an object with a key function waits for keys
+	 */
+    } while (rc != eNOP || !_nd_keyedObj(items[idx]));
+
+    return MENU_RUNNING;
+} /* formSettle */
+
+
+/*
+ * formStart() puts the cursor on the first writable item on the form
+ * and starts editing it.
+ */
+static int
+formStart(Form *f)
+{
+    Obj **items = f->rp.items;
+    int nritems = f->rp.nritems;
+    int idx;
+    editCode rc;
+
+    if (items == 0) {
+	wrefresh(f->menu);
+	return MENU_OK;
     }
-byebye:
-    free(items);
-byebye_no_items:
+    tcflush(0, TCIFLUSH);	/* flush any typeahead on this menu */
 
-#if VERMIN
-    /* reset the mouse event mask back to what it was */
-    mousemask(mev, (mmask_t*)0);
-#endif
+    /* put the cursor on the first writable item */
+    for (idx = (f->rp.flags&AT_BUTTON) ? f->firstbutton : 0; (idx < nritems) && !writable(items[idx]); idx++)
+	;
 
-#if HAVE_PANEL
-    del_panel(pan);
-#else
-    pop();
-#endif
-    delwin(menu);
-    deleteDisplay(display);
-#if HAVE_PANEL
-    update_panels();
-#endif
+    if (idx >= nritems) {
+	/* nothing to write?  Bummer. */
+	wrefresh(f->menu);
+	return MENU_OK;
+    }
+
+    f->idx = idx;
+    rc = _nd_startObj(items[idx], f->display, &f->mouse, eNOP);
+    if (rc != eNOP || !_nd_keyedObj(items[idx]))
+	return formSettle(f, rc);
+    return MENU_RUNNING;
+} /* formStart */
+
+
+/*
+ * formKey() passes one keystroke to the object being edited
+ */
+static int
+formKey(Form *f, int c)
+{
+    editCode rc;
+
+    if ((rc = _nd_keyObj(f->rp.items[f->idx], f->display, c)) != eNOP)
+	return formSettle(f, rc);
+    return MENU_RUNNING;
+} /* formKey */
+
+
+/*
+ * formRun() puts a laid-out form on the screen, waits for the user to
+ * finish with it, and takes it down again.
+ */
+static int
+formRun(Form *f)
+{
+    if (openForm(f) != 0)
+	return MENU_ERROR;
+
+    f->status = formStart(f);
+    while (f->status == MENU_RUNNING)
+	f->status = formKey(f, ndgetch(f->display));
+
+    closeForm(f);
+    return f->status;
+} /* formRun */
+
+
+/*
+ * snapshot() remembers what the objects on a compiled form look like
+ */
+static int
+snapshot(Form *f)
+{
+    int ix;
+
+    if (f->shape)
+	free(f->shape);
+    f->shape = 0;
+
+    if (f->rp.nritems == 0)
+	return 0;
+    if ((f->shape = malloc(f->rp.nritems * sizeof f->shape[0])) == 0)
+	return -1;
+
+    for (ix = 0; ix < f->rp.nritems; ix++) {
+	f->shape[ix].title = f->rp.items[ix]->title;
+	f->shape[ix].x = f->rp.items[ix]->x;
+	f->shape[ix].y = f->rp.items[ix]->y;
+	f->shape[ix].width = f->rp.items[ix]->width;
+	f->shape[ix].depth = f->rp.items[ix]->depth;
+    }
+    return 0;
+} /* snapshot */
+
+
+/*
+ * stale() tells us if a compiled form needs to be laid out again, because
+ * the screen changed size, objects were added to or removed from the
+ * chain, or some of the objects have changed shape.
+ */
+static int
+stale(Form *f)
+{
+    Obj *cur = OBJ(f->chain);
+    int ix;
+
+    if (f->cols != COLS || f->lines != LINES)
+	return 1;
+    if (f->rp.nritems == 0)
+	return 0;
+
+    for (ix = 0; ix < f->rp.nritems; ix++, cur = cur->next) {
+	if (cur != f->rp.items[ix])
+	    return 1;
+	if (cur->title != f->shape[ix].title
+		|| cur->x != f->shape[ix].x || cur->y != f->shape[ix].y
+		|| cur->width != f->shape[ix].width
+		|| cur->depth != f->shape[ix].depth)
+	    return 1;
+    }
+    return cur != OBJ(f->chain);
+} /* stale */
+
+
+/*
+ * relayout() lays out a compiled form again
+ */
+static int
+relayout(Form *f)
+{
+    if (f->rp.items)
+	free(f->rp.items);
+    f->rp.items = 0;
+    f->rp.nritems = 0;
+    _nd_freeHitGrid(f->hits);
+    f->hits = 0;
+
+    if (layoutForm(f, f->chain, f->askwidth, f->askdepth,
+			    f->rp.title, f->rp.prompt, f->rp.flags) != 0)
+	return -1;
+    return snapshot(f);
+} /* relayout */
+
+
+/*
+ * MENU() builds up a form, then spits it out on the screen and
+ * lets the user type into it.
+ * If the display has a mouse (cf the ncurses mouse device support)
+ * the user can use the mouse to navigate between fields on the form.
+ *
+ * Before calling menu for the first time, curses MUST be active and properly
+ * configured (you don't need to set raw mode, but you do need to set mouse
+ * event masks and color pairs.)
+ *
+ * MENU expects
+ *	chain	-- an object chain, built by ObjChain or friends
+ *	width	-- the expected width of the form (-1 for autosizing)
+ *	depth	-- the expected depth of the form (-1 for autosizing)
+ *	title	-- the titlebar at the top of the form.
+ *	prompt	-- informative text that is placed at the top of the
+ *		   form.
+ *	flags	-- special display options (fancy windows, align prompt
+ *		   text left or right, [more to follow, I'm sure])
+ *
+ * MENU returns
+ *	0 if the user accepted the input on the form
+ *	1 if the user cancelled out of the form (via a cancel button)
+ *	2 if the user pressed ESCAPE to flee the form
+ *     -1 if something horrible happened when setting up the form.
+ *
+ * MENU() is newForm() and formStep() without the step; it sits in
+ * ndgetch() until the form is done.
+ */
+int
+MENU(void *chain, int width, int depth, char *title, char *prompt, int flags)
+{
+    Form form;			/* the form we're displaying */
+    int status;			/* return status from input loop */
+
+    memset(&form, 0, sizeof form);
+
+    if (layoutForm(&form, chain, width, depth, title, prompt, flags) != 0)
+	return -1;
+
+    status = formRun(&form);
+    freeForm(&form);
 
     return status;	/* default; assume everything is HUNKY-DORY */
 } /* MENU */
+
+
+/*
+ * compileForm() lays out a form without putting it on the screen, so
+ * that runForm() can show it over and over without sorting the chain,
+ * measuring the objects, and placing the buttons every time.  The title
+ * and prompt are used in place, so they need to stay around for as long
+ * as the compiled form does.  It returns 0 (with errno set) if the form
+ * can't be laid out.
+ */
+void *
+compileForm(void *chain, int width, int depth, char *title, char *prompt,
+							int flags)
+{
+    Form *f;
+
+    if ((f = calloc(1, sizeof *f)) == 0)
+	return 0;
+
+    if (layoutForm(f, chain, width, depth, title, prompt, flags) != 0
+						    || snapshot(f) != 0) {
+	freeForm(f);
+	free(f);
+	return 0;
+    }
+    return f;
+} /* compileForm */
+
+
+/*
+ * runForm() does a MENU() on a compiled form.  If the chain has been
+ * changed, or any of the objects have been moved, resized, or retitled
+ * since the form was laid out, it's laid out again first.
+ */
+int
+runForm(void *o)
+{
+    Form *f = (Form*)o;
+
+    if (f == 0) {
+	errno = EINVAL;
+	return MENU_ERROR;
+    }
+    if (f->isopen) {
+	errno = EBUSY;
+	return MENU_ERROR;
+    }
+    if (stale(f) && relayout(f) != 0)
+	return MENU_ERROR;
+
+    return formRun(f);
+} /* runForm */
+
+
+/*
+ * newForm() puts a form up on the screen and starts editing it, but
+ * doesn't wait for any input;  that's left for formStep(), so that an
+ * application can poll formFd() along with whatever else it's waiting
+ * for.  It returns 0 (with errno set) if it can't build the form.
+ *
+ * Objects that can't be edited a keystroke at a time (widgets that
+ * were registered with nd_register_object()) will still block until the
+ * user is done with them.
+ */
+void *
+newForm(void *chain, int width, int depth, char *title, char *prompt,
+							int flags)
+{
+    Form *f = _nd_newForm(chain, width, depth, title, prompt, flags);
+
+    if (f)
+	f->status = formStart(f);
+    return f;
+} /* newForm */
+
+
+/*
+ * formFd() returns the file descriptor that keyboard input for a form
+ * comes in on.
+ */
+int
+formFd(void *f)
+{
+    if (f == 0) {
+	errno = EINVAL;
+	return -1;
+    }
+    return fileno(stdin);
+} /* formFd */
+
+
+/*
+ * formStep() handles all the input that's waiting for a form (and runs
+ * any form timers that are due), and returns
+ * MENU_RUNNING if the form wants more, otherwise the status that MENU()
+ * would have returned.
+ */
+int
+formStep(void *o)
+{
+    Form *f = (Form*)o;
+    int c;
+
+    if (f == 0) {
+	errno = EINVAL;
+	return MENU_ERROR;
+    }
+
+    while (f->status == MENU_RUNNING) {
+	f->stepping = 1;
+	c = ndgetch(f->display);
+	f->stepping = 0;
+
+	if (c == ERR)
+	    break;
+	f->status = formKey(f, c);
+    }
+    return f->status;
+} /* formStep */
+
+
+/*
+ * deleteForm() takes down a form built by newForm(), whether or not
+ * the user is done with it.
+ */
+void
+deleteForm(void *o)
+{
+    Form *f = (Form*)o;
+
+    /* if an object is still being edited, tell it that the input has
+     * dried up so it can clean up after itself.
+     */
+    if (f && f->status == MENU_RUNNING)
+	_nd_keyObj(f->rp.items[f->idx], f->display, EOF);
+    _nd_deleteForm(f);
+} /* deleteForm */
+
+
+/*
+ * _nd_newForm() lays out an object chain and puts it up on the screen,
+ * but doesn't wait for anything; the form stays up until _nd_deleteForm()
+ * takes it down.  It returns 0 (with errno set) if it can't build the form.
+ */
+void *
+_nd_newForm(void *chain, int width, int depth, char *title, char *prompt,
+							int flags)
+{
+    Form *f;
+
+    if ((f = calloc(1, sizeof *f)) == 0)
+	return 0;
+
+    if (layoutForm(f, chain, width, depth, title, prompt, flags) != 0) {
+	free(f);
+	return 0;
+    }
+    if (openForm(f) != 0) {
+	freeForm(f);
+	free(f);
+	return 0;
+    }
+    return f;
+} /* _nd_newForm */
+
+
+/*
+ * _nd_formDisplay() returns the Display that a form's objects are drawn on
+ */
+void *
+_nd_formDisplay(void *f)
+{
+    return f ? ((Form*)f)->display : 0;
+} /* _nd_formDisplay */
+
+
+/*
+ * _nd_setFormPrompt() replaces the prompt on an open form and redraws it.
+ * The new prompt is expected to fit into the space the old one was laid
+ * out in.
+ */
+void
+_nd_setFormPrompt(void *o, char *prompt)
+{
+    Form *f = (Form*)o;
+
+    if (f == 0)
+	return;
+
+    f->rp.prompt = prompt;
+    f->rp.promptwidth = strwidth(prompt);
+    refreshMenu(&f->rp);
+} /* _nd_setFormPrompt */
+
+
+/*
+ * _nd_deleteForm() takes down a form built by _nd_newForm()
+ */
+void
+_nd_deleteForm(void *f)
+{
+    if (f) {
+	if (((Form*)f)->isopen)
+	    closeForm((Form*)f);
+	freeForm((Form*)f);
+	free(f);
+    }
+} /* _nd_deleteForm */
+
+
+/*
+ * schedule() works out when a timer should fire next.  Periodic timers
+ * are lined up on a multiple of their interval, so that any number of
+ * timers with the same period come due at the same moment and share
+ * a single screen update.
+ */
+static void
+schedule(formTimer *t, struct timeval *now)
+{
+    long ms = t->interval;
+
+    if (t->periodic)
+	ms -= ((now->tv_sec % t->interval) * 1000
+			    + now->tv_usec / 1000) % t->interval;
+
+    t->due.tv_sec = now->tv_sec + ms / 1000;
+    t->due.tv_usec = (now->tv_usec / 1000 + ms % 1000) * 1000;
+    if (t->due.tv_usec >= 1000000) {
+	t->due.tv_sec++;
+	t->due.tv_usec -= 1000000;
+    }
+} /* schedule */
+
+
+/*
+ * msecsleft() tells how many msec are left before a timer fires
+ */
+static long
+msecsleft(formTimer *t, struct timeval *now)
+{
+    return (t->due.tv_sec - now->tv_sec) * 1000
+	 + (t->due.tv_usec - now->tv_usec) / 1000;
+} /* msecsleft */
+
+
+/*
+ * addTimer() attaches a timer or idle callback to a form
+ */
+static int
+addTimer(Form *f, long msec, int periodic, int idle,
+				int (*fn)(void*,void*), void *arg)
+{
+    formTimer *t;
+    struct timeval now;
+
+    if (f == 0 || fn == 0 || (!idle && msec < 1)) {
+	errno = EINVAL;
+	return -1;
+    }
+    if (f->nrtimers >= f->sztimers) {
+	int sz = f->sztimers ? f->sztimers * 2 : 4;
+
+	t = realloc(f->timers, sz * sizeof f->timers[0]);
+	if (t == 0)
+	    return -1;
+	f->timers = t;
+	f->sztimers = sz;
+    }
+
+    t = &f->timers[f->nrtimers++];
+    t->id = ++timerid;
+    t->idle = idle;
+    t->periodic = periodic;
+    t->interval = msec;
+    t->fn = fn;
+    t->arg = arg;
+    if (!idle) {
+	gettimeofday(&now, 0);
+	schedule(t, &now);
+    }
+    return t->id;
+} /* addTimer */
+
+
+/*
+ * addFormTimer() sets up a callback that is run msec milliseconds from
+ * now or, if periodic is set, every msec milliseconds.  Periodic timers
+ * are lined up on multiples of msec (so the ones with the same interval
+ * fire together), which means the first run can come any time within
+ * the next msec milliseconds.
+ * The callback is called as fn(form, arg), and can cancel the timer by
+ * returning nonzero.  Objects that the callback changes should be
+ * touchObj()ed;  after the timers that are due have been run, the
+ * touched objects are redrawn and the screen is updated once.
+ *
+ * Timers only run while the form is waiting for input, either in MENU(),
+ * formStep(), or an object that's being edited on the form.
+ *
+ * addFormTimer() returns a handle for removeFormTimer(), or -1 (with
+ * errno set) if the timer could not be set up.
+ */
+int
+addFormTimer(void *f, int msec, int periodic, int (*fn)(void*,void*),
+								void *arg)
+{
+    return addTimer((Form*)f, msec, periodic, 0, fn, arg);
+} /* addFormTimer */
+
+
+/*
+ * addFormIdle() sets up a callback that's run every time the form is
+ * about to wait for input.  Like a timer, it can remove itself by
+ * returning nonzero.
+ */
+int
+addFormIdle(void *f, int (*fn)(void*,void*), void *arg)
+{
+    return addTimer((Form*)f, 0, 1, 1, fn, arg);
+} /* addFormIdle */
+
+
+/*
+ * removeFormTimer() cancels a timer or idle callback
+ */
+int
+removeFormTimer(void *o, int id)
+{
+    Form *f = (Form*)o;
+    int ix;
+
+    if (f)
+	for (ix = 0; ix < f->nrtimers; ix++)
+	    if (f->timers[ix].id == id && f->timers[ix].fn) {
+		f->timers[ix].fn = 0;
+		return 0;
+	    }
+    errno = EINVAL;
+    return -1;
+} /* removeFormTimer */
+
+
+/*
+ * _nd_formTimer() tells whether a timer handle is still live on a form.
+ * Objects that run themselves from a form timer use it to see if they
+ * need to set the timer up again:  the form they remember may have been
+ * thrown away and another one built in the same place.
+ */
+int
+_nd_formTimer(void *o, int id)
+{
+    Form *f = (Form*)o;
+    int ix;
+
+    if (f && id > 0)
+	for (ix = 0; ix < f->nrtimers; ix++)
+	    if (f->timers[ix].id == id && f->timers[ix].fn)
+		return 1;
+    return 0;
+} /* _nd_formTimer */
+
+
+/*
+ * formTimeout() returns how many msec an application that is stepping
+ * a form can wait for input before it needs to call formStep() to run
+ * the next timer, or -1 if there aren't any timers.
+ */
+int
+formTimeout(void *o)
+{
+    Form *f = (Form*)o;
+    struct timeval now;
+    long left, wait = -1;
+    int ix;
+
+    if (f == 0) {
+	errno = EINVAL;
+	return -1;
+    }
+
+    gettimeofday(&now, 0);
+    for (ix = 0; ix < f->nrtimers; ix++)
+	if (f->timers[ix].fn && !f->timers[ix].idle) {
+	    left = msecsleft(&f->timers[ix], &now);
+	    if (left < 0)
+		left = 0;
+	    if (wait < 0 || left < wait)
+		wait = left;
+	}
+    return wait;
+} /* formTimeout */
+
+
+/*
+ * _nd_formTick() runs the idle callbacks and any timers that are due,
+ * redraws the objects that they touched, and returns the number of msec
+ * that ndgetch() can wait for input before it has to call us again
+ * (-1 to wait forever, 0 not to wait at all if formStep() is polling.)
+ *
+ * The redrawn objects aren't sent to the screen here;  the wgetch()
+ * that ndgetch() is about to do takes care of that, so however many
+ * timers fire the screen is only updated once.
+ */
+int
+_nd_formTick(void *o)
+{
+    Form *f = (Form*)o;
+    struct timeval now, due;
+    formTimer *t;
+    int ix, fired = 0;
+    int x, y;
+
+    if (f->ticking)
+	return f->stepping ? 0 : -1;
+    f->ticking = 1;
+
+    gettimeofday(&now, 0);
+    /* the callbacks may add timers, so f->timers can move around under
+     * us.  Don't hang on to a pointer to one across a callback.
+     */
+    for (ix = 0; ix < f->nrtimers; ix++) {
+	t = &f->timers[ix];
+	if (t->fn == 0 || (!t->idle && msecsleft(t, &now) > TIMER_SLOP))
+	    continue;
+
+	fired++;
+	if ((*t->fn)(f, t->arg) != 0)
+	    f->timers[ix].fn = 0;
+	else if (!f->timers[ix].periodic)
+	    f->timers[ix].fn = 0;
+	else if (!f->timers[ix].idle) {
+	    /* a timer that was run a little early is rescheduled from
+	     * when it was due, not from now, or it would just come
+	     * due again on the next tick.
+	     */
+	    t = &f->timers[ix];
+	    if (t->due.tv_sec > now.tv_sec || (t->due.tv_sec == now.tv_sec
+					&& t->due.tv_usec > now.tv_usec))
+		due = t->due;
+	    else
+		due = now;
+	    schedule(t, &due);
+	}
+    }
+
+    /* throw away the timers that are done */
+    for (ix = y = 0; ix < f->nrtimers; ix++)
+	if (f->timers[ix].fn)
+	    f->timers[y++] = f->timers[ix];
+    f->nrtimers = y;
+
+    if (fired) {
+	getyx(f->menu, y, x);
+	for (ix = 0; ix < f->rp.nritems; ix++)
+	    if (touched(f->rp.items[ix])) {
+		drawObj(f->rp.items[ix], f->display);
+		untouchObj(f->rp.items[ix]);
+	    }
+	wmove(f->menu, y, x);
+    }
+
+    f->ticking = 0;
+
+    if (f->stepping)
+	return 0;
+    if ((ix = formTimeout(f)) == 0)
+	ix = 1;
+    return ix;
+} /* _nd_formTick */
@@ -83,48 +83,6 @@ objTitle(void *obj)
 } /* objTitle */
 
 
-/*
- * newTextData() is an unpublished procedure that
- * builds the lines[] list for a Text object (used by newText() and
- * setObjData())
- */
-int
-newTextData(Obj *o)
-{
-    int nrlines = 0;
-    int i;
-    char *p;
-    int width = 0;
-
-    for (p=(char*)(o->content); *p; ++p)
-	if (*p == '\n')
-	    nrlines++;
-    if (p > (char*)(o->content) && p[-1] != '\n')
-	nrlines++;
-    if ((o->item.text.lines = malloc(nrlines * sizeof(char*))) == 0)
-	return -1;
-    o->item.text.nrlines = nrlines;
-    o->item.text.width = 0;
-    for (p=(char*)(o->content), i=0; i<nrlines; i++) {
-	o->item.text.lines[i] = p;
-	if ((p = strchr(p, '\n')) == (char*)0) {
-	    if ((width = strlen(o->item.text.lines[i])) > o->item.text.width)
-		o->item.text.width = width;
-	    break;
-	}
-	else {
-	    if ((width = (p - o->item.text.lines[i])) > o->item.text.width)
-		o->item.text.width = width;
-	    ++p;
-	}
-    }
-
-    if (i < nrlines)
-	o->item.text.nrlines = i;
-    return nrlines;
-} /* newTextData */
-
-
 #if DYNAMIC_BINDING
 /*
  * nd_bindToType() binds something to an object's
@@ -164,6 +122,9 @@ nd_bindToList(void *obj, va_list *ptr)
 	OBJ(obj)->item.list.nritems  = va_arg(*ret, int);
 	OBJ(obj)->item.list.topy     = 0;
 	OBJ(obj)->item.list.cury     = 0;
+	_nd_listSelInit(OBJ(obj));
+	_nd_listKeysFree(OBJ(obj));
+	_nd_listFilterFree(OBJ(obj));
     }
     return ret;
 } /* nd_bindToList */
@@ -178,9 +139,7 @@ nd_bindToText(void *obj, va_list *ptr)
     va_list *ret = nd_bindToType(obj,ptr);
 
     if ( ret ) {
-	if (OBJ(obj)->item.text.lines)
-	    free(OBJ(obj)->item.text.lines);
-	newTextData(obj);
+	_nd_textIndex(OBJ(obj), -1);
 	OBJ(obj)->item.text.topy   = 0;
 	OBJ(obj)->item.text.off_x  = 0;
     }
@@ -218,11 +177,12 @@ setObjData(void *obj,...)
 		OBJ(obj)->item.list.nritems  = va_arg(ptr, int);
 		OBJ(obj)->item.list.topy     = 0;
 		OBJ(obj)->item.list.cury     = 0;
+		_nd_listSelInit(OBJ(obj));
+		_nd_listKeysFree(OBJ(obj));
+		_nd_listFilterFree(OBJ(obj));
 		break;
     case O_TEXT:
-		if (OBJ(obj)->item.text.lines)
-		    free(OBJ(obj)->item.text.lines);
-		newTextData(obj);
+		_nd_textIndex(OBJ(obj), -1);
 		OBJ(obj)->item.text.topy   = 0;
 		OBJ(obj)->item.text.off_x  = 0;
 		break;
@@ -254,8 +214,13 @@ objHelp(void *o)
 {
     Obj *obj = OBJ(o);
 
-    if (objType(o)==O_LIST && obj->item.list.items && obj->item.list.items[obj->item.list.cury].help)
-	return obj->item.list.items[obj->item.list.cury].help;
+    if (objType(o)==O_LIST && obj->item.list.items
+			   && obj->item.list.cury < LIST_ROWS(obj)) {
+	ListItem *it = &obj->item.list.items[LIST_ITEM(obj,obj->item.list.cury)];
+
+	if (it->help)
+	    return it->help;
+    }
     return obj ? obj->help : 0;
 } /* objHelp */
 
@@ -282,6 +247,14 @@ isCANCELbutton(void *obj)
 } /* isCANCELbutton */
 
 
+/*
+ * _nd_geometry is bumped whenever an object is moved after it's been
+ * created, so that anything that has cached object positions (the
+ * MENU() hit grid) knows to throw them away.
+ */
+int _nd_geometry = 0;
+
+
 /*
  * setButtonDataArea() sets the data area for a button
  */
@@ -294,6 +267,7 @@ setButtonDataArea(void *obj, int x, int y)
     }
     OBJ(obj)->dtx = OBJ(obj)->selx = x;
     OBJ(obj)->dty = OBJ(obj)->sely = y;
+    _nd_geometry++;
     return 0;
 } /* setButtonDataArea */
 
@@ -304,7 +278,8 @@ setButtonDataArea(void *obj, int x, int y)
 int
 currentSelection(void *obj)
 {
-    if (obj && objType(obj) == O_LIST) return OBJ(obj)->item.list.cury;
+    if (obj && objType(obj) == O_LIST)
+	return LIST_ITEM(obj, OBJ(obj)->item.list.cury);
     errno = EINVAL;
     return -1;
 } /* currentSelection */
@@ -458,6 +433,25 @@ setListCursor(Obj *obj, int cursor)
 	errno = EOVERFLOW;
 	return -1;
     }
+    if (obj->item.list.view) {
+	/* the cursor is an item, so find the row it's showing on;
+	 * the view is in item order, so we can binary search it.
+	 */
+	int lo = 0, hi = obj->item.list.nrview, mid;
+
+	while (lo < hi) {
+	    mid = (lo + hi) / 2;
+	    if (obj->item.list.view[mid] < cursor)
+		lo = mid+1;
+	    else
+		hi = mid;
+	}
+	if (lo >= obj->item.list.nrview || obj->item.list.view[lo] != cursor) {
+	    errno = ENOENT;
+	    return -1;
+	}
+	cursor = lo;
+    }
     obj->item.list.cury = cursor;
     if (cursor < obj->item.list.topy)
 	obj->item.list.topy = cursor;
@@ -522,7 +516,7 @@ getStringCursor(Obj *o)
 int
 getListCursor(Obj *o)
 {
-    return o->item.list.cury;
+    return LIST_ITEM(o, o->item.list.cury);
 } /* getListCursor */
 
 
@@ -579,10 +573,37 @@ currentHtmlTag(void *o)
  * We define the structure here for object-oriented Purity Of Essence,
  * and also because it's likely to change drastically and we don't want
  * users assuming any format
+ *
+ * Strings added to a LIA are copied into an arena of chunks that's
+ * thrown away all at once by deleteLIA().  Deleting items doesn't give
+ * back their strings right away;  we keep a running count of how much
+ * of the arena is still live, and when more than half of it is dead
+ * the surviving strings are copied into a fresh arena and the old one
+ * is freed.  The ListItem array grows by doubling.
  */
+#define LIACHUNK	4096		/* smallest arena chunk */
+#define LIAMAXCHUNK	(1024*1024)	/* largest arena chunk (unless a
+					 * string needs more) */
+#define LIACOMPACT	(16*LIACHUNK)	/* don't bother compacting arenas
+					 * smaller than this */
+
+struct _LIAchunk {
+    struct _LIAchunk *next;	/* the previous chunk in the arena */
+    int size;			/* how big text[] is */
+    int used;			/* how much of it is used */
+    char text[1];
+} ;
+
 struct _LIA {
     ListItem *list;		/* the ListItem array */
     int count;			/* how many items live in the array */
+    int alloc;			/* how many items the array has room for */
+    struct _LIAchunk *arena;	/* where strings we copy live */
+    long used;			/* bytes handed out from the arena */
+    long live;			/* bytes of those that haven't been
+				 * deleted (an underestimate if we've
+				 * deleted any of the caller's strings)
+				 */
     int changed : 1;		/* has the array been changed?  If it
 				 * hasn't, we're pointing at the array
 				 * that was passed in to us, otherwise
@@ -601,7 +622,10 @@ newLIA(ListItem *list, int size)
 
     if ((tmp = malloc(sizeof *tmp)) != 0) {
 	tmp->count = size;
+	tmp->alloc = size;
 	tmp->list = list;
+	tmp->arena = 0;
+	tmp->used = tmp->live = 0;
 	tmp->changed = 0;
     }
     return tmp;
@@ -615,18 +639,14 @@ void
 deleteLIA(LIA o)
 {
     struct _LIA *obj = (struct _LIA*)o;
-    int i;
+    struct _LIAchunk *c;
 
     if (o != 0) {
-	if (obj->list && obj->changed) {
-	    for (i=0; i<obj->count; i++) {
-		if (obj->list[i].id)
-		    free(obj->list[i].id);
-		free(obj->list[i].item);
-		if (obj->list[i].help)
-		    free(obj->list[i].help);
-	    }
+	if (obj->list && obj->changed)
 	    free(obj->list);
+	while ((c = obj->arena) != 0) {
+	    obj->arena = c->next;
+	    free(c);
 	}
 	free(obj);
     }
@@ -634,79 +654,298 @@ deleteLIA(LIA o)
 
 
 /*
- * LIAallocate() allocates a writable ListItem array for a LIA
+ * LIAstrdup() copies a string into the arena
  */
-void
-LIAallocate(struct _LIA* obj)
+static char *
+LIAstrdup(struct _LIA *obj, char *s)
 {
-    int i;
+    struct _LIAchunk *c = obj->arena;
+    int len, size;
+    char *ret;
+
+    if (s == 0)
+	return 0;
+
+    len = strlen(s) + 1;
+
+    if (c == 0 || c->size - c->used < len) {
+	size = c ? 2 * c->size : LIACHUNK;
+	if (size > LIAMAXCHUNK)
+	    size = LIAMAXCHUNK;
+	if (size < len)
+	    size = len;
+
+	if ((c = malloc(sizeof *c + size)) == 0)
+	    return 0;
+	c->size = size;
+	c->used = 0;
+	c->next = obj->arena;
+	obj->arena = c;
+    }
+    ret = c->text + c->used;
+    memcpy(ret, s, len);
+    c->used += len;
+    obj->used += len;
+    obj->live += len;
+    return ret;
+} /* LIAstrdup */
+
+
+/*
+ * LIAchunkcmp() sorts arena chunks by address, for LIAcompact()
+ */
+static int
+LIAchunkcmp(const void *a, const void *b)
+{
+    struct _LIAchunk *ca = *(struct _LIAchunk**)a;
+    struct _LIAchunk *cb = *(struct _LIAchunk**)b;
+
+    return (ca < cb) ? -1 : (ca > cb);
+} /* LIAchunkcmp */
+
+
+/*
+ * LIAinarena() returns the length (with the trailing null) of a string
+ * if it lives in one of the (sorted) arena chunks, 0 if it doesn't
+ */
+static int
+LIAinarena(struct _LIAchunk **chunks, int nrchunks, char *s)
+{
+    int lo = 0, hi = nrchunks-1, mid;
+
+    if (s == 0)
+	return 0;
+
+    while (lo <= hi) {
+	mid = (lo + hi) / 2;
+	if (s < chunks[mid]->text)
+	    hi = mid-1;
+	else if (s >= chunks[mid]->text + chunks[mid]->used)
+	    lo = mid+1;
+	else
+	    return strlen(s) + 1;
+    }
+    return 0;
+} /* LIAinarena */
+
+
+/*
+ * LIAcompact() copies the strings that are still in use into a new
+ * arena and throws the old one away.  If we can't get the memory
+ * we just leave the old arena alone.
+ */
+static void
+LIAcompact(struct _LIA *obj)
+{
+    struct _LIAchunk *c, *new, **chunks;
+    char **fields[3];
+    int nrchunks, i, f, len;
+    long live = 0;
+    char *p;
+
+    for (nrchunks = 0, c = obj->arena; c; c = c->next)
+	nrchunks++;
+
+    if ((chunks = malloc(nrchunks * sizeof chunks[0])) == 0)
+	return;
+    for (i = 0, c = obj->arena; c; c = c->next)
+	chunks[i++] = c;
+    qsort(chunks, nrchunks, sizeof chunks[0], LIAchunkcmp);
+
+    /* find out exactly how much of the arena is live (any strings
+     * that aren't in the arena belong to the caller)
+     */
+    for (i = 0; i < obj->count; i++) {
+	live += LIAinarena(chunks, nrchunks, obj->list[i].item);
+	live += LIAinarena(chunks, nrchunks, obj->list[i].id);
+	live += LIAinarena(chunks, nrchunks, obj->list[i].help);
+    }
+
+    if (live == 0)
+	new = 0;
+    else if ((new = malloc(sizeof *new + live)) == 0) {
+	free(chunks);
+	obj->live = obj->used;	/* don't try again until more is dead */
+	return;
+    }
+    else {
+	new->next = 0;
+	new->size = live;
+	new->used = 0;
+
+	for (i = 0; i < obj->count; i++) {
+	    fields[0] = &obj->list[i].item;
+	    fields[1] = &obj->list[i].id;
+	    fields[2] = &obj->list[i].help;
+	    for (f = 0; f < 3; f++)
+		if ((len = LIAinarena(chunks, nrchunks, *fields[f])) > 0) {
+		    p = new->text + new->used;
+		    memcpy(p, *fields[f], len);
+		    new->used += len;
+		    *fields[f] = p;
+		}
+	}
+    }
+
+    for (i = 0; i < nrchunks; i++)
+	free(chunks[i]);
+    free(chunks);
+
+    obj->arena = new;
+    obj->used = obj->live = live;
+} /* LIAcompact */
+
+
+/*
+ * LIAallocate() makes sure that a LIA has a writable ListItem array
+ * with room for at least need items.  The first time a LIA is changed
+ * it gets its own copy of the array that was passed to newLIA(), but it
+ * keeps pointing at the caller's strings, which have to outlive the LIA
+ * anyway.
+ */
+static int
+LIAallocate(struct _LIA* obj, int need)
+{
+    int size;
     ListItem *tmp;
 
-    tmp = malloc( (obj->count+1) * sizeof tmp[0] );
-    for (i=0; i<obj->count; i++) {
-	tmp[i].id   = obj->list[i].id ? strdup(obj->list[i].id) : 0;
-	tmp[i].item = strdup(obj->list[i].item);
-	tmp[i].help = obj->list[i].help ? strdup(obj->list[i].help) : 0;
+    if (obj->changed && need <= obj->alloc)
+	return 0;
+
+    for (size = obj->alloc > 8 ? obj->alloc : 8; size < need; size *= 2)
+	;
+
+    if (obj->changed)
+	tmp = realloc(obj->list, size * sizeof tmp[0]);
+    else if ((tmp = malloc(size * sizeof tmp[0])) != 0 && obj->count > 0)
+	memcpy(tmp, obj->list, obj->count * sizeof tmp[0]);
+
+    if (tmp == 0) {
+	errno = ENOMEM;
+	return -1;
     }
     obj->changed = 1;
     obj->list = tmp;
+    obj->alloc = size;
+    return 0;
 } /* LIAallocate */
 
 
 /*
- * addToLIA() unconditionally adds a ListItem to a LIA
+ * addManyToLIA() adds an array of ListItems to the end of a LIA, copying
+ * their strings.
  */
 int
-addToLIA(LIA o, char *id, char *item, char *help)
+addManyToLIA(LIA o, ListItem *items, int nritems)
 {
     struct _LIA *obj = (struct _LIA*)o;
+    ListItem *dest;
+    int i;
 
-    if (o == 0 || item == 0) {
+    if (o == 0 || nritems < 0 || (nritems > 0 && items == 0)) {
 	errno = EFAULT;
 	return EOF;
     }
-    if (obj->changed)
-	obj->list = realloc(obj->list, (1+obj->count) * sizeof obj->list[0]);
-    else
-	LIAallocate(obj);
+    for (i = 0; i < nritems; i++)
+	if (items[i].item == 0) {
+	    errno = EFAULT;
+	    return EOF;
+	}
 
-    if (obj->list == 0) {
-	obj->count = 0;
+    if (obj->list && items >= obj->list && items < obj->list + obj->count) {
+	/* copying items from this LIA; the array may move */
+	i = items - obj->list;
+	if (LIAallocate(obj, obj->count + nritems) != 0)
+	    return EOF;
+	items = obj->list + i;
+    }
+    else if (LIAallocate(obj, obj->count + nritems) != 0)
 	return EOF;
+
+    for (dest = obj->list + obj->count, i = 0; i < nritems; i++, dest++) {
+	if ((dest->item = LIAstrdup(obj, items[i].item)) == 0
+		|| (items[i].id && (dest->id = LIAstrdup(obj, items[i].id)) == 0)
+		|| (items[i].help && (dest->help = LIAstrdup(obj, items[i].help)) == 0)) {
+	    /* keep what we've managed to add */
+	    errno = ENOMEM;
+	    obj->count += i;
+	    return EOF;
+	}
+	if (items[i].id == 0)
+	    dest->id = 0;
+	if (items[i].help == 0)
+	    dest->help = 0;
+	dest->selected = items[i].selected;
     }
-    obj->list[obj->count].id   = id ? strdup(id) : 0;
-    obj->list[obj->count].item = strdup(item);
-    obj->list[obj->count].help = help ? strdup(help) : 0;
-    obj->list[obj->count].selected = 0;
-    return ++(obj->count);
+    return (obj->count += nritems);
+} /* addManyToLIA */
+
+
+/*
+ * addToLIA() unconditionally adds a ListItem to a LIA
+ */
+int
+addToLIA(LIA o, char *id, char *item, char *help)
+{
+    ListItem tmp;
+
+    tmp.id = id;
+    tmp.item = item;
+    tmp.help = help;
+    tmp.selected = 0;
+
+    return addManyToLIA(o, &tmp, 1);
 } /* addListItem */
 
 
 /*
- * delFromLIA() deleted a numbered ListItem from a LIA
+ * delRangeFromLIA() deletes nritems ListItems, starting at del, from a LIA
  */
 int
-delFromLIA(LIA o, int del)
+delRangeFromLIA(LIA o, int del, int nritems)
 {
     struct _LIA *obj = (struct _LIA*)o;
-    int x;
+    ListItem *p;
+    int i;
 
-    if (o == 0 || del < 0 || del >= obj->count)
+    if (o == 0 || del < 0 || nritems < 0 || del + nritems > obj->count)
 	return EOF;
 
-    if (obj->changed == 0)
-	LIAallocate(obj);
+    if (LIAallocate(obj, obj->count) != 0)
+	return EOF;
+
+    if (obj->arena)
+	for (p = obj->list + del, i = 0; i < nritems; i++, p++) {
+	    if (p->item)
+		obj->live -= strlen(p->item) + 1;
+	    if (p->id)
+		obj->live -= strlen(p->id) + 1;
+	    if (p->help)
+		obj->live -= strlen(p->help) + 1;
+	}
+
+    memmove(obj->list + del, obj->list + del + nritems,
+	    (obj->count - (del + nritems)) * sizeof obj->list[0]);
 
-    if (obj->list[del].id)
-	free(obj->list[del].id);
-    if (obj->list[del].help)
-	free(obj->list[del].help);
-    free(obj->list[del].item);
+    obj->count -= nritems;
 
-    for (x=del; x < (obj->count-1); x++)
-	obj->list[x] = obj->list[x+1];
+    if (obj->used > LIACOMPACT && obj->live < obj->used / 2)
+	LIAcompact(obj);
+
+    return obj->count;
+} /* delRangeFromLIA */
+
+
+/*
+ * delFromLIA() deleted a numbered ListItem from a LIA
+ */
+int
+delFromLIA(LIA o, int del)
+{
+    if (o == 0 || del < 0 || del >= ((struct _LIA*)o)->count)
+	return EOF;
 
-    return --(obj->count);
+    return delRangeFromLIA(o, del, 1);
 } /* delListItem */
 
 
@@ -796,6 +1035,7 @@ newDisplay(void* win, int x, int y)
 	ptr->window = win;
 	ptr->x = x;
 	ptr->y = y;
+	ptr->form = 0;
     }
     return ptr;
 } /* newDisplay */
@@ -813,14 +1053,20 @@ deleteDisplay(Display *junk)
 
 
 /*
- * ndgetch() gets input from the display.  Currently, we merely map meta
+ * getkey() gets input from the display.  Currently, we merely map meta
  * keys to KEY_F(x) combinations (M digit => KEY_F(digit) is the only one
  * implemented), but if we want to do more sophisticated input in the
  * future (like grabbing ALT keys from a IBM PC console), we will do it
  * here.
+ *
+ * If the window isn't waiting for input (formStep(), or a form timer
+ * coming due) the key after a ^X might not be there yet, so we remember
+ * that we saw the ^X and finish the lookahead on the next call.
  */
-int
-ndgetch(Display *from)
+static int metakey = 0;
+
+static int
+getkey(Display *from)
 {
     int c;
 
@@ -829,9 +1075,16 @@ ndgetch(Display *from)
 #endif
     c = ndwgetch(Window(from));
 
-    if (c == 'X'-'@') {
+    if (metakey || c == 'X'-'@') {
 	/* meta key; do one-character lookahead */
-	c = ndwgetch(Window(from));
+	if (!metakey)
+	    c = ndwgetch(Window(from));
+
+	if (c == ERR) {
+	    metakey = 1;
+	    return ERR;
+	}
+	metakey = 0;
 
 	switch (c) {
 	case '1': case '2': case '3': case '4': case '5':
@@ -859,6 +1112,29 @@ ndgetch(Display *from)
     else if (c == '\177' || c == '\010')
 	return KEY_BACKSPACE;
 #endif
+    return c;
+} /* getkey */
+
+
+/*
+ * ndgetch() gets a key from the display.  If the display belongs to a
+ * form, ndgetch() runs the form timers and idle callbacks while it waits,
+ * waking up (via wtimeout()) whenever the next timer is due.
+ */
+int
+ndgetch(Display *from)
+{
+    int c;
+    int wait = -1;
+
+    do {
+	if (from->form) {
+	    wait = _nd_formTick(from->form);
+	    wtimeout(Window(from), wait);
+	}
+	c = getkey(from);
+    } while (c == ERR && wait > 0);
+
     return c;
 } /* ndgetch */
 
@@ -530,7 +530,8 @@ static void
 drawCheckItem(Obj *obj, int idx, WINDOW *win, int x, int y)
 {
     int current = obj->item.list.cury;
-    int selected = obj->item.list.items[idx].selected;
+    int item = LIST_ITEM(obj, idx);
+    int selected = _nd_listIsSelected(obj, item);
     int isradio = (obj->flags & RADIO_LIST);
     int iscurrent = 0;
 
@@ -550,7 +551,7 @@ drawCheckItem(Obj *obj, int idx, WINDOW *win, int x, int y)
     waddch(win, isradio ? ')' : ']');
     waddch(win, ' ');
     if (obj->flags & SHOW_IDS) {
-	char *p = obj->item.list.items[idx].id;
+	char *p = obj->item.list.items[item].id;
 	if ((obj->flags & NO_HOTKEYS) == 0) {
 	    setcolor(win, iscurrent ? SELECTED_COLOR : HOTKEY_COLOR);
 	    waddch(win, (*p++));
@@ -560,7 +561,7 @@ drawCheckItem(Obj *obj, int idx, WINDOW *win, int x, int y)
     }
     setcolor(win, WINDOW_COLOR);
     wmove(win, y, x+obj->item.list.itemoffset);
-    waddnstr(win, obj->item.list.items[idx].item, obj->width - obj->item.list.itemoffset);
+    waddnstr(win, obj->item.list.items[item].item, obj->width - obj->item.list.itemoffset);
 } /* drawCheckItem */
 
 
@@ -572,6 +573,7 @@ static void
 drawMenuItem(Obj *obj, int idx, WINDOW *win, int x, int y)
 {
     int current = obj->item.list.cury;
+    int item = LIST_ITEM(obj, idx);
     int iscurrent = (current == idx && (IS_CURRENT(obj) || (obj->flags & ALWAYS_HIGHLIT)));
     int color = iscurrent ? SELECTED_COLOR : WINDOW_COLOR;
 
@@ -581,7 +583,7 @@ drawMenuItem(Obj *obj, int idx, WINDOW *win, int x, int y)
     wmove(win, y, x);
 
     if (obj->flags & SHOW_IDS) {
-	char *p = obj->item.list.items[idx].id;
+	char *p = obj->item.list.items[item].id;
 	if ((obj->flags & NO_HOTKEYS) == 0) {
 	    setcolor(win, iscurrent ? SELECTED_COLOR : HOTKEY_COLOR);
 	    waddch(win, (*p++));
@@ -592,7 +594,7 @@ drawMenuItem(Obj *obj, int idx, WINDOW *win, int x, int y)
 
     setcolor(win, color);
     wmove(win, y, x+obj->item.list.itemoffset);
-    waddnstr(win, obj->item.list.items[idx].item, obj->width - obj->item.list.itemoffset);
+    waddnstr(win, obj->item.list.items[item].item, obj->width - obj->item.list.itemoffset);
     setcolor(win, WINDOW_COLOR);
 } /* drawMenuItem */
 
@@ -605,7 +607,8 @@ static void
 drawHighlitItem(Obj* obj, int idx, WINDOW* win, int x, int y)
 {
     int current = obj->item.list.cury;
-    int selected = obj->item.list.items[idx].selected;
+    int item = LIST_ITEM(obj, idx);
+    int selected = _nd_listIsSelected(obj, item);
     int color = selected ? SELECTED_COLOR : WINDOW_COLOR;
 
     if ((current == idx) && IS_CURRENT(obj)) {
@@ -615,7 +618,7 @@ drawHighlitItem(Obj* obj, int idx, WINDOW* win, int x, int y)
     wmove(win, y, x + 1);
 
     if (obj->flags & SHOW_IDS) {
-	char *p = obj->item.list.items[idx].id;
+	char *p = obj->item.list.items[item].id;
 	if ((obj->flags & NO_HOTKEYS) == 0) {
 	    setcolor(win, HOTKEY_COLOR);
 	    waddch(win, (*p++));
@@ -625,7 +628,7 @@ drawHighlitItem(Obj* obj, int idx, WINDOW* win, int x, int y)
     }
     setcolor(win, color);
     wmove(win, y, x+obj->item.list.itemoffset);
-    waddnstr(win, obj->item.list.items[idx].item, obj->width - obj->item.list.itemoffset);
+    waddnstr(win, obj->item.list.items[item].item, obj->width - obj->item.list.itemoffset);
     setcolor(win, WINDOW_COLOR);
 } /* drawHighlitItem */
 
@@ -641,7 +644,7 @@ drawListElement(Obj *obj, WINDOW *win, int idx, int y, int x, int start)
     waddnstr(win, rillyrillylongblankstring, obj->width);
 
     /* don't try to draw anything unless there's something to draw */
-    if (obj->item.list.items && idx < obj->item.list.nritems)
+    if (obj->item.list.items && idx < LIST_ROWS(obj))
 	switch (obj->item.list.kind) {
 	default:	/* we'll default to a checked item if the sky falls */
 	case LO_CHECK:
@@ -682,7 +685,7 @@ drawList(void *o, void* w)
 	    setcolor(win, WIDGET_COLOR);
 	    mvwaddstr(win, y-1, x+obj->width-3, "(-)");
 	}
-	if (start+obj->depth < obj->item.list.nritems) {
+	if (start+obj->depth < LIST_ROWS(obj)) {
 	    setcolor(win, WIDGET_COLOR);
 	    mvwaddstr(win, y+obj->depth, x+obj->width-3, "(+)");
 	}
@@ -701,6 +704,110 @@ drawList(void *o, void* w)
 } /* drawList */
 
 
+/*
+ * _nd_dataXY() works out where the data in an object is drawn, without
+ * drawing anything, and returns what _nd_drawObjCommon() would have.
+ */
+int
+_nd_dataXY(void *o, void *w, int *x, int *y)
+{
+    Obj *obj = OBJ(o);
+    int rc = 0;
+
+    *x = WX(w);
+    *y = WY(w);
+
+    if (obj->parent == 0 || (obj->flags & OBJ_DRAW)) {
+	if (obj->title)
+	    rc |= DREW_TITLE;
+	if (obj->prefix || obj->suffix || objType(obj) == O_TEXT)
+	    rc |= DREW_A_BOX;
+	if (obj->prefix)
+	    rc |= DREW_PREFIX;
+	if (obj->suffix)
+	    rc |= DREW_SUFFIX;
+    }
+    else if (obj->prefix || obj->suffix)
+	rc = DREW_A_BOX;
+
+    _nd_adjustXY(rc, obj, x, y);
+    return rc;
+} /* _nd_dataXY */
+
+
+/*
+ * _nd_scrollArea() scrolls a width x depth area of a window up (if dy
+ * is positive) or down dy lines, leaving blank lines behind.  Curses
+ * can only scroll whole windows, so we make a little window on top of
+ * the area and scroll that instead.  (Whether the terminal itself is
+ * scrolled is up to refresh(), which notices lines that have moved.)
+ */
+void
+_nd_scrollArea(WINDOW *win, int x, int y, int width, int depth, int dy)
+{
+    WINDOW *area;
+
+    if ((area = derwin(win, depth, width, y, x)) == 0) {
+	/* just blank it and let the caller fill it in */
+	for ( ; depth > 0; depth--)
+	    mvwaddnstr(win, y+depth-1, x, rillyrillylongblankstring, width);
+	return;
+    }
+    scrollok(area, TRUE);
+    wscrl(area, dy);
+    wsyncup(area);
+    delwin(area);
+} /* _nd_scrollArea */
+
+
+/*
+ * _nd_drawListRows() redraws a list after the cursor has moved from
+ * oldcury (and the top of the list from oldtopy).  If the list didn't
+ * scroll, only the rows the cursor left and landed on are drawn;  if it
+ * scrolled by one row, the rows on the screen are scrolled and only the
+ * new row is drawn.  Anything else redraws the whole list.
+ */
+void
+_nd_drawListRows(void *o, void *w, int oldtopy, int oldcury)
+{
+    Obj *obj = OBJ(o);
+    WINDOW *win = Window(w);
+    int topy, cury, nrrows, dy;
+    int x, y;
+
+    if (obj == 0 || objType(obj) != O_LIST || (obj->flags & OBJ_HIDDEN))
+	return;
+
+    topy = obj->item.list.topy;
+    cury = obj->item.list.cury;
+    nrrows = LIST_ROWS(obj);
+    dy = topy - oldtopy;
+
+    /* widgets may do their own thing when a list moves, and moving
+     * off either end of the list changes the (-) and (+) markers, so
+     * they get drawn the slow way.
+     */
+    if (obj->parent || dy < -1 || dy > 1
+		    || (oldtopy > 0) != (topy > 0)
+		    || (oldtopy+obj->depth < nrrows) != (topy+obj->depth < nrrows)) {
+	drawObj(obj, w);
+	return;
+    }
+
+    _nd_dataXY(obj, w, &x, &y);
+    setcolor(win, WINDOW_COLOR);
+
+    if (dy) {
+	_nd_scrollArea(win, x, y, obj->width, obj->depth, dy);
+	drawListElement(obj, win, (dy > 0) ? topy+obj->depth-1 : topy,
+				  y, x, topy);
+    }
+    if (oldcury != cury && oldcury >= topy && oldcury < topy+obj->depth)
+	drawListElement(obj, win, oldcury, y, x, topy);
+    drawListElement(obj, win, cury, y, x, topy);
+} /* _nd_drawListRows */
+
+
 /*
  * drawGauge() draws a progress bar
  */
@@ -33,6 +33,18 @@ editCode editMenu(void*, void*, MEVENT*, editCode);
 editCode editCheck(void*, void*, MEVENT*, editCode);
 editCode editList(void*, void*, MEVENT*, editCode);
 editCode editText(void*, void*, MEVENT*, editCode);
+
+editCode startButton(void*, void*, MEVENT*, editCode);
+editCode startString(void*, void*, MEVENT*, editCode);
+editCode startCheck(void*, void*, MEVENT*, editCode);
+editCode startList(void*, void*, MEVENT*, editCode);
+editCode startText(void*, void*, MEVENT*, editCode);
+
+editCode keyButton(void*, void*, int);
+editCode keyString(void*, void*, int);
+editCode keyCheck(void*, void*, int);
+editCode keyList(void*, void*, int);
+editCode keyText(void*, void*, int);
 #if !DYNAMIC_BINDING
 editCode editListWidget(void*, void*, MEVENT*, editCode);
 editCode editFileSelector(void*, void*, MEVENT*, editCode);
@@ -45,8 +57,21 @@ editCode editFileSelector(void*, void*, MEVENT*, editCode);
 
 extern void _nd_adjustXY(int, void*, int*, int*);
 extern int _nd_drawObjCommon(void*, void*);
+extern int _nd_dataXY(void*, void*, int*, int*);
+extern void _nd_scrollArea(WINDOW*, int, int, int, int, int);
+extern void _nd_drawListRows(void*, void*, int, int);
 extern void _nd_help(char*);
 extern int _nd_inside(Obj*, MEVENT*);
+extern int _nd_hitTest(void**, Obj**, int, int, MEVENT*);
+extern void _nd_freeHitGrid(void*);
+extern int _nd_geometry;
+
+extern void *_nd_newForm(void*, int, int, char*, char*, int);
+extern void *_nd_formDisplay(void*);
+extern void _nd_setFormPrompt(void*, char*);
+extern void _nd_deleteForm(void*);
+extern int _nd_formTick(void*);
+extern int _nd_formTimer(void*, int);
 
 #define ADJUSTXY(o,xp,yp)	(xp += o->x, yp += o->y)
 
@@ -2,9 +2,13 @@
 
 #include <stdio.h>
 #include <dialog.h>
+#include <ndialog.h>
+#include "virtual_list.h"
+#include "listfilter.h"
 #include <string.h>
 #include <unistd.h>
 #include <stdlib.h>
+#include <ctype.h>
 
 static char *choices[] = {
     "menu", "dialog_menu",
@@ -15,6 +19,9 @@ static char *choices[] = {
     "msg", "dialog_msgbox",
     "yesno", "dialog_yesno",
     "gauge", "dialog_gauge",
+    "fastgauge", "openGauge",
+    "biglist", "newVirtualList",
+    "filter", "newListFilter",
 };
 #define NRCHOICES	(sizeof choices / sizeof choices[0])/2
 
@@ -28,6 +35,42 @@ static char *menu[] = {
     "GG", "Choice G", 
 };
 
+/* a million row list for the virtual list demo
+ */
+#define BIGLIST	1000000
+static char *bigsel;
+
+static int
+bigrow(void *ctx, long row, ListItem *item)
+{
+    static char text[40];
+
+    sprintf(text, "%c row %ld", 'A' + (int)(row % 26), row);
+    item->item = text;
+    item->selected = bigsel ? bigsel[row] : 0;
+    return 0;
+}
+
+static int
+bigselect(void *ctx, long row, int selected)
+{
+    if (bigsel)
+	bigsel[row] = selected;
+    return 0;
+}
+
+static long
+bigfind(void *ctx, long from, int c)
+{
+    long row;
+
+    c = toupper(c);
+    if (c < 'A' || c > 'Z')
+	return -1;
+    row = from + 1 + ((c - 'A') - (from + 1) % 26 + 26) % 26;
+    return (row < BIGLIST) ? row : (c - 'A');
+}
+
 static char *checklist[] = {
     "AA", "Choice A",  "off",
     "BB", "Choice B",  "on",
@@ -122,6 +165,64 @@ main()
 	    else
 		dialog_notify("Something Wicked Happened!");
 	}
+	else if (strstr(result, "fastgauge")) {
+	    ndGauge g = openGauge("test", "100000 updates", 1, 40);
+	    char msg[40];
+	    int x;
+
+	    if (g) {
+		for (x=0; x<100000; x++) {
+		    if (x % 10000 == 0) {
+			sprintf(msg, "%d updates", 100000-x);
+			updateGauge(g, x/1000, msg);
+		    }
+		    else
+			updateGauge(g, x/1000, 0);
+		}
+		updateGauge(g, 100, "done");
+		flushGauge(g);
+		sleep(1);
+		closeGauge(g);
+	    }
+	}
+	else if (strstr(result, "biglist")) {
+	    static ndRowProvider rows = { bigrow, bigselect, bigfind };
+	    ndObject list;
+
+	    if (bigsel == 0)
+		bigsel = calloc(BIGLIST, 1);
+	    list = newVirtualList(0, 0, 30, 12, BIGLIST, &rows, 0,
+				  "A million rows", 0, 0, 0, 0);
+	    if (list) {
+		list = ObjChain(0, list);
+		MENU(list, -1, -1, "biglist", 0, 0);
+		deleteObjChain(list);
+	    }
+	}
+	else if (strstr(result, "filter")) {
+	    static char *words[] = { "alpha", "bravo", "charlie", "delta",
+				     "echo", "foxtrot", "golf", "hotel" };
+	    static ListItem items[64];
+	    static char text[64][20];
+	    ndObject list, filter, chain;
+	    int x;
+
+	    for (x = 0; x < 64; x++) {
+		sprintf(text[x], "%s %s", words[x/8], words[x%8]);
+		items[x].id = 0;
+		items[x].item = text[x];
+		items[x].help = 0;
+		items[x].selected = 0;
+	    }
+	    list = newList(0, 2, 30, 10, 64, items, 0, 0, 0, 0, 0);
+	    filter = list ? newListFilter(0, 0, 30, 20, list, "Filter:", 0, 0)
+			  : 0;
+	    if (list && filter) {
+		chain = ObjChain(filter, list);
+		MENU(chain, -1, -1, "filter", 0, 0);
+		deleteObjChain(chain);
+	    }
+	}
 	else if (strstr(result, "gauge")) { 
 	    int x;
 	    for (x=0; x<=20; x++) {
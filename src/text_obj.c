@@ -22,11 +22,10 @@
  * newText() creates a new textbox
  */
 void*
-newText(int x, int y, int width, int depth, int bfrsize,
+newText(int x, int y, int width, int depth, long bfrsize,
         char* prompt, char* prefix, char* bfr, pfo callback, char* help)
 {
     Obj *tmp;
-    extern int newTextData(Obj *obj);
 
     if (width < 1 || depth < 1 || bfrsize < 1 || bfr == (char*)0) {
 	errno = EINVAL;
@@ -37,7 +36,7 @@ newText(int x, int y, int width, int depth, int bfrsize,
 			      x, y, width, depth, help);
 
     if (tmp != (Obj*)0) {
-	if (newTextData(tmp) < 0) {
+	if (_nd_textIndex(tmp, bfrsize) < 0) {
 	    deleteObj(tmp);
 	    return 0;
 	}
@@ -165,17 +164,47 @@ dtladdch(WINDOW *win, Obj *obj, int ch, int *xp)
 } /* dtladdch */
 
 
+/*
+ * hilite() turns the highlighting for search matches on or off
+ */
+static void
+hilite(WINDOW *win, int *on, int hit)
+{
+    if (hit == *on)
+	return;
+#if WITH_NCURSES
+    if (hit)
+	wattron(win, A_REVERSE);
+    else
+	wattroff(win, A_REVERSE);
+#else
+    if (hit)
+	wstandout(win);
+    else
+	wstandend(win);
+#endif
+    *on = hit;
+} /* hilite */
+
+
 /*
  * drawTextLine() draws a single line from a Text object
  */
 static void
 drawTextLine(WINDOW *win, Obj *obj, int idx)
 {
-    int xp;
+    int xp, len;
+    int hit = 0;
     char *p;
 
-    for (xp=0, p = obj->item.text.lines[idx]; *p != 0 && *p != '\n'; ++p)
+    if ((p = _nd_textLine(obj, idx, &len)) == 0)
+	return;
+    _nd_searchLine(obj, p, len);
+    for (xp=0; len-- > 0 && *p != 0; ++p) {
+	hilite(win, &hit, _nd_searchHit(obj, p));
 	dtladdch(win, obj, *p, &xp);
+    }
+    hilite(win, &hit, 0);
 } /* drawTextLine */
 
 
@@ -186,14 +215,19 @@ static void
 drawHtmlLine(WINDOW *win, Obj *obj, int yp)
 {
     int x;
-    unsigned char *line = (unsigned char*)(obj->item.text.lines[yp]);
+    unsigned char *line = (unsigned char*)_nd_textLine(obj, yp, 0);
     int indent = 0;
     int t;
     short href = -1;
     int wx, wy;
+    int hit = 0, len;
 
     wy = yp - obj->item.text.topy;
 
+    if (line == 0)
+	return;
+    _nd_textLine(obj, yp, &len);
+    _nd_searchLine(obj, (char*)line, len);
     if (*line == DLE) {
 	indent = line[1]-' ';
 	line += 2;		/* move start of line over the indent code */
@@ -262,7 +296,8 @@ drawHtmlLine(WINDOW *win, Obj *obj, int yp)
 	else
     printch:
 	    if (wx >= 0) {
-		if (href >= 0) {
+		hilite(win, &hit, _nd_searchHit(obj, (char*)line));
+		if (href >= 0 && !hit) {
 #if WITH_NCURSES
 		    wattron(win, (href==obj->item.text.href)
 				       ? A_REVERSE
@@ -284,6 +319,7 @@ drawHtmlLine(WINDOW *win, Obj *obj, int yp)
 		x++;
 	    }
     }
+    hilite(win, &hit, 0);
 } /* drawHtmlLine */
 
 
@@ -301,9 +337,17 @@ drawText(void *o, void* w)
     int x = WX(w),
 	y = WY(w);
 
-    if (o == 0 || objType(o) != O_TEXT || obj->item.text.lines == 0)
+    if (o == 0 || objType(o) != O_TEXT || obj->item.text.index == 0)
 	return;
     rc = _nd_drawObjCommon(obj, w);
+
+    /* index as far as the line after the bottom of the window, so
+     * we know whether to draw the (+)
+     */
+    _nd_textLines(obj, obj->item.text.topy + obj->depth + 1);
+    _nd_textBackground(obj, DISPLAY(w)->form);
+    if (obj->item.text.class == T_IS_FOLLOW)
+	_nd_textFollow(obj, DISPLAY(w)->form);
     _nd_adjustXY(rc, obj, &x, &y);
 
     if (obj->item.text.bs)
@@ -339,16 +383,32 @@ drawText(void *o, void* w)
     }
 
     if ((rc & DREW_A_BOX) && obj->width > 8 && obj->item.text.nrlines > 0) {
-	int percent = ((obj->item.text.topy+obj->depth)*100) / obj->item.text.nrlines;
+	int percent = ((long)(obj->item.text.topy+obj->depth)*100) / obj->item.text.nrlines;
 	char bfr[8];
 
-	if (percent < 100)
+	if (!_nd_textDone(obj))	/* still counting the lines */
+	    strcpy(bfr, "??%");
+	else if (percent < 100)
 	    sprintf(bfr, "%d%%", percent);
 	else
 	    strcpy(bfr, "100%");
 	setcolor(win, WINDOW_COLOR);
 	mvwaddstr(win, y+obj->depth, x+obj->width-(3+strlen(bfr)), bfr);
     }
+
+    if ((rc & DREW_A_BOX) && obj->width > 10) {
+	/* the search that's being typed in */
+	char *prompt = _nd_searchPrompt(obj);
+
+	if (prompt) {
+	    int len = strlen(prompt);
+
+	    if (len > obj->width-10)	/* show the end of it */
+		prompt += len - (obj->width-10);
+	    setcolor(win, WINDOW_COLOR);
+	    mvwaddstr(win, y+obj->depth, x, prompt);
+	}
+    }
 } /* drawText */
 
 
@@ -439,228 +499,269 @@ scan_for_tag(Obj *obj, int direction)
 #define TOPY		(obj->item.text.topy)
 #define NRLINES		(obj->item.text.nrlines)
 
+
+/*
+ * findLines() is a local function that indexes enough of the text to
+ * handle a keypress;  a page past the bottom of the window, or all of
+ * it if we're going to the end
+ */
+static void
+findLines(Obj *obj, int c)
+{
+    if (c == KEY_END)
+	_nd_textCount(obj);
+    else
+	_nd_textLines(obj, TOPY + 2*obj->depth + 1);
+} /* findLines */
+
 /*
- * editHtmlText() is a local function that handles navigation on a html page
+ * keyHtmlText() is a local function that handles navigation on a html page
  */
 static editCode
-editHtmlText(Obj *obj, void *w)
+keyHtmlText(Obj *obj, void *w, int c)
 {
-    register int c;
     int x=0, href;
     int cb_stat;
     int rescan_tags = 0;
     int touch = 0;
 
-    while ((c = ndgetch(w)) != EOF) {
-
-	switch (c) {
-	case KEY_F(1):	_nd_help(objHelp(obj));	break;
-	case KEY_RIGHT:
-	case '\r':	/* RETURN on a html tag fires the callback */
-	case '\n':	href = obj->item.text.href;
-
-			/* except we don't want to fire the callback if
-			 * the current tag isn't on the page */
-			if (href >= 0)
-			    for (x = (obj->depth * obj->width)-1; x>=0; --x)
-				if (href == obj->item.text.bs[x])
-				    break;
-			if (x < 0 || href < 0)	/* can't get away if */
-			    continue;	/* the tag isn't on this page */
-
-			if ((cb_stat = _nd_callback(obj, w)) == 0)
-			    continue;
-			if (cb_stat != 0)
-			    return (cb_stat < 0) ? eEXITFORM : eRETURN;
-			break;
+    if (_nd_searchKey(obj, w, c))
+	return eNOP;
+    findLines(obj, c);
+    switch (c) {
+    case EOF:	return eESCAPE;
+    case KEY_F(1):	_nd_help(objHelp(obj));	break;
+    case KEY_RIGHT:
+    case '\r':	/* RETURN on a html tag fires the callback */
+    case '\n':	href = obj->item.text.href;
+
+		    /* except we don't want to fire the callback if
+		     * the current tag isn't on the page */
+		    if (href >= 0)
+			for (x = (obj->depth * obj->width)-1; x>=0; --x)
+			    if (href == obj->item.text.bs[x])
+				break;
+		    if (x < 0 || href < 0)	/* can't get away if */
+			return eNOP;	/* the tag isn't on this page */
+
+		    if ((cb_stat = _nd_callback(obj, w)) == 0)
+			return eNOP;
+		    if (cb_stat != 0)
+			return (cb_stat < 0) ? eEXITFORM : eRETURN;
+		    break;
 #if VERMIN
-	case KEY_MOUSE:	return eEVENT;
+    case KEY_MOUSE:	return eEVENT;
 #endif
-	case 'R'-'@':	return eREFRESH;
-	case KEY_LEFT:
-	case ESCAPE:	return eESCAPE;
-	case KEY_BTAB:
-	case KEY_UP:	if (scan_for_tag(obj, -1) == 0) {
-			    TOPY -= obj->depth;
-			    if (TOPY < 0)
+    case 'R'-'@':	return eREFRESH;
+    case KEY_LEFT:
+    case ESCAPE:	return eESCAPE;
+    case KEY_BTAB:
+    case KEY_UP:	if (scan_for_tag(obj, -1) == 0) {
+			TOPY -= obj->depth;
+			if (TOPY < 0)
+			    TOPY = 0;
+			rescan_tags = -1;
+		    }
+		    touch++;
+		    break;
+    case KEY_DOWN:
+    case '\t':	if (scan_for_tag(obj, 1) == 0) {
+			TOPY += obj->depth;
+			if (TOPY + obj->depth > NRLINES) {
+			    TOPY = NRLINES - obj->depth;
+			    if (TOPY < 0)	/* paranoia */
 				TOPY = 0;
-			    rescan_tags = -1;
 			}
-			touch++;
-			break;
-	case KEY_DOWN:
-	case '\t':	if (scan_for_tag(obj, 1) == 0) {
-			    TOPY += obj->depth;
-			    if (TOPY + obj->depth > NRLINES) {
-				TOPY = NRLINES - obj->depth;
-				if (TOPY < 0)	/* paranoia */
-				    TOPY = 0;
-			    }
-			    rescan_tags = 1;
-			}
-			touch++;
-			break;
+			rescan_tags = 1;
+		    }
+		    touch++;
+		    break;
 
-	case 'U'-'@':
-	case KEY_PPAGE:			/* PAGE UP */
-	    TOPY -= obj->depth;
-	    if (TOPY < 0)
-	case KEY_HOME:			/* HOME.  And, yes, this is supposed */
-		TOPY = 0;		/* to be here */
-	    touch++;
-	    break;
-
-	case 'D'-'@':
-	case KEY_NPAGE:			/* PAGE DOWN */
-	    TOPY += obj->depth;
-	    if (TOPY + obj->depth > NRLINES) {
-	case KEY_END:			/* END.  See KEY_HOME comment */
-		TOPY = NRLINES - obj->depth;
-		if (TOPY < 0)	/* paranoia */
-		    TOPY = 0;
-	    }
-	    touch++;
-	    break;
+    case 'U'-'@':
+    case KEY_PPAGE:			/* PAGE UP */
+	TOPY -= obj->depth;
+	if (TOPY < 0)
+    case KEY_HOME:			/* HOME.  And, yes, this is supposed */
+	    TOPY = 0;		/* to be here */
+	touch++;
+	break;
 
-	case '>':
-	    if (obj->item.text.off_x + obj->width < obj->item.text.width) {
-		obj->item.text.off_x ++;
-		touch++;
-	    }
-	    break;
+    case 'D'-'@':
+    case KEY_NPAGE:			/* PAGE DOWN */
+	TOPY += obj->depth;
+	if (TOPY + obj->depth > NRLINES) {
+    case KEY_END:			/* END.  See KEY_HOME comment */
+	    TOPY = NRLINES - obj->depth;
+	    if (TOPY < 0)	/* paranoia */
+		TOPY = 0;
+	}
+	touch++;
+	break;
 
-	case '<':
-	    if (obj->item.text.off_x > 0) {
-		obj->item.text.off_x--;
-		touch++;
-	    }
-	    break;
+    case '>':
+	if (obj->item.text.off_x + obj->width < obj->item.text.width) {
+	    obj->item.text.off_x ++;
+	    touch++;
 	}
+	break;
 
-	if (touch) {
-	    drawObj(obj, w);
-	    if (rescan_tags) {
-		if (scan_for_tag(obj, rescan_tags) == 1)
-		    drawObj(obj, w);
-		rescan_tags = 0;
-	    }
-	    touch = 0;
+    case '<':
+	if (obj->item.text.off_x > 0) {
+	    obj->item.text.off_x--;
+	    touch++;
+	}
+	break;
+    }
+
+    if (touch) {
+	drawObj(obj, w);
+	if (rescan_tags) {
+	    if (scan_for_tag(obj, rescan_tags) == 1)
+		drawObj(obj, w);
 	}
     }
-    return eESCAPE;
-} /* editHtmlCode */
+    return eNOP;
+} /* keyHtmlText */
 
 
 /*
- * editPlainText() is a local function that edits a regular text object
+ * scrollPlainText() is a local function that redraws a text object that
+ * has scrolled by one line, by scrolling the lines that are already on
+ * the screen and drawing the one that's new.
  */
-static editCode
-editPlainText(Obj* obj, void *w)
+static void
+scrollPlainText(Obj *obj, void *w, int dy)
 {
-    register int c;
-    int touch = 0;
+    WINDOW *win = Window(w);
+    int oldtopy = TOPY - dy;
+    int x, y, yp;
+
+    /* scrolling off the top or the bottom changes the (-) and (+)
+     * markers, so let drawText() do it.
+     */
+    if (obj->parent || (obj->flags & OBJ_HIDDEN)
+		    || (oldtopy > 0) != (TOPY > 0)
+		    || (oldtopy+obj->depth < NRLINES) != (TOPY+obj->depth < NRLINES)) {
+	drawObj(obj, w);
+	return;
+    }
+
+    _nd_dataXY(obj, w, &x, &y);
+    _nd_scrollArea(win, x, y, obj->width, obj->depth, dy);
+
+    yp = (dy > 0) ? obj->depth-1 : 0;
+    setcolor(win, WINDOW_COLOR);
+    wmove(win, y+yp, x);
+    waddnstr(win, rillyrillylongblankstring, obj->width);
+    wmove(win, y+yp, x);
+    if (TOPY+yp < NRLINES)
+	drawTextLine(win, obj, TOPY+yp);
+} /* scrollPlainText */
 
-    while ((c = ndgetch(w)) != EOF) {
 
-	switch (c) {
-	case KEY_F(1):	_nd_help(objHelp(obj));	break;
+/*
+ * keyPlainText() is a local function that edits a regular text object
+ */
+static editCode
+keyPlainText(Obj* obj, void *w, int c)
+{
+    int touch = 0;
+    int scrolled = 0;		/* scrolled one line up or down */
+
+    if (_nd_searchKey(obj, w, c))
+	return eNOP;
+    findLines(obj, c);
+    switch (c) {
+    case EOF:	return eESCAPE;
+    case KEY_F(1):	_nd_help(objHelp(obj));	break;
 #if VERMIN
-	case KEY_MOUSE:	return eEVENT;
+    case KEY_MOUSE:	return eEVENT;
 #endif
-	case 'R'-'@':	return eREFRESH;
-	case 'Q':
-	case ESCAPE:	return eESCAPE;
-	case KEY_BTAB:
-	case KEY_LEFT:	return eBACKTAB;
-	case KEY_RIGHT:
-	case '\t':	return eTAB;
-
-	case 'U'-'@':
-	case KEY_PPAGE:			/* PAGE UP */
-	    TOPY -= obj->depth;
-	    if (TOPY < 0)
-	case KEY_HOME:			/* HOME.  And, yes, this is supposed */
-		TOPY = 0;		/* to be here */
-	    touch++;
-	    break;
-
-	case '-':
-	case KEY_UP:
-	    if (TOPY == 0)
-		continue;
-	    TOPY--;
-	    touch++;
-	    break;
-	
-	case 'D'-'@':
-	case KEY_NPAGE:			/* PAGE DOWN */
-	    TOPY += obj->depth;
-	    if (TOPY + obj->depth > NRLINES) {
-	case KEY_END:			/* END.  See KEY_HOME comment */
-		TOPY = NRLINES - obj->depth;
-		if (TOPY < 0)	/* paranoia */
-		    TOPY = 0;
-	    }
-	    touch++;
-	    break;
+    case 'R'-'@':	return eREFRESH;
+    case 'Q':
+    case ESCAPE:	return eESCAPE;
+    case KEY_BTAB:
+    case KEY_LEFT:	return eBACKTAB;
+    case KEY_RIGHT:
+    case '\t':	return eTAB;
+
+    case 'U'-'@':
+    case KEY_PPAGE:			/* PAGE UP */
+	TOPY -= obj->depth;
+	if (TOPY < 0)
+    case KEY_HOME:			/* HOME.  And, yes, this is supposed */
+	    TOPY = 0;		/* to be here */
+	touch++;
+	break;
 
-	case '>':
-	    if (obj->item.text.off_x + obj->width < obj->item.text.width) {
-		obj->item.text.off_x ++;
-		touch++;
-	    }
-	    break;
+    case '-':
+    case KEY_UP:
+	if (TOPY == 0)
+	    return eNOP;
+	TOPY--;
+	scrolled = -1;
+	break;
+    
+    case 'D'-'@':
+    case KEY_NPAGE:			/* PAGE DOWN */
+	TOPY += obj->depth;
+	if (TOPY + obj->depth > NRLINES) {
+    case KEY_END:			/* END.  See KEY_HOME comment */
+	    TOPY = NRLINES - obj->depth;
+	    if (TOPY < 0)	/* paranoia */
+		TOPY = 0;
+	}
+	touch++;
+	break;
 
-	case '<':
-	    if (obj->item.text.off_x > 0) {
-		obj->item.text.off_x--;
-		touch++;
-	    }
-	    break;
+    case '>':
+	if (obj->item.text.off_x + obj->width < obj->item.text.width) {
+	    obj->item.text.off_x ++;
+	    touch++;
+	}
+	break;
 
-	case '+':
-	case KEY_DOWN:
-	    if (TOPY < NRLINES-obj->depth) {
-		TOPY++;
-		touch++;
-	    }
-	    break;
+    case '<':
+	if (obj->item.text.off_x > 0) {
+	    obj->item.text.off_x--;
+	    touch++;
 	}
+	break;
 
-	if (touch) {
-	    drawObj(obj, w);
-	    touch = 0;
+    case '+':
+    case KEY_DOWN:
+	if (TOPY < NRLINES-obj->depth) {
+	    TOPY++;
+	    scrolled = 1;
 	}
+	break;
     }
-    return eESCAPE;
-} /* editPlainText */
+
+    if (touch)
+	drawObj(obj, w);
+    else if (scrolled)
+	scrollPlainText(obj, w, scrolled);
+    return eNOP;
+} /* keyPlainText */
 
 
 /*
  * editText() does editing operations on a Text Object and its subclasses
  */
 editCode
-editText(void* o, void* w, MEVENT* ev, editCode cc)
+startText(void* o, void* w, MEVENT* ev, editCode cc)
 {
     Obj *obj = OBJ(o);
-#if HAVE_CURS_SET
-    int cursor_visibility;	/* hide the cursor when doing a menu */
-#endif
-    editCode rc = eESCAPE;	/* default to bailing out */
 
-    if (obj == 0 || obj->Class != O_TEXT || obj->item.text.lines == 0) {
+    if (obj == 0 || obj->Class != O_TEXT || obj->item.text.index == 0) {
 	errno = EINVAL;
 	return eERROR;
     }
 
-#if HAVE_CURS_SET
     /*
      * set up the initial cursor position and handle any mouse
      * events that may have sent us here.
      */
-    cursor_visibility = curs_set(0);
-#endif
-
 #if VERMIN
     if (cc == eEVENT) {
 	int cb_stat;
@@ -670,6 +771,7 @@ editText(void* o, void* w, MEVENT* ev, editCode cc)
 	int yp = (ev->y - obj->dty);
 	int xp = (ev->x - obj->dtx);
 
+	findLines(obj, 0);
 	if (yp < 0) {
 	    /* scroll backwards */
 	    dy = obj->depth;
@@ -706,20 +808,41 @@ editText(void* o, void* w, MEVENT* ev, editCode cc)
 	drawObj(obj, w);
     }
 #endif
-    /* and away we go! */
+
+#if HAVE_CURS_SET
+    /* hide the cursor when doing a menu */
+    obj->item.text.cursor = curs_set(0);
+#endif
+    return eNOP;
+} /* startText */
+
+
+editCode
+keyText(void* o, void* w, int c)
+{
+    Obj *obj = OBJ(o);
+    editCode rc;
 
     switch (obj->item.text.class) {
     case T_IS_HTML:
-	rc = editHtmlText(obj, w);
+	rc = keyHtmlText(obj, w, c);
 	break;
     default:
-	rc = editPlainText(obj, w);
+	rc = keyPlainText(obj, w, c);
 	break;
     }
 #if HAVE_CURS_SET
-    curs_set(cursor_visibility);
+    if (rc != eNOP)
+	curs_set(obj->item.text.cursor);
 #endif
     return rc;
+} /* keyText */
+
+
+editCode
+editText(void* o, void* w, MEVENT* ev, editCode cc)
+{
+    return _nd_editKeys(o, w, ev, cc, (nd_start)startText, keyText);
 } /* editText */
 
 
@@ -768,7 +891,7 @@ setHelpCursor(void* o, void* c)
     if (o == 0 || objType(o) != O_TEXT || cursor == 0)
 	return 0;
 
-    if (cursor->topy > obj->item.text.nrlines)
+    if (cursor->topy > _nd_textLines(obj, cursor->topy))
 	return 0;
 
     obj->item.text.topy  = cursor->topy;
@@ -784,6 +907,7 @@ int
 setTextCursor(Obj *obj, int position)
 {
     if (position == -1) {
+	_nd_textCount(obj);
 	TOPY = NRLINES - obj->depth;
 	if (TOPY < 0)
 	    TOPY = 0;
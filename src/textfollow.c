@@ -0,0 +1,473 @@
+/*
+ * textfollow: text boxes that follow a file as it grows (like tail -f),
+ *             or show what comes down a pipe as it arrives
+ *
+ * Copyright (C) 1996-2017 David L Parsons.
+ * The redistribution terms are provided in the COPYRIGHT file that must
+ * be distributed with this source code.
+ */
+#include <config.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#if HAVE_SYS_INOTIFY_H
+#include <sys/inotify.h>
+#endif
+
+#include "curse.h"
+#include "ndwin.h"
+#include "nd_objects.h"
+
+/* A following text box keeps the tail end of a file in a buffer of its
+ * own, and a form timer (started the first time the box is drawn) reads
+ * whatever's been added to the file since it last looked, puts it on the
+ * end of the buffer, and indexes the new lines.  If the box was showing
+ * the last line, it scrolls down to show the new last line.
+ *
+ * The buffer never holds much more than maxsize bytes;  when it fills,
+ * the oldest half of it is thrown away.
+ *
+ * The file is watched with inotify if we have it, or by fstat()ing it
+ * every TF_POLL msec if we don't.  If it's truncated, or renamed or
+ * deleted and replaced by a new file (the way logs are rotated), the
+ * box carries on with the new contents.
+ *
+ * A streaming text box reads from a pipe (or anything else that can't
+ * be mapped) instead, whenever poll() says there's something there,
+ * until it gets to the end of it.  It starts out empty, so it can be
+ * drawn right away and fill in as the text shows up.
+ */
+#define TF_MAX		(8*1024*1024)	/* default maxsize */
+#define TF_READ		(64*1024)	/* bytes per read() */
+#define TF_SLURP	(4*1024*1024)	/* the most to read per tick */
+#define TF_POLL		250		/* msec between looks at the file */
+#define TF_STREAM	50		/* ... or at a stream */
+
+typedef struct {
+    char *path;			/* the file (0 if it's a stream) */
+    int fd;			/* ... which we've got open */
+    int eof;			/* (a stream) we've read all of it */
+    dev_t dev;			/* ... and which one it is */
+    ino_t ino;
+    off_t offset;		/* how much of it we've read */
+    char *bfr;			/* the text we've got */
+    long size;
+    long alloc;
+    long max;			/* the most text to keep */
+    int ifd;			/* inotify descriptor, or -1 */
+    int wd;			/* ... and the watch on the file */
+    void *form;			/* the form we're following on */
+    int timer;			/* ... and the timer that does it */
+} Follow;
+
+#define TF(o)	((Follow*)((o)->item.text.extra))
+
+#if HAVE_SYS_INOTIFY_H
+#define TF_EVENTS	(IN_MODIFY|IN_ATTRIB|IN_DELETE_SELF|IN_MOVE_SELF)
+#endif
+
+
+/*
+ * reopen() opens (or reopens) the file, and starts watching it
+ */
+static int
+reopen(Follow *f)
+{
+    struct stat st;
+    int fd;
+
+    if ((fd = open(f->path, O_RDONLY)) < 0 || fstat(fd, &st) != 0) {
+	if (fd >= 0)
+	    close(fd);
+	return -1;
+    }
+    if (f->fd >= 0)
+	close(f->fd);
+    f->fd = fd;
+    f->dev = st.st_dev;
+    f->ino = st.st_ino;
+    f->offset = 0;
+
+#if HAVE_SYS_INOTIFY_H
+    if (f->ifd >= 0) {
+	if (f->wd >= 0)
+	    inotify_rm_watch(f->ifd, f->wd);
+	f->wd = inotify_add_watch(f->ifd, f->path, TF_EVENTS);
+    }
+#endif
+    return 0;
+} /* reopen */
+
+
+/*
+ * quiet() drains the inotify events, and tells whether there weren't
+ * any (so there's no need to look at the file)
+ */
+static int
+quiet(Follow *f)
+{
+#if HAVE_SYS_INOTIFY_H
+    union {
+	struct inotify_event ev;	/* (to line the buffer up) */
+	char bfr[4096];
+    } u;
+    int events = 0;
+
+    if (f->ifd < 0 || f->wd < 0)
+	return 0;
+
+    while (read(f->ifd, u.bfr, sizeof u.bfr) > 0)
+	events++;
+    return events == 0;
+#else
+    return 0;
+#endif
+} /* quiet */
+
+
+/*
+ * replaced() tells whether the file we've got open isn't the one that's
+ * at the path any more
+ */
+static int
+replaced(Follow *f)
+{
+    struct stat st;
+
+    return stat(f->path, &st) == 0 && (st.st_dev != f->dev
+				    || st.st_ino != f->ino);
+} /* replaced */
+
+
+/*
+ * append() reads up to size bytes from the file onto the end of the
+ * buffer, making room for them by throwing away old text if it has to,
+ * and returns how many bytes it read (0 at the end of the file, or -1
+ * on an error.)
+ */
+static int
+append(Obj *obj, Follow *f, long size)
+{
+    long drop, more;
+    int got;
+    char *tmp;
+
+    if (f->size + size > f->max && f->size > 0) {
+	/* all of the text has to be indexed for the index to be
+	 * trimmed to match it
+	 */
+	_nd_textCount(obj);
+	drop = f->size - f->max/2;
+
+	if ((drop = _nd_textTrim(obj, drop)) == 0) {
+	    /* no checkpoints to trim at (a few very long lines), so
+	     * start over with the second half
+	     */
+	    drop = f->size - f->max/2;
+	    memmove(f->bfr, f->bfr + drop, f->size - drop);
+	    f->size -= drop;
+	    obj->item.text.topy = 0;
+	    _nd_textIndex(obj, f->size);
+	}
+	else
+	    f->size -= drop;
+    }
+
+    if (f->size + size > f->alloc) {
+	more = 2 * f->alloc;
+	if (more > f->max + size)
+	    more = f->max + size;
+	if (more < f->size + size)
+	    more = f->size + size;
+	if ((tmp = realloc(f->bfr, more)) == 0)
+	    return -1;
+	f->bfr = tmp;
+	f->alloc = more;
+    }
+
+    if ((got = read(f->fd, f->bfr + f->size, size)) > 0) {
+	f->size += got;
+	f->offset += got;
+    }
+    obj->content = f->bfr;
+    _nd_textGrow(obj, f->bfr, f->size);
+    return got;
+} /* append */
+
+
+/*
+ * ready() tells whether there's anything waiting to be read from a
+ * stream
+ */
+static int
+ready(Follow *f)
+{
+    struct pollfd pfd;
+
+    pfd.fd = f->fd;
+    pfd.events = POLLIN;
+    return poll(&pfd, 1, 0) > 0;
+} /* ready */
+
+
+/*
+ * slurp() reads whatever has been added to the file since we last
+ * looked at it, and returns nonzero if there was anything
+ */
+static int
+slurp(Obj *obj, Follow *f)
+{
+    struct stat st;
+    long total = 0;
+    int got;
+
+    if (f->path == 0) {
+	while (total < TF_SLURP && ready(f)) {
+	    if ((got = append(obj, f, TF_READ)) <= 0) {
+		f->eof = 1;
+		break;
+	    }
+	    total += got;
+	}
+	return total > 0;
+    }
+
+    /* if the file's been replaced, finish reading the old one before
+     * going on to the new one
+     */
+    if (replaced(f)) {
+	while (total < TF_SLURP && (got = append(obj, f, TF_READ)) > 0)
+	    total += got;
+	if (total >= TF_SLURP || reopen(f) != 0)
+	    return total > 0;
+    }
+    if (fstat(f->fd, &st) != 0)
+	return total > 0;
+
+    if (st.st_size < f->offset) {
+	/* truncated;  start reading it again from the top */
+	lseek(f->fd, 0, SEEK_SET);
+	f->offset = 0;
+    }
+
+    while (f->offset < st.st_size && total < TF_SLURP) {
+	if ((got = append(obj, f, TF_READ)) <= 0)
+	    break;
+	total += got;
+    }
+    return total > 0;
+} /* slurp */
+
+
+/*
+ * tf_follow() is the form timer that looks for more text
+ */
+static int
+tf_follow(void *form, void *o)
+{
+    Obj *obj = OBJ(o);
+    Follow *f = TF(obj);
+    int pinned;
+
+    if (f == 0 || f->form != form || f->eof)
+	return 1;
+
+    if (f->path ? (quiet(f) && !replaced(f)) : !ready(f))
+	return 0;
+
+    /* only scroll down if we were already at the bottom */
+    _nd_textCount(obj);
+    pinned = obj->item.text.topy + obj->depth >= obj->item.text.nrlines;
+
+    if (slurp(obj, f)) {
+	_nd_textCount(obj);
+	if (pinned && obj->item.text.nrlines > obj->depth)
+	    obj->item.text.topy = obj->item.text.nrlines - obj->depth;
+	touchObj(obj);
+    }
+    return f->eof;
+} /* tf_follow */
+
+
+/*
+ * _nd_textFollow() starts following the file from a timer on the form
+ * the text box is drawn on
+ */
+void
+_nd_textFollow(Obj *obj, void *form)
+{
+    Follow *f = TF(obj);
+
+    if (f == 0 || form == 0 || f->eof)
+	return;
+    if (f->form == form && _nd_formTimer(form, f->timer))
+	return;
+    if ((f->timer = addFormTimer(form, f->path ? TF_POLL : TF_STREAM, 1,
+					tf_follow, obj)) >= 0)
+	f->form = form;
+} /* _nd_textFollow */
+
+
+/*
+ * freeFollow() closes the file and throws the text away
+ */
+static void
+freeFollow(Follow *f)
+{
+    if (f->fd >= 0)
+	close(f->fd);
+    if (f->ifd >= 0)
+	close(f->ifd);
+    if (f->path)
+	free(f->path);
+    if (f->bfr)
+	free(f->bfr);
+    free(f);
+} /* freeFollow */
+
+
+/*
+ * _nd_followFree() stops following a file
+ */
+void
+_nd_followFree(Obj *obj)
+{
+    if (TF(obj)) {
+	freeFollow(TF(obj));
+	obj->item.text.extra = 0;
+    }
+} /* _nd_followFree */
+
+
+/*
+ * newFollow() sets up the buffer for a following text box
+ */
+static Follow *
+newFollow(long maxsize)
+{
+    Follow *f;
+
+    if ((f = calloc(1, sizeof *f)) == 0)
+	return 0;
+    f->fd = f->ifd = f->wd = -1;
+    f->max = (maxsize > 0) ? maxsize : TF_MAX;
+    if (f->max < 2*TF_READ)
+	f->max = 2*TF_READ;
+
+    if ((f->bfr = malloc(TF_READ)) == 0) {
+	free(f);
+	return 0;
+    }
+    f->alloc = TF_READ;
+    f->bfr[0] = 0;
+    return f;
+} /* newFollow */
+
+
+/*
+ * followText() creates the (empty) text box for a Follow
+ */
+static Obj *
+followText(int x, int y, int width, int depth, Follow *f,
+	   char *prompt, char *prefix, pfo callback, char *help)
+{
+    Obj *tmp;
+
+    tmp = newText(x, y, width, depth, 1, prompt, prefix, f->bfr,
+		  callback, help);
+    if (tmp) {
+	tmp->item.text.class = T_IS_FOLLOW;
+	tmp->item.text.extra = f;
+    }
+    return tmp;
+} /* followText */
+
+
+/*
+ * newTailText() creates a text box that shows the end of a file and
+ * follows it as it grows
+ */
+void *
+newTailText(int x, int y, int width, int depth, char *file, long maxsize,
+	    char *prompt, char *prefix, pfo callback, char *help)
+{
+    Follow *f;
+    Obj *tmp;
+    struct stat st;
+    char *p;
+    long drop;
+
+    if (file == 0) {
+	errno = EINVAL;
+	return 0;
+    }
+
+    if ((f = newFollow(maxsize)) == 0)
+	return 0;
+#if HAVE_SYS_INOTIFY_H
+    f->ifd = inotify_init1(IN_NONBLOCK|IN_CLOEXEC);
+#endif
+
+    if ((f->path = strdup(file)) == 0 || reopen(f) != 0
+	|| (tmp = followText(x, y, width, depth, f, prompt, prefix,
+			     callback, help)) == 0) {
+	freeFollow(f);
+	return 0;
+    }
+
+    /* start with the last half buffer of the file, less the piece of
+     * a line at the start of it
+     */
+    if (fstat(f->fd, &st) == 0 && st.st_size > f->max/2) {
+	f->offset = lseek(f->fd, st.st_size - f->max/2, SEEK_SET);
+	slurp(tmp, f);
+	if ((p = memchr(f->bfr, '\n', f->size)) != 0) {
+	    drop = (p+1) - f->bfr;
+	    memmove(f->bfr, p+1, f->size - drop);
+	    f->size -= drop;
+	    _nd_textIndex(tmp, f->size);
+	}
+    }
+    else
+	slurp(tmp, f);
+
+    setTextCursor(tmp, -1);
+    return tmp;
+} /* newTailText */
+
+
+/*
+ * newStreamText() creates a text box that shows what it reads from fd
+ * (which it closes when it's deleted) as the text arrives
+ */
+void *
+newStreamText(int x, int y, int width, int depth, int fd, long maxsize,
+	      char *prompt, char *prefix, pfo callback, char *help)
+{
+    Follow *f;
+    Obj *tmp;
+
+    if (fd < 0) {
+	errno = EBADF;
+	return 0;
+    }
+
+    if ((f = newFollow(maxsize)) == 0)
+	return 0;
+    if ((tmp = followText(x, y, width, depth, f, prompt, prefix,
+			  callback, help)) == 0) {
+	freeFollow(f);
+	return 0;
+    }
+    f->fd = fd;
+
+    /* whatever's already there, but don't wait for more */
+    slurp(tmp, f);
+    return tmp;
+} /* newStreamText */
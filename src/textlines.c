@@ -0,0 +1,419 @@
+/*
+ * textlines: find the lines in the text of a text object
+ *
+ * Copyright (C) 1996-2017 David L Parsons.
+ * The redistribution terms are provided in the COPYRIGHT file that must
+ * be distributed with this source code.
+ */
+#include <config.h>
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "curse.h"
+#include "ndwin.h"
+#include "nd_objects.h"
+
+/* A text object doesn't keep a pointer to every line in its text;  a
+ * text box on a multi-gigabyte log would spend seconds finding them
+ * all (and 8 bytes a line remembering them) before it could show the
+ * first screen.  Instead the text is indexed as far as it's been looked
+ * at, a chunk at a time, and only the start of every TL_STEPth line is
+ * kept.  A line is found by going to the checkpoint before it and
+ * memchr()ing forward, or (when the rows on the screen are drawn one
+ * after the other) by going on from the last line that was looked up.
+ *
+ * item.text.nrlines is how many lines have been indexed so far, and
+ * item.text.width is the width of the widest of them.
+ *
+ * Once a text box has been drawn on a form, the rest of the text is
+ * indexed from a form timer, a slice at a time, so that by the time
+ * anyone asks for the end of it (or how far down they are) the answer
+ * is usually already there.
+ */
+#define TL_STEP		64		/* lines between checkpoints */
+#define TL_CHUNK	(64*1024)	/* bytes to index at a time */
+#define TL_SLICE	(4*1024*1024)	/* ... or from a timer */
+#define TL_TICK		1		/* msec between timer slices */
+
+typedef struct {
+    char *text;			/* the text */
+    char *end;			/* ... and the end of it */
+    long *mark;			/* where every TL_STEPth line starts */
+    int nrmarks;
+    int szmarks;
+    char *scan;			/* where indexing stopped */
+    int complete;		/* it's all been indexed */
+    int line;			/* the last line looked up */
+    char *at;			/* ... and where it starts */
+    void *form;			/* the form we're indexing from */
+    int timer;			/* ... and the timer we're doing it with */
+} Index;
+
+#define IX(o)	((Index*)((o)->item.text.index))
+
+
+/*
+ * _nd_textFree() throws away a text object's line index
+ */
+void
+_nd_textFree(Obj *obj)
+{
+    Index *ix = IX(obj);
+
+    if (ix) {
+	if (ix->mark)
+	    free(ix->mark);
+	free(ix);
+	obj->item.text.index = 0;
+    }
+} /* _nd_textFree */
+
+
+/*
+ * _nd_textIndex() starts a new line index for a text object that
+ * contains size bytes of text (or, if size is negative, a string) and
+ * indexes the first chunk of it, which is all there is to most texts.
+ */
+int
+_nd_textIndex(Obj *obj, long size)
+{
+    Index *ix = IX(obj);
+    void *form = 0;
+    int timer = 0;
+
+    /* if the old text was still being indexed from a timer, the timer
+     * will pick up the new text, so hang on to the form it's on
+     */
+    if (ix) {
+	form = ix->form;
+	timer = ix->timer;
+	_nd_textFree(obj);
+    }
+    obj->item.text.nrlines = 0;
+    obj->item.text.width = 0;
+
+    if ((ix = calloc(1, sizeof *ix)) == 0)
+	return -1;
+    ix->form = form;
+    ix->timer = timer;
+
+    ix->text = (char*)(obj->content);
+    ix->end = ix->text + ((size < 0) ? strlen(ix->text) : size);
+
+    /* a null on the end isn't another line */
+    while (ix->end > ix->text && ix->end[-1] == 0)
+	--ix->end;
+    ix->scan = ix->at = ix->text;
+    obj->item.text.index = ix;
+    _nd_searchReset(obj);
+
+    return _nd_textLines(obj, 1);
+} /* _nd_textIndex */
+
+
+/*
+ * indexText() indexes the text until at least want lines are known and
+ * at least size more bytes have been looked at (or it's all indexed),
+ * and returns how many lines are known.
+ */
+static int
+indexText(Obj *obj, int want, long size)
+{
+    Index *ix = IX(obj);
+    T_Obj *t = &(obj->item.text);
+    char *p, *stop;
+    int width;
+
+    if (ix == 0 || ix->complete)
+	return t->nrlines;
+
+    stop = (ix->end - ix->scan > size) ? ix->scan + size : ix->end;
+
+    while (ix->scan < ix->end && (t->nrlines < want || ix->scan < stop)) {
+	if (t->nrlines % TL_STEP == 0) {
+	    if (ix->nrmarks >= ix->szmarks) {
+		int more = ix->szmarks ? 2*ix->szmarks : 256;
+		long *tmp = realloc(ix->mark, more * sizeof ix->mark[0]);
+
+		if (tmp == 0)
+		    return t->nrlines;
+		ix->mark = tmp;
+		ix->szmarks = more;
+	    }
+	    ix->mark[ix->nrmarks++] = ix->scan - ix->text;
+	}
+
+	if ((p = memchr(ix->scan, '\n', ix->end - ix->scan)) == 0)
+	    p = ix->end;
+
+	if ((width = p - ix->scan) > t->width)
+	    t->width = width;
+	t->nrlines++;
+	ix->scan = (p < ix->end) ? p+1 : p;
+    }
+    if (ix->scan >= ix->end)
+	ix->complete = 1;
+    return t->nrlines;
+} /* indexText */
+
+
+/*
+ * _nd_textLines() indexes the text until at least want lines (or all of
+ * them) are known, and returns how many are.
+ */
+int
+_nd_textLines(Obj *obj, int want)
+{
+    /* a chunk at a time, so scrolling a line at a time doesn't mean
+     * indexing a line at a time
+     */
+    if (obj->item.text.nrlines >= want)
+	return obj->item.text.nrlines;
+    return indexText(obj, want, TL_CHUNK);
+} /* _nd_textLines */
+
+
+/*
+ * _nd_textCount() indexes all of the text, and returns how many lines
+ * there are
+ */
+int
+_nd_textCount(Obj *obj)
+{
+    Index *ix = IX(obj);
+    int count;
+
+    while (ix && !ix->complete) {
+	count = obj->item.text.nrlines;
+	if (indexText(obj, count+1, TL_SLICE) == count)
+	    break;	/* out of memory */
+    }
+    return obj->item.text.nrlines;
+} /* _nd_textCount */
+
+
+/*
+ * tl_index() is the form timer that indexes the text a slice at a time,
+ * and redraws the text box (which can now say how far down it is) when
+ * it's done.
+ */
+static int
+tl_index(void *form, void *o)
+{
+    Obj *obj = OBJ(o);
+    Index *ix = IX(obj);
+
+    if (ix == 0 || ix->form != form)
+	return 1;
+
+    indexText(obj, 0, TL_SLICE);
+    if (!ix->complete)
+	return 0;
+
+    ix->form = 0;
+    touchObj(obj);
+    return 1;
+} /* tl_index */
+
+
+/*
+ * _nd_textBackground() starts indexing the rest of the text from a
+ * timer on the form that the text box is drawn on
+ */
+void
+_nd_textBackground(Obj *obj, void *form)
+{
+    Index *ix = IX(obj);
+
+    if (ix == 0 || ix->complete || form == 0)
+	return;
+    if (ix->form == form && _nd_formTimer(form, ix->timer))
+	return;
+    if ((ix->timer = addFormTimer(form, TL_TICK, 1, tl_index, obj)) >= 0)
+	ix->form = form;
+} /* _nd_textBackground */
+
+
+/*
+ * _nd_textDone() tells whether all of the text has been indexed
+ */
+int
+_nd_textDone(Obj *obj)
+{
+    Index *ix = IX(obj);
+
+    return ix == 0 || ix->complete;
+} /* _nd_textDone */
+
+
+/*
+ * _nd_textGrow() tells the index that more text has been put on the
+ * end, and that the text (which might have been moved) is now at text
+ * and is size bytes long
+ */
+void
+_nd_textGrow(Obj *obj, char *text, long size)
+{
+    Index *ix = IX(obj);
+    char *p;
+
+    if (ix == 0)
+	return;
+
+    ix->scan = text + (ix->scan - ix->text);
+    ix->at = text + (ix->at - ix->text);
+    ix->end = text + (ix->end - ix->text);
+    ix->text = text;
+
+    /* if the last line didn't have a newline on the end, it isn't the
+     * last line any more, so forget about it
+     */
+    if (ix->complete && ix->end > ix->text && ix->end[-1] != '\n') {
+	for (p = ix->end; p > ix->text && p[-1] != '\n'; --p)
+	    ;
+	ix->scan = p;
+	if (--obj->item.text.nrlines % TL_STEP == 0)
+	    --ix->nrmarks;
+    }
+
+    ix->end = text + size;
+    ix->complete = (ix->scan >= ix->end);
+    _nd_searchGrow(obj);
+} /* _nd_textGrow */
+
+
+/*
+ * _nd_textTrim() throws away (up to) the first size bytes of the text,
+ * moving the rest of it down to take their place, and returns how many
+ * bytes it threw away.  Only whole blocks of lines between checkpoints
+ * are thrown away, so the index just has to be shifted down to match.
+ */
+long
+_nd_textTrim(Obj *obj, long size)
+{
+    Index *ix = IX(obj);
+    T_Obj *t = &(obj->item.text);
+    int lo, hi, mid, i;
+    long off;
+
+    if (ix == 0 || ix->nrmarks < 2)
+	return 0;
+
+    /* find the last checkpoint at or before size */
+    for (lo = 0, hi = ix->nrmarks; hi - lo > 1; ) {
+	mid = (lo + hi) / 2;
+	if (ix->mark[mid] <= size)
+	    lo = mid;
+	else
+	    hi = mid;
+    }
+    if (lo == 0)
+	return 0;
+
+    off = ix->mark[lo];
+    memmove(ix->text, ix->text + off, (ix->end - ix->text) - off);
+    for (i = lo; i < ix->nrmarks; i++)
+	ix->mark[i-lo] = ix->mark[i] - off;
+    ix->nrmarks -= lo;
+
+    t->nrlines -= lo * TL_STEP;
+    if ((t->topy -= lo * TL_STEP) < 0)
+	t->topy = 0;
+
+    ix->end -= off;
+    ix->scan -= off;
+    ix->line = 0;
+    ix->at = ix->text;
+    _nd_searchTrim(obj, off);
+    return off;
+} /* _nd_textTrim */
+
+
+/*
+ * _nd_textSize() returns how many bytes of text there are
+ */
+long
+_nd_textSize(Obj *obj)
+{
+    Index *ix = IX(obj);
+
+    return ix ? (ix->end - ix->text) : 0;
+} /* _nd_textSize */
+
+
+/*
+ * _nd_textLineAt() returns the line that the byte at offset is on
+ */
+int
+_nd_textLineAt(Obj *obj, long offset)
+{
+    Index *ix = IX(obj);
+    int lo, hi, mid, line;
+    char *p, *q, *at;
+
+    if (ix == 0 || offset < 0)
+	return 0;
+
+    while (!ix->complete && ix->scan - ix->text <= offset) {
+	p = ix->scan;
+	indexText(obj, 0, TL_CHUNK);
+	if (ix->scan == p)
+	    break;	/* out of memory */
+    }
+    if (ix->nrmarks == 0)
+	return 0;
+
+    /* from the last checkpoint at or before it */
+    for (lo = 0, hi = ix->nrmarks; hi - lo > 1; ) {
+	mid = (lo + hi) / 2;
+	if (ix->mark[mid] <= offset)
+	    lo = mid;
+	else
+	    hi = mid;
+    }
+    line = lo * TL_STEP;
+    at = ix->text + offset;
+    for (p = ix->text + ix->mark[lo]; (q = memchr(p, '\n', at - p)) != 0; p = q+1)
+	line++;
+    return line;
+} /* _nd_textLineAt */
+
+
+/*
+ * _nd_textLine() returns the start of a line (and, if len isn't null,
+ * how long it is), or 0 if there isn't one
+ */
+char *
+_nd_textLine(Obj *obj, int line, int *len)
+{
+    Index *ix = IX(obj);
+    int at;
+    char *p, *q;
+
+    if (ix == 0 || line < 0 || line >= _nd_textLines(obj, line+1))
+	return 0;
+
+    /* walk from the checkpoint, unless the last line we looked up is
+     * between it and this one
+     */
+    at = line - (line % TL_STEP);
+    if (ix->line >= at && ix->line <= line) {
+	at = ix->line;
+	p = ix->at;
+    }
+    else
+	p = ix->text + ix->mark[line / TL_STEP];
+
+    for ( ; at < line; at++)
+	p = 1 + (char*)memchr(p, '\n', ix->end - p);
+
+    if (len) {
+	if ((q = memchr(p, '\n', ix->end - p)) == 0)
+	    q = ix->end;
+	*len = q - p;
+    }
+    ix->line = line;
+    return ix->at = p;
+} /* _nd_textLine */
@@ -0,0 +1,715 @@
+/*
+ * textsearch: search the text in text and help boxes
+ *
+ * Copyright (C) 1996-2017 David L Parsons.
+ * The redistribution terms are provided in the COPYRIGHT file that must
+ * be distributed with this source code.
+ */
+#include <config.h>
+
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "curse.h"
+#include "ndwin.h"
+#include "nd_objects.h"
+#include "bytecodes.h"
+
+/* Typing / (or ?) in a text box starts a search forwards (or backwards);
+ * the query is typed on the bottom of the frame, and RETURN starts it.
+ * After that, n goes to the next match and N to the one before it (or,
+ * after a ?, the other way around.)  A query without any capital letters
+ * in it ignores case.
+ *
+ * A search builds an index of where the matches are, from the top of the
+ * text down:  a slice at a time from a form timer, and further on demand
+ * when n, N, or drawing the box needs it to go further.  Once the index
+ * covers a piece of the text, the next match there is the next entry in
+ * it, and the matches on the screen are highlighted by looking them up.
+ * The index stops growing after TS_MAXHITS matches;  past that n still
+ * works, by searching the text directly, but nothing is highlighted.
+ *
+ * The text is searched by memchr()ing for the first letter of the query
+ * (in both cases, if case is being ignored) and comparing the rest.  In
+ * a help page, matches skip over the bytecodes the renderer put in for
+ * fonts, indents, and links, so what's matched is what's on the screen.
+ */
+#define TS_MAX		80		/* the longest query */
+#define TS_SLICE	(4*1024*1024)	/* bytes to search at a time */
+#define TS_TICK		1		/* msec between timer slices */
+#define TS_MAXHITS	(1024*1024)	/* the most matches to index */
+
+typedef struct {
+    long at;			/* where a match starts */
+    long end;			/* ... and where it ends */
+} Hit;
+
+typedef struct {
+    long from;			/* the last memchr() went from here */
+    long to;			/* ... to here */
+    long at;			/* ... and found it here (or at to) */
+} Seen;
+
+typedef struct {
+    char query[TS_MAX+1];	/* what we're looking for */
+    int len;
+    int fold;			/* ignore case */
+    int backward;		/* it was a ? search */
+    char typed[TS_MAX+2];	/* the query being typed, after the / or ? */
+    int typing;
+    int failed;			/* the last search didn't find anything */
+    Hit *hit;			/* the index */
+    int nrhits;
+    int szhits;
+    long scanned;		/* how far into the text it goes */
+    int full;			/* TS_MAXHITS matches, so it's stopped */
+    int cur;			/* the current match in the index, or -1 */
+    long curat;			/* where the current match is, or -1 */
+    int draw;			/* the next match to highlight */
+    Seen seen[2];		/* where the first letter was last seen */
+    void *form;			/* the form we're indexing from */
+    int timer;			/* ... and the timer we're doing it with */
+} Search;
+
+#define TS(o)	((Search*)((o)->item.text.search))
+#define TEXT(o)	((char*)((o)->content))
+
+
+/*
+ * _nd_searchReset() throws away the match index (because the text has
+ * changed), but remembers the query
+ */
+void
+_nd_searchReset(Obj *obj)
+{
+    Search *s = TS(obj);
+
+    if (s) {
+	s->nrhits = 0;
+	s->scanned = 0;
+	s->full = 0;
+	s->cur = -1;
+	s->curat = -1;
+	s->draw = 0;
+	s->seen[0].to = s->seen[1].to = -1;
+    }
+} /* _nd_searchReset */
+
+
+/*
+ * _nd_searchGrow() tells the index that more text has been put on the
+ * end, so a match that was cut off at the old end might be there now
+ */
+void
+_nd_searchGrow(Obj *obj)
+{
+    Search *s = TS(obj);
+    long back;
+
+    if (s == 0 || s->full || s->len == 0)
+	return;
+
+    back = s->scanned - (s->len-1);
+    if (s->nrhits > 0 && back < s->hit[s->nrhits-1].end)
+	back = s->hit[s->nrhits-1].end;
+    if (back < s->scanned)
+	s->scanned = (back > 0) ? back : 0;
+} /* _nd_searchGrow */
+
+
+/*
+ * _nd_searchTrim() tells the index that the first size bytes of the
+ * text have been thrown away
+ */
+void
+_nd_searchTrim(Obj *obj, long size)
+{
+    Search *s = TS(obj);
+    int i, gone;
+
+    if (s == 0)
+	return;
+
+    for (gone = 0; gone < s->nrhits && s->hit[gone].at < size; gone++)
+	;
+    for (i = gone; i < s->nrhits; i++) {
+	s->hit[i-gone].at = s->hit[i].at - size;
+	s->hit[i-gone].end = s->hit[i].end - size;
+    }
+    s->nrhits -= gone;
+
+    if ((s->scanned -= size) < 0)
+	s->scanned = 0;
+    s->cur = (s->cur >= gone) ? s->cur - gone : -1;
+    if ((s->curat -= size) < 0)
+	s->curat = -1;
+    s->draw = 0;
+    s->seen[0].to = s->seen[1].to = -1;
+} /* _nd_searchTrim */
+
+
+/*
+ * _nd_searchFree() throws away the search
+ */
+void
+_nd_searchFree(Obj *obj)
+{
+    Search *s = TS(obj);
+
+    if (s) {
+	if (s->hit)
+	    free(s->hit);
+	free(s);
+	obj->item.text.search = 0;
+    }
+} /* _nd_searchFree */
+
+
+/*
+ * same() compares two characters, ignoring case if we have to
+ */
+static int
+same(Search *s, int a, int b)
+{
+    if (s->fold)
+	return tolower(a) == tolower(b);
+    return a == b;
+} /* same */
+
+
+/*
+ * look() finds the next c between p and limit (or returns limit), going
+ * on from the last time it looked if it can;  there can be a lot of
+ * matches between one of the first letter and the next (if it's a capital
+ * that isn't in the text, all of them) and looking from each one to the
+ * next would go over the same text again and again.
+ */
+static char *
+look(char *text, Seen *seen, int c, char *p, char *limit)
+{
+    char *q;
+
+    if (seen->to != limit - text || seen->from > p - text
+				 || seen->at < p - text) {
+	if ((q = memchr(p, c, limit - p)) == 0)
+	    q = limit;
+	seen->from = p - text;
+	seen->to = limit - text;
+	seen->at = q - text;
+    }
+    return text + seen->at;
+} /* look */
+
+
+/*
+ * plainFind() finds the first match that starts between p and limit,
+ * and sets *after to where it ends
+ */
+static char *
+plainFind(Search *s, char *text, char *p, char *limit, char *end, char **after)
+{
+    int lc = (unsigned char)(s->query[0]);
+    int uc = s->fold ? toupper(lc) : lc;
+    char *q, *b;
+    int i;
+
+    while (p < limit) {
+	/* the next place either case of the first letter is */
+	q = look(text, &s->seen[0], lc, p, limit);
+	if (uc != lc && (b = look(text, &s->seen[1], uc, p, limit)) < q)
+	    q = b;
+
+	if (q >= limit)
+	    break;
+	if (end - q >= s->len) {
+	    for (i = 1; i < s->len; i++)
+		if (!same(s, (unsigned char)q[i], (unsigned char)s->query[i]))
+		    break;
+	    if (i == s->len) {
+		*after = q + s->len;
+		return q;
+	    }
+	}
+	p = q+1;
+    }
+    return 0;
+} /* plainFind */
+
+
+/*
+ * htmlNext() finds the next character on a help page that's shown on
+ * the screen, skipping over the bytecodes, and sets *c to it and *after
+ * to where the one after it starts
+ */
+static char *
+htmlNext(char *p, char *end, int *c, char **after)
+{
+    unsigned char *u;
+
+    while (p < end) {
+	u = (unsigned char*)p;
+
+	if (*u == DLE)			/* indent */
+	    p += 2;
+	else if (*u == bcfID || *u == bctID) {
+	    if (p+1 < end && u[1] == *u) {	/* doubled;  it's itself */
+		*c = *u;
+		*after = p+2;
+		return p;
+	    }
+	    if (*u == bcfID)		/* font change */
+		p += 2;
+	    else if ((p = memchr(p+1, bctID, (end-p)-1)) != 0)
+		++p;			/* tag */
+	    else
+		p = end;
+	}
+	else {
+	    *c = *u;
+	    *after = p+1;
+	    return p;
+	}
+    }
+    return 0;
+} /* htmlNext */
+
+
+/*
+ * htmlFind() finds the first match on a help page that starts between
+ * p and limit, and sets *after to where it ends
+ */
+static char *
+htmlFind(Search *s, char *p, char *limit, char *end, char **after)
+{
+    char *start, *next;
+    int c, i;
+
+    while ((start = htmlNext(p, end, &c, &p)) != 0 && start < limit) {
+	for (i = 0, next = p; same(s, c, (unsigned char)s->query[i]); ) {
+	    if (++i == s->len) {
+		*after = next;
+		return start;
+	    }
+	    if (htmlNext(next, end, &c, &next) == 0)
+		break;
+	}
+    }
+    return 0;
+} /* htmlFind */
+
+
+/*
+ * find() finds the first match that starts between p and limit
+ */
+static char *
+find(Obj *obj, Search *s, char *p, char *limit, char **after)
+{
+    char *text = TEXT(obj);
+    char *end = text + _nd_textSize(obj);
+
+    if (obj->item.text.class == T_IS_HTML)
+	return htmlFind(s, p, limit, end, after);
+    return plainFind(s, text, p, limit, end, after);
+} /* find */
+
+
+/*
+ * extend() searches up to size more bytes of the text for matches and
+ * puts them in the index
+ */
+static void
+extend(Obj *obj, Search *s, long size)
+{
+    char *text = TEXT(obj);
+    long len = _nd_textSize(obj);
+    char *p, *limit, *m, *after;
+    Hit *tmp;
+    int more;
+
+    if (s->full || s->len == 0 || s->scanned >= len)
+	return;
+
+    /* help pages aren't big, and a slice might end in the middle of
+     * a bytecode, so they're done all at once
+     */
+    if (obj->item.text.class == T_IS_HTML || len - s->scanned <= size)
+	limit = text + len;
+    else
+	limit = text + s->scanned + size;
+
+    for (p = text + s->scanned; (m = find(obj, s, p, limit, &after)) != 0; p = after) {
+	if (s->nrhits >= s->szhits) {
+	    more = s->szhits ? 2*s->szhits : 64;
+	    if (more > TS_MAXHITS || (tmp = realloc(s->hit, more * sizeof *tmp)) == 0) {
+		s->full = 1;
+		s->scanned = m - text;
+		return;
+	    }
+	    s->hit = tmp;
+	    s->szhits = more;
+	}
+	s->hit[s->nrhits].at = m - text;
+	s->hit[s->nrhits].end = after - text;
+	s->nrhits++;
+    }
+    /* (a match can go past the limit) */
+    s->scanned = ((p > limit) ? p : limit) - text;
+} /* extend */
+
+
+/*
+ * ts_index() is the form timer that indexes the matches a slice at a time
+ */
+static int
+ts_index(void *form, void *o)
+{
+    Obj *obj = OBJ(o);
+    Search *s = TS(obj);
+
+    if (s == 0 || s->form != form)
+	return 1;
+
+    extend(obj, s, TS_SLICE);
+    if (!s->full && s->len > 0 && s->scanned < _nd_textSize(obj))
+	return 0;
+
+    s->form = 0;
+    return 1;
+} /* ts_index */
+
+
+/*
+ * firstAt() returns the first match in the index that starts at or after
+ * offset (or nrhits, if there aren't any)
+ */
+static int
+firstAt(Search *s, long offset)
+{
+    int lo, hi, mid;
+
+    /* n and N usually want the match next to the current one */
+    if (s->cur >= 0 && s->cur < s->nrhits) {
+	if (s->hit[s->cur].at >= offset
+		&& (s->cur == 0 || s->hit[s->cur-1].at < offset))
+	    return s->cur;
+	if (s->hit[s->cur].at < offset
+		&& (s->cur+1 == s->nrhits || s->hit[s->cur+1].at >= offset))
+	    return s->cur+1;
+    }
+
+    for (lo = 0, hi = s->nrhits; lo < hi; ) {
+	mid = (lo + hi) / 2;
+	if (s->hit[mid].at < offset)
+	    lo = mid+1;
+	else
+	    hi = mid;
+    }
+    return lo;
+} /* firstAt */
+
+
+/*
+ * forward() finds the first match at or after offset, and returns where
+ * it is, or -1
+ */
+static long
+forward(Obj *obj, Search *s, long offset)
+{
+    char *text = TEXT(obj), *m, *after;
+    long len = _nd_textSize(obj);
+    int ix;
+
+    while ((ix = firstAt(s, offset)) >= s->nrhits) {
+	if (s->full) {
+	    /* past the end of the index;  look for it ourselves */
+	    s->cur = -1;
+	    if (offset < s->scanned)
+		offset = s->scanned;
+	    m = find(obj, s, text + offset, text + len, &after);
+	    return m ? (m - text) : -1;
+	}
+	if (s->scanned >= len)
+	    return -1;
+	extend(obj, s, TS_SLICE);
+    }
+    s->cur = ix;
+    return s->hit[ix].at;
+} /* forward */
+
+
+/*
+ * backward() finds the last match before offset, and returns where it
+ * is, or -1
+ */
+static long
+backward(Obj *obj, Search *s, long offset)
+{
+    char *text = TEXT(obj), *m, *after, *p;
+    long at = -1;
+    int ix;
+
+    /* all of the matches before offset have to be in the index */
+    while (!s->full && s->scanned < offset && s->scanned < _nd_textSize(obj))
+	extend(obj, s, TS_SLICE);
+
+    if (s->full && s->scanned < offset) {
+	/* the index stops short, so look between it and offset */
+	for (p = text + s->scanned; (m = find(obj, s, p, text + offset, &after)) != 0; p = after)
+	    at = m - text;
+	if (at >= 0) {
+	    s->cur = -1;
+	    return at;
+	}
+    }
+
+    if ((ix = firstAt(s, offset) - 1) < 0)
+	return -1;
+    s->cur = ix;
+    return s->hit[ix].at;
+} /* backward */
+
+
+/*
+ * column() is where on the screen (tabs and all) the byte at offset is
+ */
+static int
+column(Obj *obj, int line, long offset)
+{
+    char *p = _nd_textLine(obj, line, 0);
+    char *at = TEXT(obj) + offset;
+    int x = 0;
+
+    for ( ; p && p < at; ++p)
+	x = (*p == '\t') ? (x + 8) & ~7 : x + 1;
+    return x;
+} /* column */
+
+
+/*
+ * show() scrolls the text box so that the match at offset is showing
+ */
+static void
+show(Obj *obj, long offset)
+{
+    T_Obj *t = &(obj->item.text);
+    int line = _nd_textLineAt(obj, offset);
+    int x;
+
+    if (line < t->topy || line >= t->topy + obj->depth) {
+	/* put it a third of the way down */
+	t->topy = line - obj->depth/3;
+	if (_nd_textLines(obj, t->topy + obj->depth) < t->topy + obj->depth)
+	    t->topy = t->nrlines - obj->depth;
+	if (t->topy < 0)
+	    t->topy = 0;
+    }
+
+    if (t->class != T_IS_HTML) {
+	x = column(obj, line, offset);
+	if (x < t->off_x || x + 1 > t->off_x + obj->width)
+	    t->off_x = (x > obj->width/2) ? x - obj->width/2 : 0;
+    }
+} /* show */
+
+
+/*
+ * go() goes to the next match in a direction, and redraws the box
+ */
+static void
+go(Obj *obj, void *w, int dir)
+{
+    Search *s = TS(obj);
+    char *line;
+    long at;
+
+    if (s->curat >= 0)
+	at = (dir > 0) ? forward(obj, s, s->curat+1) : backward(obj, s, s->curat);
+    else {
+	/* the first time, start from the top of the box (or the bottom
+	 * of it, going backwards)
+	 */
+	if (dir > 0)
+	    line = _nd_textLine(obj, obj->item.text.topy, 0);
+	else
+	    line = _nd_textLine(obj, obj->item.text.topy + obj->depth, 0);
+
+	if (line)
+	    at = line - TEXT(obj);
+	else		/* there's no text there (or none at all) */
+	    at = (dir > 0) ? 0 : _nd_textSize(obj);
+	at = (dir > 0) ? forward(obj, s, at) : backward(obj, s, at);
+    }
+
+    if (at < 0) {
+	s->failed = 1;
+	beep();
+    }
+    else {
+	s->failed = 0;
+	s->curat = at;
+	show(obj, at);
+    }
+    drawObj(obj, w);
+} /* go */
+
+
+/*
+ * start() starts a new search for what was typed
+ */
+static void
+start(Obj *obj, void *w)
+{
+    Search *s = TS(obj);
+    void *form = DISPLAY(w)->form;
+    int i;
+
+    strcpy(s->query, s->typed+1);
+    s->len = strlen(s->query);
+    s->backward = (s->typed[0] == '?');
+    for (s->fold = 1, i = 0; i < s->len; i++)
+	if (isupper((unsigned char)s->query[i]))
+	    s->fold = 0;
+    _nd_searchReset(obj);
+
+    /* index the rest of the matches in the background */
+    if (form && !(s->form == form && _nd_formTimer(form, s->timer))
+	     && (s->timer = addFormTimer(form, TS_TICK, 1, ts_index, obj)) >= 0)
+	s->form = form;
+
+    go(obj, w, s->backward ? -1 : 1);
+} /* start */
+
+
+/*
+ * _nd_searchKey() handles the search keys (and, while a query is being
+ * typed, every key) in a text box, and returns 1 if it did
+ */
+int
+_nd_searchKey(Obj *obj, void *w, int c)
+{
+    Search *s = TS(obj);
+    int len;
+
+    if (s && s->typing) {
+	len = strlen(s->typed);
+
+	switch (c) {
+	case '\r':
+	case '\n':  s->typing = 0;
+		    if (len > 1)
+			start(obj, w);
+		    break;
+	case ESCAPE:
+	case EOF:   s->typing = 0;
+		    break;
+	case KEY_BACKSPACE:
+	case '\b':
+	case '\177':s->typed[--len] = 0;
+		    if (len == 0)
+			s->typing = 0;
+		    break;
+	default:    if (c >= ' ' && c < 256 && c != '\177' && len <= TS_MAX) {
+			s->typed[len++] = c;
+			s->typed[len] = 0;
+		    }
+		    else
+			beep();
+		    break;
+	}
+	drawObj(obj, w);
+	return 1;
+    }
+
+    switch (c) {
+    case '/':
+    case '?':	if (s == 0) {
+		    if ((s = calloc(1, sizeof *s)) == 0)
+			return 0;
+		    obj->item.text.search = s;
+		    _nd_searchReset(obj);
+		}
+		s->typed[0] = c;
+		s->typed[1] = 0;
+		s->typing = 1;
+		s->failed = 0;
+		drawObj(obj, w);
+		return 1;
+
+    case 'n':
+    case 'N':	if (s == 0 || s->len == 0)
+		    return 0;
+		go(obj, w, ((c == 'n') != s->backward) ? 1 : -1);
+		return 1;
+    }
+    return 0;
+} /* _nd_searchKey */
+
+
+/*
+ * _nd_searchLine() gets ready to highlight the matches on a line (of
+ * len bytes) that's about to be drawn
+ */
+void
+_nd_searchLine(Obj *obj, char *line, int len)
+{
+    Search *s = TS(obj);
+    long at, end;
+
+    if (s == 0 || s->len == 0)
+	return;
+
+    at = line - TEXT(obj);
+    end = at + len;
+    while (!s->full && s->scanned < end && s->scanned < _nd_textSize(obj))
+	extend(obj, s, TS_SLICE);
+
+    s->draw = firstAt(s, at);
+    /* (firstAt() can't tell a match that starts on this line from one
+     * that's still going from before it, but matches don't cross lines)
+     */
+} /* _nd_searchLine */
+
+
+/*
+ * _nd_searchHit() tells whether the byte at p (on the line that's being
+ * drawn) is part of a match
+ */
+int
+_nd_searchHit(Obj *obj, char *p)
+{
+    Search *s = TS(obj);
+    long at;
+
+    if (s == 0 || s->len == 0)
+	return 0;
+
+    at = p - TEXT(obj);
+    while (s->draw < s->nrhits && s->hit[s->draw].end <= at)
+	s->draw++;
+    return s->draw < s->nrhits && s->hit[s->draw].at <= at;
+} /* _nd_searchHit */
+
+
+/*
+ * _nd_searchPrompt() returns what to show on the bottom of the frame:
+ * the query that's being typed, or that the last search didn't find
+ * anything
+ */
+char *
+_nd_searchPrompt(Obj *obj)
+{
+    static char bfr[TS_MAX+20];
+    Search *s = TS(obj);
+
+    if (s == 0)
+	return 0;
+    if (s->typing)
+	return s->typed;
+    if (s->failed) {
+	sprintf(bfr, "%c%s: not found", s->backward ? '?' : '/', s->query);
+	return bfr;
+    }
+    return 0;
+} /* _nd_searchPrompt */
@@ -0,0 +1,247 @@
+/*
+ * typeahead: hotkeys and incremental search for list objects
+ *
+ * Copyright (C) 1996-2017 David L Parsons.
+ * The redistribution terms are provided in the COPYRIGHT file that must
+ * be distributed with this source code.
+ */
+#include <config.h>
+
+#include "nd_objects.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/time.h>
+
+/* The first time someone presses a hotkey in a list, we build an index
+ * of the list:
+ *
+ *   the items sorted by their first letter (in list order inside each
+ *   letter), so pressing a letter again can step to the next item with
+ *   that letter without looking at any other items, and
+ *
+ *   the items sorted by their (case-folded) text, so typing several
+ *   letters quickly can binary search for the first item that starts
+ *   with all of them.
+ *
+ * The index is thrown away when the list is given new items.
+ */
+#define TYPEAHEAD_MS	750	/* keys closer than this build a prefix */
+#define TYPEAHEAD_MAX	40	/* the longest prefix we'll remember */
+
+typedef struct {
+    int first[257];	/* bucket[first[c]] .. bucket[first[c+1]-1] */
+    int *bucket;	/* item indexes, grouped by first letter */
+    int *slot;		/* where each item is in bucket[] */
+    int *sorted;	/* item indexes, sorted by text */
+    char typed[TYPEAHEAD_MAX+1];/* what's been typed so far */
+    int nrtyped;
+    struct timeval last;/* when the last key was typed */
+} Keys;
+
+#define L(o)		(OBJ(o)->item.list)
+#define KEY(o,i)	((OBJ(o)->flags & SHOW_IDS) ? L(o).items[i].id \
+						    : L(o).items[i].item)
+#define LETTER(s)	((s) ? toupper((unsigned char)(s)[0]) : 0)
+
+
+/*
+ * _nd_listKeysFree() throws away a list's hotkey index
+ */
+void
+_nd_listKeysFree(Obj *obj)
+{
+    Keys *k = (Keys*)(L(obj).keys);
+
+    if (k) {
+	if (k->bucket) free(k->bucket);
+	if (k->slot) free(k->slot);
+	if (k->sorted) free(k->sorted);
+	free(k);
+	L(obj).keys = 0;
+    }
+} /* _nd_listKeysFree */
+
+
+static Obj *sorting;	/* the list that bytext() is sorting */
+
+/*
+ * bytext() is the qsort() comparator for the sorted index;  items with
+ * the same text stay in list order.
+ */
+static int
+bytext(const void *a, const void *b)
+{
+    int ia = *(int*)a,
+	ib = *(int*)b;
+    char *ka = KEY(sorting, ia),
+	 *kb = KEY(sorting, ib);
+    int rc = strcasecmp(ka ? ka : "", kb ? kb : "");
+
+    return rc ? rc : (ia - ib);
+} /* bytext */
+
+
+/*
+ * buildKeys() builds the hotkey index for a list
+ */
+static Keys *
+buildKeys(Obj *obj)
+{
+    Keys *k;
+    int n = L(obj).nritems;
+    int ix, c;
+
+    if ((k = calloc(1, sizeof *k)) == 0)
+	return 0;
+
+    k->bucket = malloc(n * sizeof k->bucket[0]);
+    k->slot   = malloc(n * sizeof k->slot[0]);
+    k->sorted = malloc(n * sizeof k->sorted[0]);
+    L(obj).keys = k;
+
+    if (k->bucket == 0 || k->slot == 0 || k->sorted == 0) {
+	_nd_listKeysFree(obj);
+	return 0;
+    }
+
+    /* counting sort into first-letter buckets */
+    for (ix = 0; ix < n; ix++)
+	k->first[1 + LETTER(KEY(obj,ix))]++;
+    for (c = 0; c < 256; c++)
+	k->first[c+1] += k->first[c];
+    for (ix = 0; ix < n; ix++) {
+	c = LETTER(KEY(obj,ix));
+	k->bucket[k->first[c]++] = ix;
+    }
+    /* filling the buckets bumped every first[c] to the start of the
+     * next bucket; shift them back.
+     */
+    for (c = 256; c > 0; c--)
+	k->first[c] = k->first[c-1];
+    k->first[0] = 0;
+    for (ix = 0; ix < n; ix++)
+	k->slot[k->bucket[ix]] = ix;
+
+    for (ix = 0; ix < n; ix++)
+	k->sorted[ix] = ix;
+    sorting = obj;
+    qsort(k->sorted, n, sizeof k->sorted[0], bytext);
+    sorting = 0;
+
+    return k;
+} /* buildKeys */
+
+
+/*
+ * nextInBucket() finds the next item after cur that starts with c,
+ * wrapping around to the top of the list, or -1 if there aren't any.
+ */
+static int
+nextInBucket(Obj *obj, Keys *k, int c, int cur)
+{
+    int lo = k->first[c],
+	hi = k->first[c+1],
+	mid, end = hi;
+
+    if (lo == hi)
+	return -1;
+
+    if (cur >= 0 && cur < L(obj).nritems && LETTER(KEY(obj,cur)) == c) {
+	/* we're in the bucket already, so just step along it */
+	mid = k->slot[cur] + 1;
+	return k->bucket[(mid < end) ? mid : lo];
+    }
+
+    /* otherwise find the first item in the bucket after cur */
+    while (lo < hi) {
+	mid = (lo + hi) / 2;
+	if (k->bucket[mid] <= cur)
+	    lo = mid+1;
+	else
+	    hi = mid;
+    }
+    return k->bucket[(lo < end) ? lo : k->first[c]];
+} /* nextInBucket */
+
+
+/*
+ * findPrefix() finds the alphabetically first item that starts with
+ * prefix, or -1 if there isn't one.
+ */
+static int
+findPrefix(Obj *obj, Keys *k, char *prefix, int len)
+{
+    int lo = 0,
+	hi = L(obj).nritems,
+	mid;
+    char *key;
+
+    while (lo < hi) {
+	mid = (lo + hi) / 2;
+	key = KEY(obj, k->sorted[mid]);
+	if (strncasecmp(key ? key : "", prefix, len) < 0)
+	    lo = mid+1;
+	else
+	    hi = mid;
+    }
+    if (lo < L(obj).nritems) {
+	key = KEY(obj, k->sorted[lo]);
+	if (key && strncasecmp(key, prefix, len) == 0)
+	    return k->sorted[lo];
+    }
+    return -1;
+} /* findPrefix */
+
+
+/*
+ * _nd_listHotkey() handles a hotkey typed at a list, returning the item
+ * it takes us to, or -1.
+ *
+ * A key typed on its own (or after a pause) goes to the next item that
+ * starts with that letter.  Keys typed quickly one after another build
+ * up a prefix, and go to the first item that starts with all of them;
+ * typing the same letter over and over keeps stepping through the items
+ * that start with it.
+ */
+int
+_nd_listHotkey(Obj *obj, int c)
+{
+    Keys *k = (Keys*)(L(obj).keys);
+    struct timeval now;
+    long ms;
+    int ix, same;
+
+    if (L(obj).items == 0 || L(obj).nritems <= 0 || c <= 0 || c > 255)
+	return -1;
+
+    if (k == 0 && (k = buildKeys(obj)) == 0)
+	return -1;
+
+    gettimeofday(&now, 0);
+    ms = (now.tv_sec - k->last.tv_sec) * 1000
+       + (now.tv_usec - k->last.tv_usec) / 1000;
+    k->last = now;
+
+    if (ms < 0 || ms > TYPEAHEAD_MS)
+	k->nrtyped = 0;
+
+    for (same = 1, ix = 0; ix < k->nrtyped; ix++)
+	if (toupper((unsigned char)k->typed[ix]) != toupper(c))
+	    same = 0;
+
+    if (k->nrtyped > 0 && !same && k->nrtyped < TYPEAHEAD_MAX) {
+	k->typed[k->nrtyped++] = c;
+	k->typed[k->nrtyped] = 0;
+	if ((ix = findPrefix(obj, k, k->typed, k->nrtyped)) >= 0)
+	    return ix;
+    }
+
+    /* start over with just this key */
+    k->typed[0] = c;
+    k->typed[1] = 0;
+    k->nrtyped = 1;
+    return nextInBucket(obj, k, toupper(c), L(obj).cury);
+} /* _nd_listHotkey */
@@ -0,0 +1,704 @@
+/*
+ * virtual_list.c: a list whose rows come from a row provider
+ *
+ * Copyright (C) 1996-2017 David L Parsons.
+ * The redistribution terms are provided in the COPYRIGHT file that must
+ * be distributed with this source code.
+ */
+
+/*
+ * A list object wants all of its ListItems built before it's created,
+ * which is no good for a list with a million rows in it.  A virtual list
+ * only knows how many rows there are;  when it needs to draw a row it
+ * asks the row provider for it, and keeps the rows it's been given in a
+ * small ring of slots (the visible rows, plus VL_READAHEAD rows on either
+ * side so scrolling a line at a time only fetches one new row.)  Each
+ * slot only keeps as much of the row text as will fit in the list, so
+ * the whole thing costs memory proportional to the size of the list on
+ * the screen, not the size of the list.
+ */
+
+#include <config.h>
+
+#include "nd_objects.h"
+#include "curse.h"
+#include "dialog.h"
+#include "ndwin.h"
+#include "virtual_list.h"
+#include <ctype.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+
+#if DYNAMIC_BINDING
+
+#define DYN_STATIC	static
+
+DYN_STATIC void drawVirtualList(void *o, void *w);
+DYN_STATIC void deleteVirtualList(ndObject o);
+DYN_STATIC editCode editVirtualList(void* o, void* w, MEVENT *mev, editCode cc);
+DYN_STATIC editCode startVirtualList(void* o, void* w, MEVENT *mev, editCode cc);
+DYN_STATIC editCode keyVirtualList(void* o, void* w, int c);
+DYN_STATIC int getVirtualCursor(void *o);
+DYN_STATIC int setVirtualCursor(void *o, int row);
+
+static int listType = O_ERROR;
+#define W_VLIST	listType
+
+#else
+
+#Error "This widget won't work unless DYNAMIC_BINDING is set"
+
+#endif
+
+extern char rillyrillylongblankstring[];
+
+#define VL_READAHEAD	8	/* rows to keep on either side of the view */
+
+/* one slot in the row cache */
+typedef struct {
+    long row;		/* the row in this slot, or -1 */
+    int selected;	/* is the row selected? */
+    char *text;		/* the row text, clipped to the list width */
+} Vrow;
+
+/* our generic object class */
+typedef struct {
+    ndRowProvider rows;	/* where the rows come from */
+    void *ctx;		/* .. and what to pass to the provider */
+    long nrrows;	/* how many rows there are */
+    long topy;		/* first row visible on the list */
+    long cury;		/* the current row */
+    int nrslots;	/* size of the row cache */
+    Vrow *slot;		/* the row cache */
+    char *text;		/* space for the slot text */
+    int textwidth;	/* .. and how much each slot gets */
+    int itemoffset;	/* where the row text starts in the list */
+    enum LO_format kind;/* how to show selected rows */
+    int cursor;		/* cursor visibility to restore when we leave */
+} Vlist;
+
+#define VL(o)	((Vlist*)(OBJ(o)->item.generic))
+
+
+/*
+ * newVirtualList() creates a virtual list.  Unlike newList(), the width
+ * and depth have to be given, because it would take a trip through every
+ * row in the list to work them out.
+ */
+ndObject
+newVirtualList(int x, int y, int width, int depth, long nrrows,
+	       ndRowProvider *rows, void *ctx, char *prompt, char *prefix,
+	       int flags, pfo callback, char *help)
+{
+    Obj *tmp;
+    Vlist *local;
+    int ix;
+
+    if (width < 1 || depth < 1 || nrrows < 0 || rows == 0
+				      || rows->fetch == 0) {
+	errno = EINVAL;
+	return 0;
+    }
+    /* the list doesn't keep selections itself (a row is forgotten as
+     * soon as it scrolls out of the ring), so a checklist or highlight
+     * list has to have somewhere to put them
+     */
+    if ((flags & LO_SELECTION_MASK) != MENU_SELECTION && rows->select == 0) {
+	errno = EINVAL;
+	return 0;
+    }
+
+#if DYNAMIC_BINDING
+    if (W_VLIST == O_ERROR) {
+	static struct _nd_object_table t = { 0, (nd_edit)editVirtualList,
+						(nd_draw)drawVirtualList,
+						(nd_free)deleteVirtualList,
+						0, 0,
+						(nd_getp)getVirtualCursor,
+						(nd_setp)setVirtualCursor,
+						(nd_start)startVirtualList,
+						(nd_key)keyVirtualList } ;
+	W_VLIST = nd_register_objtab(sizeof t, &t);
+    }
+    if (W_VLIST == -1) {
+	errno = ENFILE;
+	return 0;
+    }
+#endif
+
+    tmp = _nd_newObj(callback, W_VLIST, 0, prompt, prefix,
+				x, y, width, depth, help);
+    if (tmp == 0)
+	return 0;
+
+    if ((tmp->item.generic = calloc(1, sizeof *local)) == 0) {
+	deleteObj(tmp);
+	return 0;
+    }
+    local = VL(tmp);
+
+    if (tmp->prefix || tmp->suffix) {
+	/* tweak the selectable area so the user can click on
+	 * the scroll buttons
+	 */
+	tmp->sely --;
+	tmp->seldepth += 2;
+    }
+
+    switch (flags & LO_SELECTION_MASK) {
+    case HIGHLIGHT_SELECTED:local->kind = LO_HIGHLIT;
+			    local->itemoffset = 1;
+			    break;
+    case MENU_SELECTION:    local->kind = LO_MENU;
+			    local->itemoffset = 0;
+			    break;
+    default:		    local->kind = LO_CHECK;
+			    local->itemoffset = 4;
+			    break;
+    }
+    tmp->flags |= (flags & (NO_HOTKEYS|ALWAYS_HIGHLIT));
+
+    local->rows = *rows;
+    local->ctx = ctx;
+    local->nrrows = nrrows;
+    local->nrslots = depth + 2*VL_READAHEAD;
+    local->textwidth = (width > local->itemoffset)
+				? (width - local->itemoffset) : 1;
+
+    local->slot = calloc(local->nrslots, sizeof local->slot[0]);
+    local->text = malloc(local->nrslots * (local->textwidth+1));
+
+    if (local->slot == 0 || local->text == 0) {
+	deleteObj(tmp);
+	return 0;
+    }
+    for (ix = 0; ix < local->nrslots; ix++) {
+	local->slot[ix].row = -1;
+	local->slot[ix].text = local->text + ix * (local->textwidth+1);
+    }
+    return tmp;
+} /* newVirtualList */
+
+
+/*
+ * deleteVirtualList() throws away the row cache
+ */
+DYN_STATIC void
+deleteVirtualList(ndObject o)
+{
+    Vlist *local;
+
+    if (o == 0 || objType(o) != W_VLIST)
+	return;
+
+    if ((local = VL(o)) != 0) {
+	if (local->slot)
+	    free(local->slot);
+	if (local->text)
+	    free(local->text);
+	free(local);
+    }
+} /* deleteVirtualList */
+
+
+/*
+ * fetch() gets a row, from the cache if it's there, otherwise from the
+ * row provider.  It returns 0 if the row can't be had.
+ */
+static Vrow *
+fetch(Obj *obj, long row)
+{
+    Vlist *vl = VL(obj);
+    Vrow *v;
+    ListItem item;
+
+    if (row < 0 || row >= vl->nrrows)
+	return 0;
+
+    v = &vl->slot[row % vl->nrslots];
+    if (v->row == row)
+	return v;
+
+    memset(&item, 0, sizeof item);
+    if ((*vl->rows.fetch)(vl->ctx, row, &item) != 0) {
+	v->row = -1;
+	return 0;
+    }
+    v->row = row;
+    v->selected = item.selected;
+    if (item.item) {
+	strncpy(v->text, item.item, vl->textwidth);
+	v->text[vl->textwidth] = 0;
+    }
+    else
+	v->text[0] = 0;
+    return v;
+} /* fetch */
+
+
+/*
+ * drawRow() draws one row of a virtual list
+ */
+static void
+drawRow(Obj *obj, WINDOW *win, long row, int x, int y)
+{
+    Vlist *vl = VL(obj);
+    Vrow *v;
+    int active = (row == vl->cury) && IS_CURRENT(obj);
+    int color;
+
+    wmove(win, y, x);
+    setcolor(win, WINDOW_COLOR);
+    waddnstr(win, rillyrillylongblankstring, obj->width);
+
+    if ((v = fetch(obj, row)) == 0)
+	return;
+
+    wmove(win, y, x);
+    switch (vl->kind) {
+    case LO_CHECK:
+	waddch(win, '[');
+	if (active)
+	    setcolor(win, SELECTED_COLOR);
+	waddch(win, v->selected ? 'X' : ' ');
+	setcolor(win, WINDOW_COLOR);
+	waddch(win, ']');
+	color = WINDOW_COLOR;
+	break;
+    case LO_HIGHLIT:
+	if (active) {
+	    mvwaddch(win, y, x+obj->width-1, ACS_LARROW);
+	    mvwaddch(win, y, x, ACS_RARROW);
+	}
+	color = v->selected ? SELECTED_COLOR : WINDOW_COLOR;
+	break;
+    default:
+	if (row == vl->cury && (active || (obj->flags & ALWAYS_HIGHLIT)))
+	    color = SELECTED_COLOR | (active ? 0 : READONLY_COLOR);
+	else
+	    color = WINDOW_COLOR;
+	break;
+    }
+
+    setcolor(win, color);
+    wmove(win, y, x+vl->itemoffset);
+    waddnstr(win, v->text, obj->width - vl->itemoffset);
+    setcolor(win, WINDOW_COLOR);
+} /* drawRow */
+
+
+/*
+ * drawVirtualList() draws the visible rows, then makes sure the rows
+ * just outside the view are in the cache.
+ */
+DYN_STATIC void
+drawVirtualList(void *o, void *w)
+{
+    Obj *obj = OBJ(o);
+    Vlist *vl;
+    WINDOW *win = Window(w);
+    int x = WX(w),
+	y = WY(w);
+    int rc;
+    long row;
+
+    if (obj == 0 || objType(obj) != W_VLIST)
+	return;
+    vl = VL(obj);
+
+    rc = _nd_drawObjCommon(obj, w);
+    _nd_adjustXY(rc, obj, &x, &y);
+
+    if ((rc & DREW_A_BOX) && obj->width > 3) {
+	if (vl->topy > 0) {
+	    setcolor(win, WIDGET_COLOR);
+	    mvwaddstr(win, y-1, x+obj->width-3, "(-)");
+	}
+	if (vl->topy+obj->depth < vl->nrrows) {
+	    setcolor(win, WIDGET_COLOR);
+	    mvwaddstr(win, y+obj->depth, x+obj->width-3, "(+)");
+	}
+    }
+    setcolor(win, WINDOW_COLOR);
+
+    for (row = vl->topy; row - vl->topy < obj->depth; row++)
+	drawRow(obj, win, row, x, y + (row - vl->topy));
+
+    for (row = 1; row <= VL_READAHEAD; row++) {
+	fetch(obj, vl->topy - row);
+	fetch(obj, vl->topy + obj->depth - 1 + row);
+    }
+} /* drawVirtualList */
+
+
+/*
+ * toggle() selects or unselects the current row, or (for menus) picks it.
+ * Like list objects, a callback that returns 0 undoes the selection.
+ */
+static editCode
+toggle(Obj *obj, void *win)
+{
+    Vlist *vl = VL(obj);
+    Vrow *v;
+    int rc;
+
+    if ((v = fetch(obj, vl->cury)) == 0)
+	return eNOP;
+
+    if (vl->kind == LO_MENU) {
+	rc = _nd_callback(obj, win);
+	return (rc < 0) ? eEXITFORM : (rc > 0) ? eRETURN : eNOP;
+    }
+
+    v->selected = !v->selected;
+    (*vl->rows.select)(vl->ctx, vl->cury, v->selected);
+
+    if ((rc = _nd_callback(obj, win)) == 0) {
+	v->selected = !v->selected;
+	(*vl->rows.select)(vl->ctx, vl->cury, v->selected);
+    }
+    return (rc < 0) ? eEXITFORM : eNOP;
+} /* toggle */
+
+
+/*
+ * hotkey() finds the next row (wrapping around) that starts with c, or
+ * -1 if there isn't one.  If the provider can't find rows for us, we
+ * have to ask it for every row until we find one.
+ */
+static long
+hotkey(Obj *obj, int c)
+{
+    Vlist *vl = VL(obj);
+    ListItem item;
+    long row;
+
+    if (vl->nrrows < 2)
+	return -1;
+    if (vl->rows.find)
+	return (*vl->rows.find)(vl->ctx, vl->cury, c);
+
+    c = toupper(c);
+    for (row = (vl->cury+1) % vl->nrrows; row != vl->cury;
+					row = (row+1) % vl->nrrows) {
+	memset(&item, 0, sizeof item);
+	if ((*vl->rows.fetch)(vl->ctx, row, &item) == 0 && item.item
+			     && toupper((unsigned char)item.item[0]) == c)
+	    return row;
+    }
+    return -1;
+} /* hotkey */
+
+
+#define TOPY		(vl->topy)
+#define CURY		(vl->cury)
+#define NRITEMS		(vl->nrrows)
+#define WINY		(obj->depth)
+
+/*
+ * startVirtualList() gets ready to edit a virtual list, dealing with any
+ * mouse click that brought us here.
+ */
+DYN_STATIC editCode
+startVirtualList(void* o, void* win, MEVENT* ev, editCode cc)
+{
+    Obj *obj = OBJ(o);
+    Vlist *vl;
+    long yp;
+    editCode rc;
+
+    if (obj == 0 || objType(obj) != W_VLIST) {
+	errno = EINVAL;
+	return eERROR;
+    }
+    vl = VL(obj);
+
+    /* can't edit fields set readonly */
+    if (OBJ_READONLY(obj))
+	return eTAB;
+
+#if VERMIN
+    if (cc == eEVENT) {
+	yp = (ev->y - obj->dty);
+
+	if (yp < 0 && TOPY > 0) {
+	    /* scroll backwards */
+	    TOPY -= WINY;
+	    CURY -= WINY;
+	    if (TOPY < 0) {
+		CURY -= TOPY;
+		TOPY = 0;
+	    }
+	}
+	else if (yp >= WINY && TOPY + WINY < NRITEMS) {
+	    /* scroll forwards */
+	    TOPY += WINY;
+	    if (TOPY + WINY > NRITEMS)
+		TOPY = NRITEMS - WINY;
+	    CURY += WINY;
+	    if (CURY >= NRITEMS)
+		CURY = NRITEMS-1;
+	}
+	else if (yp >= 0 && TOPY + yp < NRITEMS) {
+	    CURY = TOPY + yp;
+
+	    if (vl->kind != LO_MENU
+			|| (ev->bstate & BUTTON1_DOUBLE_CLICKED)) {
+		rc = toggle(obj, win);
+		drawObj(obj, win);
+		if (rc == eEXITFORM || rc == eRETURN)
+		    return rc;
+	    }
+	}
+	drawObj(obj, win);
+    }
+#endif
+
+#if HAVE_CURS_SET
+    /* hide the cursor when doing a menu */
+    vl->cursor = curs_set(0);
+#endif
+    return eNOP;
+} /* startVirtualList */
+
+
+/*
+ * keyVirtualList() handles one keystroke for a virtual list
+ */
+DYN_STATIC editCode
+keyVirtualList(void* o, void* win, int c)
+{
+    Obj *obj = OBJ(o);
+    Vlist *vl = VL(obj);
+    long row;
+    int touch = 0;
+    editCode rc = eNOP;
+
+    switch (c) {
+    case EOF:		rc = eESCAPE;	goto bailout;
+    case KEY_F(1): _nd_help(objHelp(obj)); break;
+#if VERMIN
+    case KEY_MOUSE:	rc = eEVENT;	goto bailout;
+#endif
+    case 'R'-'@':	rc = eREFRESH;	goto bailout;
+    case ESCAPE:	rc = eESCAPE;	goto bailout;
+    case KEY_BTAB:
+    case KEY_LEFT:	rc = eBACKTAB;	goto bailout;
+    case KEY_RIGHT:
+    case '\t':		rc = eTAB;	goto bailout;
+
+    case KEY_HOME:
+	TOPY = CURY = 0;
+	touch++;
+	break;
+
+    case KEY_END:
+	CURY = NRITEMS ? NRITEMS-1 : 0;
+	TOPY = (NRITEMS > WINY) ? NRITEMS - WINY : 0;
+	touch++;
+	break;
+
+    case 'U'-'@':
+    case KEY_PPAGE:
+	TOPY -= WINY;
+	CURY -= WINY;
+	if (TOPY < 0) {
+	    CURY -= TOPY;
+	    TOPY = 0;
+	}
+	if (CURY < 0)
+	    CURY = 0;
+	touch++;
+	break;
+
+    case '-':
+    case KEY_UP:
+	if (CURY == 0)
+	    return eNOP;
+	CURY--;
+	if (CURY < TOPY)
+	    TOPY = CURY;
+	touch++;
+	break;
+
+    case 'D'-'@':
+    case KEY_NPAGE:
+	if (TOPY + WINY < NRITEMS) {
+	    TOPY += WINY;
+	    if (TOPY + WINY > NRITEMS)
+		TOPY = NRITEMS - WINY;
+	}
+	CURY += WINY;
+	if (CURY >= NRITEMS)
+	    CURY = NRITEMS ? NRITEMS-1 : 0;
+	touch++;
+	break;
+
+    case '+':
+    case KEY_DOWN:
+	if (CURY < NRITEMS-1) {
+	    CURY++;
+	    if (CURY >= TOPY+WINY)
+		TOPY++;
+	    touch++;
+	}
+	break;
+
+    case ' ':
+	if (vl->kind == LO_MENU)
+	    return eNOP;
+    case '\n':
+    case '\r':
+	rc = toggle(obj, win);
+	if (rc == eEXITFORM || rc == eRETURN)
+	    goto bailout;
+	touch++;
+	break;
+
+    default:
+	if ((obj->flags & NO_HOTKEYS) || c < 0 || c > 255 || !isprint(c))
+	    break;
+	if ((row = hotkey(obj, c)) >= 0 && row < NRITEMS) {
+	    CURY = row;
+	    if (CURY < TOPY)
+		TOPY = CURY;
+	    else if (CURY >= TOPY+WINY)
+		TOPY = (CURY-WINY)+1;
+	    touch++;
+	}
+	break;
+    }
+
+    if (touch) {
+	obj->flags |= OBJ_DIRTY;
+	drawObj(obj, win);
+    }
+    return eNOP;
+
+bailout:
+#if HAVE_CURS_SET
+    curs_set(vl->cursor);
+#endif
+    return rc;
+} /* keyVirtualList */
+
+
+/*
+ * editVirtualList() is the blocking edit function for virtual lists
+ */
+DYN_STATIC editCode
+editVirtualList(void* o, void* w, MEVENT *mev, editCode cc)
+{
+    return _nd_editKeys(o, w, mev, cc, (nd_start)startVirtualList,
+					 (nd_key)keyVirtualList);
+} /* editVirtualList */
+
+
+/*
+ * getVirtualCursor() and setVirtualCursor() are the getObjCursor() and
+ * setObjCursor() methods for virtual lists.
+ */
+DYN_STATIC int
+getVirtualCursor(void *o)
+{
+    return (int)VL(o)->cury;
+} /* getVirtualCursor */
+
+
+DYN_STATIC int
+setVirtualCursor(void *o, int row)
+{
+    return setVirtualListCursor(o, row);
+} /* setVirtualCursor */
+
+
+/*
+ * setVirtualListCursor() moves the current row, scrolling it into view
+ */
+int
+setVirtualListCursor(ndObject o, long row)
+{
+    Obj *obj = OBJ(o);
+    Vlist *vl;
+
+    if (o == 0 || objType(o) != W_VLIST || row < 0) {
+	errno = EINVAL;
+	return -1;
+    }
+    vl = VL(o);
+    if (row >= NRITEMS) {
+	errno = EINVAL;
+	return -1;
+    }
+    CURY = row;
+    if (CURY < TOPY)
+	TOPY = CURY;
+    else if (CURY >= TOPY+WINY)
+	TOPY = (CURY-WINY)+1;
+    touchObj(obj);
+    return 0;
+} /* setVirtualListCursor */
+
+
+/*
+ * virtualListCursor() tells which row is current
+ */
+long
+virtualListCursor(ndObject o)
+{
+    if (o == 0 || objType(o) != W_VLIST) {
+	errno = EINVAL;
+	return -1;
+    }
+    return VL(o)->cury;
+} /* virtualListCursor */
+
+
+/*
+ * flushVirtualList() empties the row cache, so that the rows will be
+ * asked for again the next time the list is drawn.  Call this if the
+ * rows have changed behind the list's back.
+ */
+int
+flushVirtualList(ndObject o)
+{
+    Vlist *vl;
+    int ix;
+
+    if (o == 0 || objType(o) != W_VLIST) {
+	errno = EINVAL;
+	return -1;
+    }
+    vl = VL(o);
+    for (ix = 0; ix < vl->nrslots; ix++)
+	vl->slot[ix].row = -1;
+    touchObj(o);
+    return 0;
+} /* flushVirtualList */
+
+
+/*
+ * setVirtualListRows() tells the list that the number of rows changed.
+ * The row cache is flushed, and the current row is pulled back into the
+ * list if it fell off the end.
+ */
+int
+setVirtualListRows(ndObject o, long nrrows)
+{
+    Obj *obj = OBJ(o);
+    Vlist *vl;
+
+    if (o == 0 || objType(o) != W_VLIST || nrrows < 0) {
+	errno = EINVAL;
+	return -1;
+    }
+    vl = VL(o);
+    NRITEMS = nrrows;
+    if (CURY >= NRITEMS)
+	CURY = NRITEMS ? NRITEMS-1 : 0;
+    if (TOPY + WINY > NRITEMS)
+	TOPY = (NRITEMS > WINY) ? NRITEMS - WINY : 0;
+    return flushVirtualList(o);
+} /* setVirtualListRows */
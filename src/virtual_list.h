@@ -0,0 +1,36 @@
+/*
+ * Copyright (C) 1996-2017 David L Parsons.
+ * The redistribution terms are provided in the COPYRIGHT file that must
+ * be distributed with this source code.
+ */
+#ifndef __VIRTUALLIST_D
+#define __VIRTUALLIST_D
+
+#include <ndialog.h>
+
+/* A virtual list doesn't hold its rows; it asks a row provider for the
+ * rows it needs to draw.
+ */
+typedef struct {
+    int (*fetch)(void *ctx, long row, ListItem *item);
+		/* fill in item->item and item->selected for a row;
+		 * return 0, or -1 if there's no such row (required) */
+    int (*select)(void *ctx, long row, int selected);
+		/* remember that a row was (un)selected (required,
+		 * except for menus) */
+    long (*find)(void *ctx, long from, int c);
+		/* find the next row after from that starts with the
+		 * hotkey c, or -1 (optional) */
+} ndRowProvider;
+
+ndObject newVirtualList(int x, int y, int width, int depth, long nrrows,
+			ndRowProvider *rows, void *ctx,
+			char *prompt, char *prefix, int flags,
+			pfo callback, char *help);
+
+int setVirtualListRows(ndObject obj, long nrrows);
+int flushVirtualList(ndObject obj);
+long virtualListCursor(ndObject obj);
+int setVirtualListCursor(ndObject obj, long row);
+
+#endif/*__VIRTUALLIST_D*/